@@ -0,0 +1,60 @@
+# Copyright (c) 2025 Thomas Groom
+#
+# Generates a C++ source file holding the given resource directories as constant byte arrays.
+# Run in script mode:
+#   cmake -DRESOURCE_ROOT=<dir> -DRESOURCE_DIRS=<dir,dir,...> -DOUTPUT=<file.cpp> -P EmbedResources.cmake
+# Resources are registered under their path relative to RESOURCE_ROOT, e.g. "shaders/Text.vert".
+# An empty RESOURCE_DIRS produces an empty table, which makes every lookup fall back to disk.
+
+string(REPLACE "," ";" RESOURCE_DIRS "${RESOURCE_DIRS}")
+
+set(files "")
+foreach(dir IN LISTS RESOURCE_DIRS)
+    file(GLOB_RECURSE dir_files LIST_DIRECTORIES false "${RESOURCE_ROOT}/${dir}/*")
+    list(APPEND files ${dir_files})
+endforeach()
+list(SORT files)
+
+set(arrays "")
+set(table "")
+set(index 0)
+foreach(file IN LISTS files)
+    file(RELATIVE_PATH name "${RESOURCE_ROOT}" "${file}")
+    file(READ "${file}" hex HEX)
+    string(LENGTH "${hex}" hex_length)
+    math(EXPR size "${hex_length} / 2")
+
+    # 16 bytes per line, then every byte pair as a hex literal.
+    string(REGEX REPLACE "(................................)" "\\1\n    " hex "${hex}")
+    string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," bytes "${hex}")
+
+    # A trailing zero keeps text resources usable as C strings; it is not counted in the size.
+    string(APPEND arrays "// ${name}\nalignas(16) const unsigned char kResource${index}[] = {\n    ${bytes}0x00\n};\n\n")
+    string(APPEND table "    { \"${name}\", kResource${index}, ${size} },\n")
+    math(EXPR index "${index} + 1")
+endforeach()
+
+if(index EQUAL 0)
+    set(table "    { nullptr, nullptr, 0 },\n")
+endif()
+
+set(content "// Generated by cmake/EmbedResources.cmake. Do not edit.
+
+#include \"ui_library/Resources.h\"
+
+
+namespace {
+
+${arrays}}
+
+
+const EmbeddedResource gEmbeddedResources[] = {
+${table}};
+
+const size_t gEmbeddedResourceCount = ${index};
+")
+
+# Only touch the output when it changes, so unchanged resources do not trigger a rebuild.
+file(WRITE "${OUTPUT}.tmp" "${content}")
+file(COPY_FILE "${OUTPUT}.tmp" "${OUTPUT}" ONLY_IF_DIFFERENT)
+file(REMOVE "${OUTPUT}.tmp")
@@ -0,0 +1,117 @@
+// Copyright (c) 2025 Thomas Groom
+
+#pragma once
+
+#include <glad/glad.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "ui_library/Config.h"
+#include "Utils.h"
+#include "Shader.h"
+#include "VAO.h"
+#include "VBO.h"
+
+
+// An animated sprite whose frames are decoded lazily on a worker thread.
+//
+// Frames come either from an animated GIF or from an ordered list of image files. The worker
+// decodes at most a couple of frames ahead of what has been uploaded, and uploaded frames live
+// in a GL_TEXTURE_2D_ARRAY used as a ring of `residentFrames` layers, so neither RAM nor VRAM
+// grows with the length of the animation.
+//
+// Playback is driven by the caller's frame clock through Update(), which returns true only on
+// frames where the displayed image changed. NextFrameTime() tells the caller when to redraw next.
+// Update and DrawSprite run on the UI thread; the frames are uploaded and drawn by the GL work
+// that DrawSprite defers (see DrawList::Defer).
+class AnimatedTexture2D
+{
+public:
+    // Animated GIF. Frame delays are taken from the file.
+    AnimatedTexture2D(const std::filesystem::path& gifFile, int residentFrames = 8);
+    // Image sequence played with a fixed interval (in seconds) between frames.
+    AnimatedTexture2D(const std::vector<std::filesystem::path>& frameFiles, double frameInterval, int residentFrames = 8);
+    ~AnimatedTexture2D();
+
+    AnimatedTexture2D(const AnimatedTexture2D&) = delete;
+    AnimatedTexture2D& operator=(const AnimatedTexture2D&) = delete;
+
+    // Takes in decoded frames and advances playback to `time` (seconds, e.g. glfwGetTime()).
+    // Returns true if the displayed frame changed.
+    bool Update(double time);
+    // Time at which the displayed frame is due to change, or a negative value if it never will.
+    double NextFrameTime() const;
+
+    void DrawSprite(glm::vec2 position, glm::vec2 desiredSize, float z = 0.0f, glm::vec3 color = glm::vec3(1.0f));
+
+    void Play() { mPlaying = true; mClockStarted = false; }
+    void Pause() { mPlaying = false; }
+    void SetLooping(bool loop) { mLooping.store(loop); }
+    bool IsPlaying() const { return mPlaying; }
+
+    glm::vec2 mFitSize = glm::vec2(20.0f, 20.0f);
+
+private:
+    struct Frame {
+        long long sequence;
+        int width;
+        int height;
+        double delay;   // Seconds this frame stays on screen.
+        std::vector<unsigned char> pixels;
+    };
+
+    struct Layer {
+        long long sequence = -1;
+        double delay = 0.0;
+    };
+
+    void Init();
+    void InitGL();
+    void DecodeGif();
+    void DecodeSequence();
+    bool PushFrame(Frame&& frame);
+    void AcceptFrames();
+    void CreateArray(int width, int height);
+    void UploadFrames(const std::vector<Frame>& frames);
+    void DrawLayer(const std::vector<Frame>& uploads, glm::vec2 position, glm::vec2 size, float z, glm::vec3 color, int layer);
+
+    // Source.
+    std::filesystem::path mGifFile;
+    std::vector<std::filesystem::path> mFrameFiles;
+    double mFrameInterval = 0.1;
+    int mResidentFrames;
+
+    // Worker -> UI thread hand-off. The worker blocks once mPending holds kMaxPending frames.
+    static constexpr size_t kMaxPending = 2;
+    std::thread mWorker;
+    mutable std::mutex mQueueMutex;
+    std::condition_variable mQueueCondVar;
+    std::deque<Frame> mPending;
+    bool mStop = false;
+    bool mDecodeFinished = false;
+    std::atomic<bool> mLooping{true};
+
+    // Ring of frames and playback (UI thread only).
+    int mWidth = 0;                 // Of the first frame; every layer has this size.
+    int mHeight = 0;
+    std::vector<Layer> mLayers;
+    std::vector<Frame> mStaged;     // Accepted into the ring, not yet handed to a draw.
+    long long mAccepted = -1;       // Highest sequence number accepted into the ring.
+    long long mDisplayed = -1;      // Sequence number currently shown.
+    double mFrameDeadline = 0.0;    // Clock time at which mDisplayed should be replaced.
+    bool mPlaying = true;
+    bool mClockStarted = false;
+
+    // GL thread only.
+    GLuint mArrayID = 0;
+    Shader mShader;
+    VAO mVAO;
+    VBO mVBO;
+    bool mGLReady = false;
+};
@@ -29,11 +29,14 @@
 
 #include "ui_library/Config.h"
 #include "Utils.h"
+#include "FramePacer.h"
+#include "JobSystem.h"
+#include "RenderThread.h"
 
 
 class Application {
 public:
-    Application() : dragAndDropCursorImage({15, 25, G_DRAG_CURSOR_BITMAP}){
+    Application() : dragAndDropCursorImage({15, 25, G_DRAG_CURSOR_BITMAP}), mRenderThread(mFramePacer) {
         mUIContext = new UI();
     }
 
@@ -54,8 +57,18 @@ public:
         int minHeight = 200;
         int samples = 4;         // Anti-Aliasing (MSAA) samples
         bool vsyncEnabled = true;
+        bool adaptiveVsync = false;      // With vsync, tear rather than stall on a late frame (if supported)
+        double targetFps = 0.0;          // Frame rate cap, 0 for none
+        bool lowLatency = false;         // Poll input just before layout and wait for the GPU after each present
+        bool gpuPicking = false;         // Pixel-exact hit testing for handlers with SetPixelPick (see PickBuffer)
         bool maximizeWindow = true;
+        bool redrawOnDemand = false;     // Sleep until input, a timer or UI::Invalidate instead of rendering every iteration
+        bool partialRedraw = false;      // Redraw only what changed into a persistent offscreen buffer (see DamageTracker)
+        bool renderThread = false;       // Record frames for a render thread that owns the GL context (see RenderThread)
+        double commandBudget = 0.004;    // Seconds per frame spent running CommandQueue posts from other threads
         std::string title = "Application";
+        bool printStartupTrace = false;   // Print a per-phase start-up breakdown after the first frame
+        std::string startupTraceFile;     // If set, also write it as a Chrome trace JSON file
     };
 
     void handleMouseButton(GLFWwindow* window, int button, int action, int mods);
@@ -63,6 +76,7 @@ public:
     void handleScroll(GLFWwindow* window, double xoffset, double yoffset);
     void handleCharacter(GLFWwindow* window, unsigned int codepoint);
     void handleFramebufferSize(GLFWwindow* window, int width, int height);
+    void handleCursorPos(GLFWwindow* window, double x, double y);
 
     virtual void onInit() {}
     virtual void onUpdate() {}
@@ -75,11 +89,24 @@ public:
     void SetRunning(bool _isRunning) {
         running = _isRunning;
     }
+
+    // Frame pacing can be changed at runtime, e.g. from a settings panel.
+    void SetVsync(FramePacer::Vsync mode) { mFramePacer.SetVsync(mode); }
+    void SetTargetFps(double fps) { mFramePacer.SetTargetFps(fps); }
+    void SetLowLatency(bool enabled) { mFramePacer.SetLowLatency(enabled); }
+    FramePacer::Stats GetFrameStats() const { return mFramePacer.GetStats(); }
+    FramePacer& GetFramePacer() { return mFramePacer; }
+    // Worker pool shared by the library and the application (also JobSystem::Current()).
+    JobSystem& GetJobSystem() { return mJobs; }
     
     UI* mUIContext;
 
 
 private:
+    void waitForRedraw();
+    void drawFrame();
+    void presentFrame();
+
     bool running = true;
 	glm::vec2 previousMousePos = glm::vec2(0.0f, 0.0f);
     
@@ -88,5 +115,12 @@ private:
     GLFWimage dragAndDropCursorImage;
     GLFWcursor* mCursorLUT[5] = {};
 
+    FramePacer mFramePacer;
+    JobSystem mJobs;
+    RenderThread mRenderThread;
+    DrawList mFrameList;             // This frame's commands, when partial redraw runs on this thread.
+    int mCursorMode = GLFW_CURSOR_NORMAL;
+    bool mRawMouseMotion = false;
+
 };
     
@@ -0,0 +1,53 @@
+// Copyright (c) 2025 Thomas Groom
+
+#pragma once
+
+#include <glad/glad.h>
+#include <vector>
+
+#include "DrawList.h"
+
+
+// Persistent offscreen colour buffer for partial redraw (WindowSettings::partialRedraw).
+//
+// The window's back buffer is undefined after a swap, so a frame drawn straight into it must
+// be drawn whole. This buffer keeps its contents from frame to frame instead: only the damaged
+// rectangles (see DamageTracker) are cleared and redrawn, with every scissor limited to them
+// and commands outside them skipped, and the result is then blitted to the window. The blit
+// also resolves MSAA, so the window itself is created without samples. Deferred commands run
+// exactly once a frame: rectangles one of them reaches are merged, and those reached by none
+// still run under an empty scissor.
+//
+// GL thread only.
+class BackBuffer
+{
+public:
+    static BackBuffer& getInstance() {
+        static BackBuffer instance;
+        return instance;
+    }
+
+    // MSAA samples of the offscreen buffer; applies when it is next (re)created.
+    void SetSamples(int samples) { mSamples = samples < 0 ? 0 : samples; }
+
+    // Redraws `damage` of `frame` into the buffer (all of it if the buffer was just created or
+    // resized), then copies the buffer to the default framebuffer. ComputeFootprints must
+    // have run on `frame` for commands outside the damage to be skipped.
+    void Draw(const DrawList& frame, std::vector<DrawList::Rect> damage, int width, int height);
+
+private:
+    BackBuffer() {}
+    ~BackBuffer() {}   // Outlives the GL context; its objects are released with the context.
+    BackBuffer(const BackBuffer&) = delete;
+    BackBuffer& operator=(const BackBuffer&) = delete;
+
+    // Returns true if the buffer was (re)created, leaving its contents undefined.
+    bool EnsureTarget(int width, int height);
+
+    int mSamples = 0;
+    int mCreatedSamples = 0;
+    int mWidth = 0;
+    int mHeight = 0;
+    GLuint mFBO = 0;
+    GLuint mColour = 0;
+};
@@ -13,6 +13,7 @@
 #include "Utils.h"
 #include "Text.h"
 #include "Texture.h"
+#include "VectorIcon.h"
 
 
 class Button : public MouseHandler
@@ -24,10 +25,11 @@ class Button : public MouseHandler
 			Colour _Colour = BUTTON_COLOUR, Colour _HColour = BUTTON_HOVER_COLOUR, Colour _DColour = BUTTON_DISABLED_COLOUR,
 			Colour _DHColour = BUTTON_DISABLED_HOVER_COLOUR);
 		~Button() {};
-		void MouseCallback(int _mouseState) override;
+		void OnMouseEvent(const MouseEvent& event) override;
 		//virtual void Register();
 		virtual void Draw();
 		Button& setIcon(std::shared_ptr<Texture2D> texture, int iconX = 5, int iconY = 0, int iconW = 20, int iconH = 20);
+		Button& setIcon(std::shared_ptr<VectorIcon> icon, int iconX = 5, int iconY = 0, int iconW = 20, int iconH = 20);
 		Button& setIconPos(int iconX = 5, int iconY = 0, int iconW = 20, int iconH = 20) {
 			mIconX = iconX;
 			mIconY = iconY;
@@ -73,7 +75,7 @@ class Button : public MouseHandler
 		int mTextHeight = -1;
 		std::shared_ptr<Text> mTextRenderer;
 	private:
-		bool mInContainer = false;
+		bool mClicked = false;  // Set by OnMouseEvent, shown as state 4 by the next Draw.
 		bool isBold = false;
 		int btnState = 0;
 		std::function<void()> onClickCallback;
@@ -87,5 +89,6 @@ class Button : public MouseHandler
 
 		Primitive rectPrim;
 		std::shared_ptr<Texture2D> mIconTexture;
+		std::shared_ptr<VectorIcon> mVectorIcon;
 };
 
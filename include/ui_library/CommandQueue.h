@@ -0,0 +1,95 @@
+// Copyright (c) 2025 Thomas Groom
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <utility>
+
+
+// Queue of commands posted from any thread and run on the UI (GL) thread.
+//
+// UI, the widgets and the variables bound to them (InputField::SetVar) may only be touched
+// from the thread running Application::run. Worker threads post a closure here instead; the
+// loop drains the queue at the start of each frame, before input is granted and widgets are
+// drawn, so a command sees the same state a widget callback would.
+//
+// Posting is lock-free (multiple producers, one consumer) and wakes a loop that is waiting
+// for events. Draining stops once the frame's budget is spent; the rest run next frame.
+class CommandQueue
+{
+public:
+    using Command = std::function<void()>;
+
+    static CommandQueue& getInstance() {
+        static CommandQueue instance;
+        return instance;
+    }
+
+    // Thread-safe. Commands from one thread run in the order they were posted.
+    void Post(Command command);
+
+    // UI thread only. Runs queued commands until the queue is empty or `budgetSeconds` have
+    // passed (at least one command always runs). Returns true if commands may remain.
+    bool Drain(double budgetSeconds);
+
+private:
+    struct Node {
+        std::atomic<Node*> next{ nullptr };
+        Command command;
+    };
+
+    CommandQueue() : mHead(&mStub), mTail(&mStub) {}
+    ~CommandQueue();
+    CommandQueue(const CommandQueue&) = delete;
+    CommandQueue& operator=(const CommandQueue&) = delete;
+
+    void Push(Node* node);
+    Node* Pop();
+
+    // Intrusive list with a stub node: producers exchange mHead, the consumer follows mTail.
+    std::atomic<Node*> mHead;
+    Node* mTail;
+    Node mStub;
+};
+
+
+// Latest value of a stream of results, applied on the UI thread at most once per drain.
+//
+// For producers that report faster than the UI can show (progress, live statistics): each
+// Post replaces the pending value, and only one command is queued until it has run, so the
+// queue never grows with the post rate. Values superseded before the UI thread ran are dropped.
+template <typename T>
+class LatestValue
+{
+public:
+    explicit LatestValue(std::function<void(const T&)> apply)
+        : mState(std::make_shared<State>()) {
+        mState->apply = std::move(apply);
+    }
+
+    // Thread-safe.
+    void Post(T value) {
+        std::atomic_store(&mState->value, std::make_shared<const T>(std::move(value)));
+        if (!mState->pending.exchange(true)) {
+            // The command holds the state, so it stays valid if this object is destroyed first.
+            std::shared_ptr<State> state = mState;
+            CommandQueue::getInstance().Post([state] {
+                state->pending = false;
+                std::shared_ptr<const T> latest = std::atomic_exchange(&state->value, std::shared_ptr<const T>());
+                if (latest) state->apply(*latest);
+            });
+        }
+    }
+
+private:
+    struct State {
+        std::function<void(const T&)> apply;
+        std::shared_ptr<const T> value;
+        std::atomic<bool> pending{ false };
+    };
+
+    std::shared_ptr<State> mState;
+};
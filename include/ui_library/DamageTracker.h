@@ -0,0 +1,67 @@
+// Copyright (c) 2025 Thomas Groom
+
+#pragma once
+
+#include <mutex>
+#include <vector>
+
+#include "DrawList.h"
+
+
+// Works out which parts of the window changed since the last frame, for partial redraw (see
+// BackBuffer and WindowSettings::partialRedraw).
+//
+// Most damage is found automatically: each frame is recorded into a DrawList, and the
+// footprints of its meshes, sprites and glyphs are compared with the previous frame's. Any that
+// appeared, moved or changed damage their bounds, old and new. A hover change damages one
+// button, a caret blink one character cell. Deferred commands are compared by the bounds and
+// key they were given (see DrawList::Defer); without them they draw something unknown and
+// damage their whole scissor every frame.
+//
+// Anything drawn outside the recorded list, or changed without its commands changing, is
+// reported with Add / AddAll, from any thread.
+class DamageTracker
+{
+public:
+    static DamageTracker& getInstance() {
+        static DamageTracker instance;
+        return instance;
+    }
+
+    void SetEnabled(bool enabled) { mEnabled = enabled; }
+    bool IsEnabled() const { return mEnabled; }
+
+    // More rectangles than this are merged into their bounding box.
+    void SetMaxRects(int maxRects) { mMaxRects = maxRects < 1 ? 1 : maxRects; }
+
+    // Thread-safe. Damages a window rectangle (pixels, top-left origin) in the next frame.
+    void Add(const DrawList::Rect& rect);
+    void Add(int x, int y, int width, int height) { Add(DrawList::Rect{ x, y, width, height }); }
+    // Thread-safe. Redraws the whole window next frame.
+    void AddAll();
+
+    // UI thread, once per frame. Diffs `frame` against the previous frame and returns the
+    // merged rectangles to redraw, clipped to the target; empty if nothing changed. The whole
+    // target is returned on the first frame and after a resize.
+    std::vector<DrawList::Rect> Collect(DrawList& frame, int width, int height);
+
+private:
+    DamageTracker() {}
+    ~DamageTracker() {}
+    DamageTracker(const DamageTracker&) = delete;
+    DamageTracker& operator=(const DamageTracker&) = delete;
+
+    std::vector<DrawList::Rect> Merge(std::vector<DrawList::Rect> rects, const DrawList::Rect& target) const;
+
+    bool mEnabled = false;
+    int mMaxRects = 8;
+
+    std::mutex mMutex;                       // Guards the two members below.
+    std::vector<DrawList::Rect> mPending;
+    bool mFull = true;
+
+    std::vector<DrawList::Footprint> mPrevious;
+    std::vector<DrawList::Footprint> mCurrent;
+    int mWidth = 0;
+    int mHeight = 0;
+};
@@ -0,0 +1,236 @@
+// Copyright (c) 2025 Thomas Groom
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+
+
+class LayerSurface;
+class MouseHandler;
+class Text;
+class Texture2D;
+
+
+// Recorded draw commands, so a widget tree can be drawn on a thread that does not own the GL
+// context and submitted later by the one that does.
+//
+// While a list is recording on the calling thread (see Recording), Primitive, Text and
+// Texture2D append commands here instead of calling GL, and MouseHandler::SetDrawn is
+// deferred to submission so the hit-test store is only written from the GL thread. Other
+// GL work goes through Defer. With no list recording every call draws immediately, as before.
+//
+// The commands only hold geometry and shared references to the objects that own the GL
+// resources (fonts, textures), which thereby outlive the submission. An object not owned by a
+// shared_ptr is referenced without being kept alive; the list then reports MustWait.
+class DrawList
+{
+public:
+    // Window pixels, top-left origin, as the widgets lay out.
+    struct Rect {
+        int x = 0;
+        int y = 0;
+        int width = 0;
+        int height = 0;
+
+        bool Empty() const { return width <= 0 || height <= 0; }
+        long long Area() const { return Empty() ? 0 : static_cast<long long>(width) * height; }
+        bool Intersects(const Rect& other) const {
+            return x < other.x + other.width && other.x < x + width && y < other.y + other.height && other.y < y + height;
+        }
+        Rect Intersect(const Rect& other) const;
+        Rect Union(const Rect& other) const;
+        // The whole pixels that a box at `position` of `size` touches.
+        static Rect Covering(glm::vec2 position, glm::vec2 size);
+    };
+
+    // What one recorded command draws, for finding what changed between two frames.
+    struct Footprint {
+        std::uint64_t hash;
+        Rect bounds;
+    };
+
+    // FNV-1a, enough to tell one frame's commands from the next. Also builds Defer keys.
+    class Hasher {
+    public:
+        template <typename T>
+        Hasher& Add(const T& value) { return AddBytes(&value, sizeof(T)); }
+        Hasher& AddBytes(const void* data, std::size_t size) {
+            const unsigned char* bytes = static_cast<const unsigned char*>(data);
+            for (std::size_t i = 0; i < size; i++) {
+                mHash = (mHash ^ bytes[i]) * 1099511628211ull;
+            }
+            return *this;
+        }
+        std::uint64_t Value() const { return mHash; }
+
+    private:
+        std::uint64_t mHash = 14695981039346656037ull;
+    };
+
+    // Triangles with 7 floats per vertex (x, y, z, r, g, b, a).
+    struct Mesh {
+        std::vector<float> verts;
+        std::vector<unsigned int> inds;
+        std::uint32_t pickId = 0;   // Also drawn into the PickBuffer when non-zero.
+    };
+
+    // Laid-out text: 18 vertices of 9 floats per glyph (selection, glyph and caret quads).
+    // Glyph textures are looked up from `font` when submitted, so the font may still be
+    // uploading its glyphs while the run is recorded.
+    struct GlyphRun {
+        std::shared_ptr<Text> font;
+        std::vector<char> glyphs;
+        std::vector<float> verts;
+        glm::vec3 colour = glm::vec3(1.0f);
+    };
+
+    struct Sprite {
+        std::shared_ptr<Texture2D> texture;
+        glm::vec2 position = glm::vec2(0.0f);
+        glm::vec2 size = glm::vec2(0.0f);
+        float z = 0.0f;
+        float rotate = 0.0f;
+        glm::vec3 colour = glm::vec3(1.0f);
+    };
+
+    // A cached recording drawn through an offscreen texture (see LayerCache). `content`, which
+    // covers `area`, is rendered into `surface` only when the surface holds an older `version`.
+    // Window pixels in `view` show the recorded pixels `scroll` rows further down.
+    struct Layer {
+        std::shared_ptr<LayerSurface> surface;
+        std::shared_ptr<const DrawList> content;
+        std::uint64_t version = 0;
+        Rect area;
+        Rect view;
+        int scroll = 0;
+    };
+
+    // Sets the calling thread's current list for its lifetime, restoring the previous one.
+    class Recording {
+    public:
+        explicit Recording(DrawList* list);
+        ~Recording();
+        Recording(const Recording&) = delete;
+        Recording& operator=(const Recording&) = delete;
+
+    private:
+        DrawList* mPrevious;
+    };
+
+    // The list recording on the calling thread, or nullptr when drawing immediately.
+    static DrawList* Current();
+
+    // Scissor in GL window coordinates (bottom-left origin), nested. Pushing with no box
+    // draws unclipped until the matching pop. Recorded or applied, depending on Current().
+    static void PushScissor(int x, int y, int width, int height);
+    static void PushScissor();
+    static void PopScissor();
+    // Runs `command` now, or at submission if a list is recording. For GL work that has no
+    // command of its own.
+    static void Defer(std::function<void()> command);
+    // As above, for a command that only draws inside `bounds` (window pixels) and draws the
+    // same as long as `key` does not change. It is then footprinted like a sprite, so an
+    // unchanged one damages nothing and is not redrawn (though it still runs, see BackBuffer).
+    static void Defer(std::function<void()> command, const Rect& bounds, std::uint64_t key);
+    // As above, for a command that only uses what it captured by value and GL objects it keeps
+    // alive, never the widget that recorded it. The UI need not wait for it to run.
+    static void DeferGL(std::function<void()> command, const Rect& bounds, std::uint64_t key);
+
+    // Framebuffer size that submitted commands project to. The render thread sets it from
+    // each frame packet, since GLFW only reports the size on the main thread; with nothing
+    // set it is read from the window.
+    static void SetTargetSize(int width, int height);
+    static void GetTargetSize(int& width, int& height);
+
+    void AddMesh(Mesh mesh);
+    void AddGlyphs(GlyphRun run);
+    void AddSprite(const Sprite& sprite);
+    void AddCommand(std::function<void()> command);
+    void AddCommand(std::function<void()> command, const Rect& bounds, std::uint64_t key, bool touchesWidgets);
+    void AddLayer(Layer layer);
+    void MarkDrawn(MouseHandler* handler);
+
+    // Copies the commands of `other` onto the end of this list.
+    void Append(const DrawList& other);
+    // Applies the deferred MouseHandler::SetDrawn calls now, on the calling thread, and drops
+    // them from the list. Used when the list is submitted on another thread.
+    void FlushDrawn();
+    // Drops the deferred MouseHandler::SetDrawn calls from the list and returns their handlers.
+    std::vector<MouseHandler*> TakeDrawn();
+
+    void Clear();
+    bool Empty() const { return mCommands.empty(); }
+    // True if Defer or AddCommand was used.
+    bool HasFunctions() const { return !mFunctions.empty(); }
+    // True if submitting may touch the widgets or objects that the list does not keep alive,
+    // so the recording thread must wait for it before changing or destroying them.
+    bool MustWait() const { return mMustWait; }
+
+    // Appends a footprint for every mesh, sprite, glyph and layer, clipped to its scissor, and keeps
+    // each command's bounds for Submit(clip). Deferred commands given bounds and a key are
+    // footprinted by those; what the others draw is unknown, so they cover their whole scissor
+    // (or the target) and never match between frames.
+    void ComputeFootprints(int targetWidth, int targetHeight, std::vector<Footprint>& footprints);
+    // The bounds of each deferred command, in order, once ComputeFootprints has run. Returns
+    // false if it has not.
+    bool DeferredBounds(std::vector<Rect>& bounds) const;
+
+    // GL thread only. Executes the commands in the order they were recorded. If another list
+    // is recording on the calling thread they are appended to it instead.
+    void Submit() const;
+    // GL thread only. As Submit, but every scissor is limited to `clip` and, once
+    // ComputeFootprints has run, commands entirely outside it are skipped.
+    void Submit(const Rect& clip) const;
+    // GL thread only. After Submit(clip) for each of `clips`, runs the deferred commands that
+    // none of them reached, under an empty scissor, so that each has run once this frame.
+    void SubmitUnreached(const std::vector<Rect>& clips) const;
+    // Submits `lists` in the given order.
+    static void Submit(const std::vector<const DrawList*>& lists);
+    // GL thread only. Submits into a bound framebuffer that holds just `area` of the target,
+    // at its bottom-left corner: scissors are moved by the area's offset and no outer clip
+    // applies. The caller sets a viewport of the target's size offset the same way.
+    void SubmitToLayer(const Rect& area) const;
+    // GL thread only. As Submit(), for a caller that has moved the viewport by (x, y) GL
+    // pixels: scissors move with it.
+    void SubmitOffset(int x, int y) const;
+
+private:
+    enum class Kind : std::uint8_t { MESH, GLYPHS, SPRITE, LAYER, PUSH_SCISSOR, POP_SCISSOR, COMMAND, DRAWN };
+
+    struct Entry {
+        Kind kind;
+        std::uint32_t index;   // Into the vector for its kind.
+    };
+
+    struct Scissor {
+        int x, y, width, height;
+        bool enabled;
+    };
+
+    struct Function {
+        std::function<void()> command;
+        Rect bounds;
+        std::uint64_t key = 0;
+        bool bounded = false;
+        bool touchesWidgets = true;
+    };
+
+    void Push(Kind kind, std::size_t index) { mCommands.push_back({ kind, static_cast<std::uint32_t>(index) }); }
+    void SubmitClipped(const Rect* clip) const;
+    void SubmitWithOrigin(int originX, int originY, bool clipped) const;
+
+    std::vector<Entry> mCommands;
+    std::vector<Mesh> mMeshes;
+    std::vector<GlyphRun> mGlyphRuns;
+    std::vector<Sprite> mSprites;
+    std::vector<Layer> mLayers;
+    std::vector<Scissor> mScissors;
+    std::vector<Function> mFunctions;
+    std::vector<MouseHandler*> mDrawn;
+    std::vector<Rect> mBounds;   // Per command, from ComputeFootprints.
+    bool mMustWait = false;
+};
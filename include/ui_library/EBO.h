@@ -8,9 +8,9 @@
 class EBO
 {
 public:
-	// ID reference of Elements Buffer Object
-	GLuint ID;
-	// Constructor that generates a Elements Buffer Object and links it to indices
+	// ID reference of Elements Buffer Object (0 until first use)
+	GLuint ID = 0;
+	// Constructor. The buffer ID is generated lazily on first use
 	EBO();//GLuint* indices, GLsizeiptr size);
 	// Set new data in the EBO
 	void Data(const std::vector<GLuint>& indices);
@@ -21,7 +21,5 @@ public:
 	// Unbinds the EBO
 	void Unbind();
 	// Deletes the EBO
-	~EBO() {
-		glDeleteBuffers(1, &ID);
-	}
+	~EBO();
 };
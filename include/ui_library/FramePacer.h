@@ -0,0 +1,86 @@
+// Copyright (c) 2025 Thomas Groom
+
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+
+// Controls when frames start and how they are presented, and measures the result.
+//
+// - Vsync: off, on, or adaptive (tears instead of stalling when a frame misses the refresh,
+//   if the driver supports EXT_swap_control_tear; otherwise behaves as on).
+// - Target frame rate: BeginFrame sleeps until the next frame slot. The OS sleep is used for
+//   the bulk of the wait and the last couple of milliseconds are spun, since sleeps routinely
+//   overshoot by more than that.
+// - Low latency: the application polls input after BeginFrame rather than after presenting,
+//   so input is read as late as possible before layout, and Present waits for the GPU to
+//   finish so frames do not queue up behind the swap.
+//
+// All times are in seconds from glfwGetTime().
+//
+// With a RenderThread, BeginFrame and MarkInput are called on the UI thread and Present on the
+// render thread; the statistics are shared under a lock.
+class FramePacer
+{
+public:
+    enum class Vsync { Off, On, Adaptive };
+
+    struct Stats {
+        double frameTime = 0.0;          // Present to present.
+        double cpuTime = 0.0;            // BeginFrame to the start of Present.
+        double presentTime = 0.0;        // Time spent in the swap (and the GPU wait in low latency mode).
+        double inputToPresent = 0.0;     // Oldest input handled by the last frame that had input, to present.
+        double averageFrameTime = 0.0;   // Exponential moving averages.
+        double averageInputToPresent = 0.0;
+        double maxFrameTime = 0.0;       // Since the last ResetStats.
+        std::uint64_t frameCount = 0;
+    };
+
+    // Applies immediately if a GL context is current, otherwise on the next Apply() or Present().
+    void SetVsync(Vsync mode);
+    Vsync GetVsync() const { return mVsync; }
+    // True if adaptive vsync was requested and the driver supports it.
+    bool IsAdaptiveVsyncActive() const { return mAdaptiveActive; }
+    // Sets the swap interval for the current context.
+    void Apply();
+
+    // 0 (the default) disables the limiter.
+    void SetTargetFps(double fps);
+    double GetTargetFps() const { return mTargetFps; }
+
+    void SetLowLatency(bool enabled) { mLowLatency = enabled; }
+    bool IsLowLatency() const { return mLowLatency; }
+
+    // Waits for the next frame slot and marks the start of the frame.
+    void BeginFrame();
+    double GetFrameStart() const { return mFrameStart; }
+    // Records that input arrived; the earliest time since the last present is kept.
+    void MarkInput(double time);
+    // Swaps the buffers of `window` and updates the statistics.
+    void Present(GLFWwindow* window);
+    // As above, for a frame that began at `frameStart` (which may not be the latest BeginFrame).
+    void Present(GLFWwindow* window, double frameStart);
+
+    Stats GetStats() const;
+    void ResetStats();
+
+private:
+    static void SleepUntil(double time);
+
+    std::atomic<Vsync> mVsync{ Vsync::On };
+    std::atomic<bool> mApplyPending{ false };
+    bool mAdaptiveActive = false;
+    double mTargetFps = 0.0;
+    bool mLowLatency = false;
+
+    double mFrameStart = 0.0;
+    double mNextFrameStart = 0.0;
+    mutable std::mutex mStatsMutex;   // Guards the members below.
+    double mLastPresent = -1.0;
+    double mPendingInput = -1.0;
+    Stats mStats;
+};
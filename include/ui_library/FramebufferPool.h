@@ -0,0 +1,54 @@
+// Copyright (c) 2025 Thomas Groom
+
+#pragma once
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <vector>
+
+
+// Offscreen colour targets (RGBA8 texture + framebuffer) for layer caches, shared by size.
+//
+// Sizes are rounded up to buckets of kBucket pixels, so a layer that grows or shrinks a little
+// during a live resize keeps its target, and one that changes bucket gets a released one back
+// instead of a fresh allocation. At most kMaxFree released targets are kept; the oldest are
+// deleted beyond that.
+//
+// GL thread only.
+class FramebufferPool
+{
+public:
+    static constexpr int kBucket = 128;
+    static constexpr std::size_t kMaxFree = 8;
+
+    struct Target {
+        GLuint fbo = 0;
+        GLuint texture = 0;
+        int width = 0;    // Bucket size, at least what was asked for.
+        int height = 0;
+
+        bool Valid() const { return fbo != 0; }
+    };
+
+    static FramebufferPool& getInstance() {
+        static FramebufferPool instance;
+        return instance;
+    }
+
+    static int BucketSize(int size) { return size <= 0 ? kBucket : (size + kBucket - 1) / kBucket * kBucket; }
+
+    // A target of at least width x height with undefined contents.
+    Target Acquire(int width, int height);
+    // Hands a target back for reuse. Invalid targets are ignored.
+    void Release(const Target& target);
+
+private:
+    FramebufferPool() {}
+    ~FramebufferPool() {}   // Outlives the GL context; its objects are released with the context.
+    FramebufferPool(const FramebufferPool&) = delete;
+    FramebufferPool& operator=(const FramebufferPool&) = delete;
+
+    static void Delete(const Target& target);
+
+    std::vector<Target> mFree;   // Oldest first.
+};
@@ -0,0 +1,37 @@
+// Copyright (c) 2025 Thomas Groom
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+
+// Decodes an animated GIF one frame at a time.
+// stbi_load_gif_from_memory decodes every frame up front; this keeps only the frames the
+// GIF disposal rules need (the current and the two previous composited frames).
+class GifStream
+{
+public:
+    // The encoded data is copied, so the caller's buffer may be released afterwards.
+    GifStream(const unsigned char* data, int size);
+    ~GifStream();
+
+    GifStream(const GifStream&) = delete;
+    GifStream& operator=(const GifStream&) = delete;
+
+    // Decodes the next frame as RGBA8. Returns false at the end of the stream or on error.
+    // The frame stays valid until the next call to Next() or Rewind().
+    bool Next(const unsigned char*& rgba, int& width, int& height, int& delayMs);
+
+    // Restarts decoding from the first frame.
+    void Rewind();
+
+    bool IsValid() const { return mValid; }
+
+private:
+    struct State;
+
+    std::vector<unsigned char> mData;
+    std::unique_ptr<State> mState;
+    bool mValid = false;
+};
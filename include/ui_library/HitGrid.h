@@ -0,0 +1,50 @@
+// Copyright (c) 2025 Thomas Groom
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+
+class WidgetStore;
+
+
+// Uniform grid over the window used to find the mouse handlers under a point without testing
+// every handler. Built from the rows of the WidgetStore of handlers drawn in a frame, keyed by
+// their bounds, and rebuilt only when those rows or the window size change.
+//
+// Cells are stored in a compressed layout: mCellStart[c] .. mCellStart[c + 1] index the
+// rows overlapping cell c in mEntries, so a build is two linear passes over the bounds
+// columns and no per-cell allocations. Rows and points outside the window are clamped to the
+// edge cells, so Query returns the same rows as testing each one directly.
+class HitGrid
+{
+public:
+    // Rows that are no longer alive (handlers destroyed after being drawn) are skipped, as are
+    // rows without every bit of `flags`. With `margins` (one per row of `store`) each row's
+    // bounds are grown by its margin on every side.
+    void Build(const WidgetStore& store, int width, int height, std::uint32_t flags = 0, const std::vector<int>* margins = nullptr);
+    // Appends the indexed rows of `store` whose (grown) bounds contain (x, y), in row (draw)
+    // order. `store` must hold the same bounds as when the grid was built.
+    void Query(const WidgetStore& store, int x, int y, std::vector<std::uint32_t>& out) const;
+
+    // Side of a square cell in pixels.
+    int mCellSize = 64;
+
+private:
+    struct CellRange {
+        int x0, y0, x1, y1;
+    };
+
+    CellRange CellsFor(const WidgetStore& store, std::uint32_t row) const;
+    int Margin(std::uint32_t row) const { return mMargins.empty() ? 0 : mMargins[row]; }
+    int CellX(int x) const;
+    int CellY(int y) const;
+
+    int mCols = 0;
+    int mRows = 0;
+    std::vector<std::uint32_t> mCellStart;
+    std::vector<std::uint32_t> mEntries;
+    std::vector<std::uint32_t> mCursor;   // Scratch fill positions, kept to avoid reallocating.
+    std::vector<int> mMargins;            // Per row, or empty for none.
+};
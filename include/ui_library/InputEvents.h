@@ -0,0 +1,123 @@
+// Copyright (c) 2025 Thomas Groom
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+
+// A single input event as delivered by GLFW, stamped with glfwGetTime() at arrival.
+struct InputEvent {
+    enum Type : std::uint8_t { KEY, CHAR, MOUSE_BUTTON, MOUSE_MOVE, SCROLL, RESIZE };
+
+    Type type;
+    double time;
+
+    // KEY: GLFW key, scancode, action (press/release/repeat) and modifier bits.
+    // MOUSE_BUTTON: button in `key`, action and mods.
+    int key = 0;
+    int scancode = 0;
+    int action = 0;
+    int mods = 0;
+    // CHAR: full Unicode codepoint.
+    char32_t codepoint = 0;
+    // MOUSE_MOVE: cursor position. SCROLL: offsets. RESIZE: framebuffer size.
+    double x = 0.0;
+    double y = 0.0;
+
+    bool IsKeyDown(int glfwKey) const;   // Press or repeat of the given key.
+};
+
+
+// Growable ring buffer of the input events for one frame, in arrival order.
+//
+// Application pushes from the GLFW callbacks and clears the queue after each frame, so every
+// frame sees exactly the events that arrived since the previous one. The buffer grows rather
+// than overwriting, so nothing is dropped however long a frame takes.
+class InputQueue
+{
+public:
+    class Iterator
+    {
+    public:
+        Iterator(const InputQueue* queue, std::size_t index) : mQueue(queue), mIndex(index) {}
+        const InputEvent& operator*() const { return (*mQueue)[mIndex]; }
+        const InputEvent* operator->() const { return &(*mQueue)[mIndex]; }
+        Iterator& operator++() { ++mIndex; return *this; }
+        bool operator!=(const Iterator& other) const { return mIndex != other.mIndex; }
+        bool operator==(const Iterator& other) const { return mIndex == other.mIndex; }
+
+    private:
+        const InputQueue* mQueue;
+        std::size_t mIndex;
+    };
+
+    explicit InputQueue(std::size_t initialCapacity = 256);
+
+    void Push(const InputEvent& event);
+    void Clear();
+
+    std::size_t Size() const { return mCount; }
+    bool Empty() const { return mCount == 0; }
+    const InputEvent& operator[](std::size_t i) const { return mBuffer[(mHead + i) & (mBuffer.size() - 1)]; }
+
+    Iterator begin() const { return Iterator(this, 0); }
+    Iterator end() const { return Iterator(this, mCount); }
+
+private:
+    void Grow();
+
+    std::vector<InputEvent> mBuffer;   // Capacity is always a power of two.
+    std::size_t mHead = 0;
+    std::size_t mCount = 0;
+};
+
+
+// Timestamped cursor positions from the cursor-position callback, so drags and flicks can be
+// measured from every motion sample rather than one glfwGetCursorPos per frame.
+//
+// The frame accumulators are reset by Application after each frame; a short window of recent
+// samples is kept across frames for velocity. With GLFW_RAW_MOUSE_MOTION enabled (see
+// UI::G_RAW_MOUSE_MOTION) the samples are unaccelerated and unclamped by the screen edge.
+class MouseHistory
+{
+public:
+    struct Sample {
+        double time;
+        glm::dvec2 position;
+    };
+
+    void Add(double time, double x, double y);
+    void EndFrame();
+    // Forgets the previous position, so the next sample contributes no delta (e.g. after a
+    // cursor mode change makes positions jump).
+    void Reset();
+
+    // Sum of all motion since the previous frame, including sub-pixel motion.
+    glm::dvec2 FrameDelta() const { return mFrameDelta; }
+    int FrameSampleCount() const { return mFrameSamples; }
+    // Average velocity in pixels per second over the samples in [now - window, now].
+    // Zero if the cursor has not moved within the window.
+    glm::dvec2 Velocity(double now, double window = 0.05) const;
+
+    std::size_t Size() const { return mCount; }
+    // i = 0 is the oldest kept sample.
+    const Sample& operator[](std::size_t i) const { return mSamples[(mHead + i) % kCapacity]; }
+
+private:
+    static constexpr std::size_t kCapacity = 64;
+
+    Sample mSamples[kCapacity] = {};
+    std::size_t mHead = 0;
+    std::size_t mCount = 0;
+    bool mHasPrevious = false;
+    glm::dvec2 mFrameDelta = glm::dvec2(0.0);
+    int mFrameSamples = 0;
+};
+
+
+// Appends a codepoint to a wide string, as a surrogate pair where wchar_t is 16 bits.
+void AppendCodepoint(std::wstring& text, char32_t codepoint);
@@ -19,6 +19,7 @@
 #include "Button.h"
 #include "DropdownButton.h"
 #include "ScrollBar.h"
+#include "ScrollView.h"
 
 
 
@@ -239,11 +240,13 @@ public:
                       .SetColour(HEADER_COLOUR)
                       .Draw();
 
-            // Draw the scrollbar.
-            mScroll.Draw(Boundary(inputContainer.x + 30, inputContainer.y,
-                                  inputContainer.width - 30, inputContainer.height),
+            // Draw the scrollbar and the list buttons, which the scroll view clips and caches.
+            Boundary listContainer(inputContainer.x + 30, inputContainer.y,
+                                   inputContainer.width - 30, inputContainer.height);
+            mScroll.Draw(listContainer,
                          static_cast<int>(mListBtns.size() * (mFieldHeight + mYGap) + 10),
-                         FIELD_COLOUR);
+                         [this, listContainer](int offset) { drawListButtons(listContainer, offset); },
+                         FIELD_COLOUR, listVersion());
 
             // Set button states and draw the add and remove buttons.
             mAddDropdownButton.setState(
@@ -258,22 +261,6 @@ public:
                          .SetZ(mZ + 0.05f)
                          .Draw();
 
-            // Set the scissor region.
-            glScissor(inputContainer.x + 30, mUI->G_HEIGHT - (inputContainer.y + inputContainer.height),
-                      inputContainer.width - 30, inputContainer.height);
-
-            // Draw each list button.
-            for (size_t i = 0; i < mListBtns.size(); ++i) {
-                std::shared_ptr<T> option = mListBtns[i].first;
-                mListBtns[i].second->setText(StringToWString(option->name));
-                mListBtns[i].second->SetPos(inputContainer.x + 30 + 5,
-                                            inputContainer.y + static_cast<int>(((mFieldHeight + mYGap) * i) + 5 - mScroll.scrollOffset),
-                                            inputContainer.width - 10 - 30, mFieldHeight)
-                           .SetZ(mZ + 0.04f)
-                           .setColour(static_cast<int>(i) == mCurrentSelectedIndex ? FIELD_HOVER_COLOUR : BUTTON_COLOUR)
-                           .Draw();
-            }
-
             if (mType == DROPDOWN_ADD) {
                 updateDropdownButtons();
             } else {
@@ -290,18 +277,8 @@ public:
 
             mScroll.Draw(container,
                          static_cast<int>(mListBtns.size() * (mFieldHeight + mYGap) + 10),
-                         FIELD_COLOUR);
-
-            for (size_t i = 0; i < mListBtns.size(); ++i) {
-                std::shared_ptr<T> option = mListBtns[i].first;
-                mListBtns[i].second->setText(StringToWString(option->name));
-                mListBtns[i].second->SetPos(container.x + 5,
-                                            container.y + static_cast<int>(((mFieldHeight + mYGap) * i) + 5 - mScroll.scrollOffset),
-                                            container.width - 10, mFieldHeight)
-                           .SetZ(mZ + 0.04f)
-                           .setColour(static_cast<int>(i) == mCurrentSelectedIndex ? FIELD_HOVER_COLOUR : BUTTON_COLOUR)
-                           .Draw();
-            }
+                         [this, container](int offset) { drawListButtons(container, offset); },
+                         FIELD_COLOUR, listVersion());
         }
     }
 
@@ -318,6 +295,29 @@ private:
         mCurrentSelectedIndex = static_cast<int>(index);
     }
 
+    // Draws the list buttons inside `listContainer`, scrolled down by `offset` pixels.
+    void drawListButtons(const Boundary& listContainer, int offset) {
+        for (size_t i = 0; i < mListBtns.size(); ++i) {
+            std::shared_ptr<T> option = mListBtns[i].first;
+            mListBtns[i].second->setText(StringToWString(option->name));
+            mListBtns[i].second->SetPos(listContainer.x + 5,
+                                        listContainer.y + static_cast<int>(((mFieldHeight + mYGap) * i) + 5 - offset),
+                                        listContainer.width - 10, mFieldHeight)
+                       .SetZ(mZ + 0.04f)
+                       .setColour(static_cast<int>(i) == mCurrentSelectedIndex ? FIELD_HOVER_COLOUR : BUTTON_COLOUR)
+                       .Draw();
+        }
+    }
+
+    // Changes whenever the list buttons would draw differently, so the scroll view redraws.
+    std::uint64_t listVersion() const {
+        std::uint64_t version = static_cast<std::uint64_t>(mCurrentSelectedIndex + 1);
+        for (const auto& entry : mListBtns) {
+            version = (version * 1099511628211ull) ^ std::hash<std::wstring>()(StringToWString(entry.first->name));
+        }
+        return version;
+    }
+
     // Shared text resource.
     std::shared_ptr<Text> UIText = std::make_shared<Text>(G_ResourcePath + "/fonts/arial.ttf", 12);
 
@@ -337,7 +337,7 @@ private:
     DropdownButton mAddDropdownButton = DropdownButton(mUI, UIText, L"", Text::CENTER_MIDDLE, Boundary(0, 0, 20, 20), 5, mZ + 0.05f);
     Button mRemoveButton = Button(mUI, UIText, L"", Text::CENTER_MIDDLE, Boundary(0, 0, 20, 20), 5, mZ + 0.05f);
     Primitive mPrimitive;
-    Scrollbar mScroll = Scrollbar(mUI); // TODO: What is preffered, initialising it here or in the constructor after the : I.E. : mScroll(mUI), ...
+    ScrollView mScroll = ScrollView(mUI); // TODO: What is preffered, initialising it here or in the constructor after the : I.E. : mScroll(mUI), ...
 
     // External data references.
     std::vector<std::shared_ptr<T>> mList;
@@ -433,6 +433,15 @@ public:
     InputField& checkboxIcons(std::shared_ptr<Texture2D> _checkboxIconTrue, std::shared_ptr<Texture2D> _checkboxIconFalse) {
         mCheckboxIconTrue = _checkboxIconTrue;
         mCheckboxIconFalse = _checkboxIconFalse;
+        mCheckboxVectorIconTrue.reset();
+        mCheckboxVectorIconFalse.reset();
+        return *this;
+    }
+    InputField& checkboxIcons(std::shared_ptr<VectorIcon> _checkboxIconTrue, std::shared_ptr<VectorIcon> _checkboxIconFalse) {
+        mCheckboxVectorIconTrue = _checkboxIconTrue;
+        mCheckboxVectorIconFalse = _checkboxIconFalse;
+        mCheckboxIconTrue.reset();
+        mCheckboxIconFalse.reset();
         return *this;
     }
 
@@ -454,6 +463,8 @@ public:
     InputField& setMax(std::variant<double, int> max);
 
     InputField& setRatio(double _ratio) { mRatio = _ratio; return *this; };
+    // Numeric drag hides the cursor and uses raw (unaccelerated) motion where supported.
+    InputField& setRawScrub(bool _rawScrub) { mRawScrub = _rawScrub; return *this; };
 
     using VarType = std::variant<std::reference_wrapper<double>, 
                                  std::reference_wrapper<int>, 
@@ -470,6 +481,7 @@ public:
 
 
     void MouseCallback(int _mouseState) override;
+    bool HasFocus() const override { return mTextField && mTextField->isActive; }
     void Draw(int x, int y, int width, int height, std::optional<float> z = std::nullopt);
 
     void SetPos(int x, int y, int width, int height, std::optional<float> z = std::nullopt);
@@ -549,6 +561,8 @@ private:
     bool mBoolValue = false;
     double mDoubleValue = 0.0;
     int mIntValue = 0;
+    bool mRawScrub = false;
+    double mDragRemainder = 0.0;   // Sub-step drag motion not yet applied to the value
     std::string mTextValue;
     std::string mUnits;
     Text::Align mLabelAlign;
@@ -564,6 +578,8 @@ private:
     bool mShowCheckbox = true;
     std::shared_ptr<Texture2D> mCheckboxIconTrue = nullptr;
     std::shared_ptr<Texture2D> mCheckboxIconFalse = nullptr;
+    std::shared_ptr<VectorIcon> mCheckboxVectorIconTrue = nullptr;
+    std::shared_ptr<VectorIcon> mCheckboxVectorIconFalse = nullptr;
     bool mMouseInBounds = false;
     int mOptionsStartOffset = 0;  // E.G. Allows the options to start at 1 rather than 0
     bool mDialogOpen = false;
@@ -0,0 +1,111 @@
+// Copyright (c) 2025 Thomas Groom
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// Shared pool of worker threads for short CPU jobs: image decoding, font rasterisation, text
+// layout for many labels, workspace layout.
+//
+// Each worker has its own deque. Jobs scheduled from a worker go on the back of its deque and
+// are taken back LIFO (the data is still warm in its cache); idle workers steal from the
+// front of the others' deques, so large batches spread out on their own. Jobs scheduled from
+// other threads go on a shared queue that all workers take from.
+//
+// Jobs can depend on other jobs, forming a task graph: a job is queued only once all of its
+// dependencies have finished. Wait helps run queued jobs rather than blocking, so the UI
+// thread can wait on its own work without idling a core.
+//
+// Jobs must not touch GL or the widgets; results reach the UI through CommandQueue, or
+// through data read after Wait / SyncFrame on the UI thread.
+class JobSystem
+{
+    struct Task;
+
+public:
+    using Job = std::function<void()>;
+
+    // Refers to a scheduled job. Default-constructed handles are invalid and count as done.
+    class Handle {
+    public:
+        Handle() = default;
+        bool IsValid() const { return mTask != nullptr; }
+        bool Done() const;
+
+    private:
+        friend class JobSystem;
+        explicit Handle(std::shared_ptr<Task> task) : mTask(std::move(task)) {}
+        std::shared_ptr<Task> mTask;
+    };
+
+    // 0 workers means one per hardware thread, less one for the UI thread.
+    explicit JobSystem(unsigned workerCount = 0);
+    // Runs every job already queued, then stops the workers.
+    ~JobSystem();
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // The first JobSystem constructed (the Application's), or nullptr if there is none.
+    static JobSystem* Current();
+
+    // Thread-safe. The job runs once all `dependencies` are done.
+    Handle Schedule(Job job, const std::vector<Handle>& dependencies = {});
+    // As Schedule, and SyncFrame waits for it: for work that must be finished before the
+    // frame it was started for (or the next) is drawn.
+    Handle ScheduleForFrame(Job job, const std::vector<Handle>& dependencies = {});
+
+    // Returns once the job is done, running other queued jobs meanwhile.
+    void Wait(const Handle& handle);
+    // Waits for every job scheduled with ScheduleForFrame so far. Application calls it on the
+    // UI thread after input and before onUpdate draws.
+    void SyncFrame();
+
+    // Calls body(begin, end) over [0, count) in chunks of about `grain` items, spread across
+    // the workers and the calling thread, and returns when all chunks are done.
+    void ParallelFor(std::size_t count, std::size_t grain, const std::function<void(std::size_t, std::size_t)>& body);
+
+    unsigned WorkerCount() const { return static_cast<unsigned>(mWorkers.size()); }
+
+private:
+    struct Task {
+        Job job;
+        std::atomic<int> pending{ 1 };   // Unfinished dependencies, plus one until scheduling ends.
+        std::atomic<bool> done{ false };
+        std::mutex mutex;                // Guards `dependents` against `done` being set.
+        std::vector<std::shared_ptr<Task>> dependents;
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::shared_ptr<Task>> tasks;
+    };
+
+    void Enqueue(std::shared_ptr<Task> task);
+    std::shared_ptr<Task> Take(int workerIndex);
+    bool RunOne(int workerIndex);
+    void Complete(const std::shared_ptr<Task>& task);
+    void WorkerMain(int index);
+    // Index of the calling thread's worker in this system, or -1.
+    int CallerIndex() const;
+
+    std::vector<std::unique_ptr<Queue>> mQueues;   // One per worker.
+    Queue mShared;                                 // Jobs scheduled from outside the pool.
+    std::vector<std::thread> mWorkers;
+
+    std::atomic<int> mQueued{ 0 };
+    std::mutex mSleepMutex;
+    std::condition_variable mWake;
+    bool mStopping = false;
+
+    std::mutex mFrameMutex;
+    std::vector<Handle> mFrameJobs;
+};
@@ -0,0 +1,101 @@
+// Copyright (c) 2025 Thomas Groom
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "DrawList.h"
+#include "FramebufferPool.h"
+#include "Utils.h"
+
+
+// GL side of a LayerCache: a pooled target and the version of the recording it holds. Shared
+// with the frame lists that composite it, so a layer can go away while a render thread still
+// draws its last frame.
+class LayerSurface
+{
+public:
+    LayerSurface() {}
+    ~LayerSurface();   // Returns the target to the FramebufferPool, on the GL thread.
+    LayerSurface(const LayerSurface&) = delete;
+    LayerSurface& operator=(const LayerSurface&) = delete;
+
+    // GL thread. Renders the layer's content into the target if it holds another version or
+    // the size changed bucket, then draws its view as one textured quad.
+    void Composite(const DrawList::Layer& layer);
+
+private:
+    void Render(const DrawList& content, const DrawList::Rect& area);
+
+    FramebufferPool::Target mTarget;
+    std::uint64_t mVersion = 0;   // 0: nothing rendered yet.
+};
+
+
+// Keeps what a static subtree draws in an offscreen texture and composites it as one quad, so
+// an unchanged panel costs neither its Draw() calls nor their draw calls.
+//
+// The subtree is drawn again (and re-rendered on the GL thread) only when:
+//  - Invalidate was called,
+//  - the area moved or changed size,
+//  - `version` changed (e.g. the revision of a model the subtree shows), or
+//  - a widget in it gained or lost hover or near state, or was hovered while a mouse button
+//    changed, since its look may depend on that, or
+//  - a widget in it is held down (e.g. a dragged scrollbar thumb) or has keyboard focus (an
+//    InputField being edited); the layer is then redrawn every frame until it lets go.
+// Anything else the subtree shows that changes on its own (animations, text carets) must call
+// Invalidate, or the layer shows the old frame.
+//
+// The widgets' MouseHandlers are kept drawn every frame, so they still receive input. With GPU
+// picking, the recording is replayed into the pick pass (not the window) while the cursor is
+// over the layer.
+//
+// UI thread, or the thread recording the leaf it belongs to.
+class LayerCache
+{
+public:
+    LayerCache();
+    ~LayerCache() {}
+    LayerCache(const LayerCache&) = delete;
+    LayerCache& operator=(const LayerCache&) = delete;
+
+    void Invalidate() { mDirty = true; }
+
+    // Draws the layer over `area` (window pixels), calling `draw` first if the cache is stale.
+    void Draw(const DrawList::Rect& area, std::uint64_t version, const std::function<void()>& draw);
+    // As above, but only `view` is shown, with what was recorded `scroll` rows lower; the
+    // widgets' hit boxes move up with it. Changing `scroll` alone does not redraw. Used by
+    // ScrollView.
+    void Draw(const DrawList::Rect& area, const DrawList::Rect& view, int scroll, std::uint64_t version, const std::function<void()>& draw);
+
+    // The steps of Draw, for callers that decide themselves when to redraw (see
+    // WorkspaceComponent::UpdatePolicy).
+    // True if the last recording was made for exactly `area`.
+    bool HasRecording(const DrawList::Rect& area) const;
+    // True if Draw would call `draw`.
+    bool IsStale(const DrawList::Rect& area, std::uint64_t version) const;
+    // True while one of the cached widgets is held down or has keyboard focus.
+    bool IsCapturing() const;
+    // Calls `draw` and keeps what it recorded for `area`.
+    void Record(const DrawList::Rect& area, std::uint64_t version, const std::function<void()>& draw);
+    // Shows the last recording where it was recorded, however stale; nothing if there is none.
+    void Present(const DrawList::Rect& view, int scroll);
+    void Present() { Present(mArea, 0); }
+
+private:
+    // Hover, near and pressed state of the cached widgets, packed per handler.
+    std::vector<std::uint8_t> HandlerStates() const;
+
+    std::shared_ptr<LayerSurface> mSurface;
+    std::shared_ptr<DrawList> mContent;
+    std::vector<MouseHandler::Handle> mHandlers;
+    std::vector<int> mHandlerY;     // Each handler's mContainer.y as recorded.
+    std::vector<std::uint8_t> mHandlerStates;
+    DrawList::Rect mArea;
+    std::uint64_t mVersion = 0;
+    std::uint64_t mRecording = 0;   // Bumped each time `draw` runs; what the surface is keyed on.
+    bool mDirty = true;
+};
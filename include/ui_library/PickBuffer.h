@@ -0,0 +1,118 @@
+// Copyright (c) 2025 Thomas Groom
+
+#pragma once
+
+#include <glad/glad.h>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "ui_library/Config.h"
+#include "Shader.h"
+#include "DrawList.h"
+
+
+// Optional GPU picking pass for pixel-exact hit testing of non-rectangular widgets.
+//
+// Each frame the widgets that opt in draw their geometry a second time into an integer
+// (GL_R32UI) render target, writing their pick ID instead of a colour. Drawing is restricted
+// by scissor to a small square around the cursor, so the pass costs a handful of fragments.
+// At the end of the frame the square is copied into a pixel buffer object and fenced; the
+// next frame maps it only once the fence has signalled, so reading the ID never stalls on the
+// GPU. The result is therefore one frame old.
+//
+// IDs are MouseHandler pick IDs (0 means nothing). Later draws overwrite earlier ones, so the
+// picked ID is the widget visibly on top.
+class PickBuffer
+{
+public:
+    static PickBuffer& getInstance() {
+        static PickBuffer instance;
+        return instance;
+    }
+
+    void SetEnabled(bool enabled) { mEnabled = enabled; }
+    bool IsEnabled() const { return mEnabled; }
+    // True between BeginFrame and EndFrame while enabled, unless suspended.
+    bool IsActive() const { return mActive && !mSuspended; }
+    // Stops draws from reaching the pick pass, for drawing somewhere other than the window
+    // (an offscreen layer), where pick coordinates would not match.
+    void SetSuspended(bool suspended) { mSuspended = suspended; }
+    // The square drawn into this frame, in window pixels (top-left origin). Partial redraw
+    // must submit it even when nothing there changed.
+    DrawList::Rect Region() const { return { mRegionX, mHeight - mRegionY - mRegionH, mRegionW, mRegionH }; }
+
+    // Half-size of the square around the cursor, in pixels. A larger radius lets thin shapes
+    // (wires, outlines) be picked when the cursor is near rather than exactly on them.
+    void SetRadius(int radius) { mRadius = radius < 0 ? 0 : radius; }
+
+    // Cursor position in window pixels (top-left origin) and framebuffer size.
+    void BeginFrame(int cursorX, int cursorY, int width, int height);
+    void EndFrame();
+    // Collects any finished readback. Call once per frame before the result is used.
+    void Poll();
+
+    // Redirects drawing into the pick target with the pick shader bound and `id` set. The
+    // caller then issues its draw call with its own VAO bound, where attribute 0 holds the
+    // vertex position (xyz), and calls EndPick to restore the previous target and program.
+    void BeginPick(std::uint32_t id, const glm::mat4& mvp);
+    void EndPick();
+
+    // ID under the cursor from the most recent completed readback, or 0.
+    std::uint32_t PickedId() const { return mPickedId; }
+    // True once at least one readback has completed since picking was enabled.
+    bool HasResult() const { return mHasResult; }
+
+private:
+    PickBuffer() {}
+    ~PickBuffer() {}   // Outlives the GL context; its objects are released with the context.
+    PickBuffer(const PickBuffer&) = delete;
+    PickBuffer& operator=(const PickBuffer&) = delete;
+
+    struct Readback {
+        GLuint pbo = 0;
+        GLsync fence = nullptr;
+        int width = 0;
+        int height = 0;
+        int centerX = 0;   // Cursor position within the region.
+        int centerY = 0;
+    };
+
+    void EnsureTarget(int width, int height);
+    std::uint32_t Resolve(const std::uint32_t* pixels, const Readback& readback) const;
+
+    bool mEnabled = false;
+    bool mActive = false;
+    bool mSuspended = false;
+    int mRadius = 2;
+
+    GLuint mFBO = 0;
+    GLuint mTexture = 0;
+    int mWidth = 0;
+    int mHeight = 0;
+    Shader mShader;
+    GLint mIdLocation = -1;
+    GLint mMVPLocation = -1;
+
+    // Region of this frame's pass, in GL (bottom-left origin) coordinates.
+    int mRegionX = 0;
+    int mRegionY = 0;
+    int mRegionW = 0;
+    int mRegionH = 0;
+    int mCenterX = 0;
+    int mCenterY = 0;
+
+    Readback mReadbacks[2];
+    int mWriteIndex = 0;
+
+    // State saved by BeginPick.
+    GLint mSavedFBO = 0;
+    GLint mSavedProgram = 0;
+    GLint mSavedScissor[4] = {};
+    GLboolean mSavedColourMask[4] = {};
+
+    // Written by whichever thread draws (see RenderThread), read by the UI thread.
+    std::atomic<std::uint32_t> mPickedId{ 0 };
+    std::atomic<bool> mHasResult{ false };
+};
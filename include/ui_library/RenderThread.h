@@ -0,0 +1,102 @@
+// Copyright (c) 2025 Thomas Groom
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "DrawList.h"
+
+
+class FramePacer;
+struct GLFWwindow;
+
+
+// Pipelined rendering: the UI thread records frame N+1 while this thread, which owns the GL
+// context, submits frame N and swaps. The swap (and any driver stall behind it) then no longer
+// holds up input handling and layout.
+//
+// Frames are handed over as FramePackets, of which there are three: one being recorded, one
+// queued and one being drawn. BeginPacket blocks if the render thread is two frames behind, so
+// the UI cannot run further ahead than that.
+//
+// A packet is immutable once submitted and keeps the fonts and textures it draws alive, with
+// two exceptions: commands added with DrawList::Defer (but not DeferGL) may read or change the
+// widget that recorded them, and a font or texture not owned by a shared_ptr is only
+// referenced. SubmitPacket waits until such a packet has been drawn (but not swapped) before
+// the UI thread continues (see DrawList::MustWait).
+//
+// While the render thread runs, the UI thread has no GL context. GL objects released on the UI
+// thread go through RunOnGLThread, and run after everything already recorded has been drawn.
+class RenderThread
+{
+public:
+    struct FramePacket {
+        DrawList drawList;
+        int width = 0;          // Framebuffer size the frame was laid out for.
+        int height = 0;
+        int cursorX = 0;        // Window pixels, for the PickBuffer pass.
+        int cursorY = 0;
+        double frameStart = 0.0;
+        bool partial = false;                  // Redraw only `damage` through the BackBuffer.
+        std::vector<DrawList::Rect> damage;
+        std::vector<std::function<void()>> glWork;   // From RunOnGLThread; run after drawing.
+    };
+
+    explicit RenderThread(FramePacer& pacer);
+    // Stops the thread if it is still running.
+    ~RenderThread();
+    RenderThread(const RenderThread&) = delete;
+    RenderThread& operator=(const RenderThread&) = delete;
+
+    // Moves `window`'s context from the calling thread to the render thread.
+    void Start(GLFWwindow* window);
+    // Draws and presents every submitted packet, then makes the context current on the
+    // calling thread again.
+    void Stop();
+    bool IsRunning() const { return mThread.joinable(); }
+
+    // UI thread. Returns a cleared packet to record into, waiting for one to come free.
+    FramePacket& BeginPacket();
+    // UI thread. Queues the packet from BeginPacket for drawing and presenting.
+    void SubmitPacket();
+    // UI thread. Waits until every submitted packet has been presented.
+    void Flush();
+
+    // True on the render thread while it runs.
+    static bool IsRenderThread();
+    // Runs `work` now if the calling thread may use GL, otherwise queues it for the render
+    // thread after the next submitted packet.
+    static void RunOnGLThread(std::function<void()> work);
+
+private:
+    static constexpr int kPacketCount = 3;
+
+    void Main();
+
+    FramePacer& mPacer;
+    GLFWwindow* mWindow = nullptr;
+    std::thread mThread;
+
+    FramePacket mPackets[kPacketCount];
+    std::mutex mMutex;
+    std::condition_variable mCondVar;
+    std::deque<int> mFree;       // Packets ready to record into.
+    std::deque<int> mQueued;     // Submitted, oldest first.
+    int mRecording = -1;
+    std::uint64_t mSubmitted = 0;
+    std::uint64_t mDrawn = 0;
+    std::uint64_t mPresented = 0;
+    bool mStopping = false;
+
+    std::mutex mWorkMutex;
+    std::vector<std::function<void()>> mPendingWork;   // RunOnGLThread calls since the last submit.
+
+    int mViewportWidth = 0;
+    int mViewportHeight = 0;
+};
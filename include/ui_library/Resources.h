@@ -0,0 +1,71 @@
+// Copyright (c) 2025 Thomas Groom
+
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+
+// One file compiled into the library by cmake/EmbedResources.cmake.
+struct EmbeddedResource {
+    const char* name;              // Path relative to the resources directory, e.g. "shaders/Text.vert".
+    const unsigned char* data;     // Followed by a terminating zero that is not counted in size.
+    size_t size;
+};
+
+extern const EmbeddedResource gEmbeddedResources[];
+extern const size_t gEmbeddedResourceCount;
+
+
+// The contents of a resource. Embedded resources are referenced in place; files read from
+// disk are owned by the Resource.
+class Resource
+{
+public:
+    Resource() = default;
+    Resource(Resource&&) = default;
+    Resource& operator=(Resource&&) = default;
+    Resource(const Resource&) = delete;
+    Resource& operator=(const Resource&) = delete;
+
+    const unsigned char* Data() const { return mData; }
+    size_t Size() const { return mSize; }
+    std::string String() const { return std::string(reinterpret_cast<const char*>(mData), mSize); }
+    bool IsValid() const { return mData != nullptr; }
+    explicit operator bool() const { return IsValid(); }
+
+private:
+    friend class Resources;
+
+    const unsigned char* mData = nullptr;
+    size_t mSize = 0;
+    std::vector<unsigned char> mStorage;
+};
+
+
+// Virtual filesystem over the library's shaders, fonts and icons.
+//
+// Resources are named by their path relative to the resources directory ("fonts/arial.ttf").
+// Paths inside UI_LIBRARY_RESOURCES_DIR are accepted too and mapped to the same name, so
+// existing callers keep working. A relative path is only taken as a name if such a resource
+// exists; otherwise it is a file relative to the working directory. A name is looked up in
+// this order:
+//   1. the override directory, if one is set (for iterating on shaders without rebuilding),
+//   2. the data embedded in the library (when built with UI_LIBRARY_EMBED_RESOURCES),
+//   3. UI_LIBRARY_RESOURCES_DIR on disk.
+// Any other path is simply read from disk.
+class Resources
+{
+public:
+    static Resource Load(const std::filesystem::path& path);
+    static bool IsEmbedded(const std::filesystem::path& path);
+
+    static void SetOverrideDirectory(const std::filesystem::path& directory);
+
+private:
+    static std::string Name(const std::filesystem::path& path);
+    static const EmbeddedResource* FindEmbedded(const std::string& name);
+    static Resource ReadFile(const std::filesystem::path& file);
+};
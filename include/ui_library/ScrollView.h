@@ -0,0 +1,43 @@
+// Copyright (c) 2025 Thomas Groom
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+#include "Utils.h"
+#include "Scrollbar.h"
+#include "LayerCache.h"
+#include "ui_library/Config.h"
+
+
+// A scrolled viewport with its Scrollbar, whose content is kept in an offscreen layer taller
+// than the viewport by a margin above and below. Scrolling within the margin only moves where
+// the layer is sampled, so wheeling through a long list costs one quad a frame. The content
+// is drawn again when scrolled past the margin, when the viewport or content height changes,
+// on Invalidate, or when one of its widgets changes hover state (see LayerCache).
+class ScrollView
+{
+public:
+    explicit ScrollView(UI* _ui) : mUI(_ui), mScrollbar(_ui) {}
+
+    // Draws the scrollbar and the content clipped to `viewport`. `draw(offset)` draws the
+    // content as if scrolled down by `offset` pixels, without clipping it to the viewport, and
+    // is only called when the layer has to be redrawn. Change `version` (or call Invalidate)
+    // when what the content shows changes.
+    void Draw(Boundary viewport, int contentHeight, const std::function<void(int offset)>& draw, Colour col = BUTTON_COLOUR, std::uint64_t version = 0);
+
+    void Invalidate() { mLayer.Invalidate(); }
+    // Pixels drawn beyond each edge of the viewport.
+    void SetMargin(int margin) { mMargin = margin < 0 ? 0 : margin; }
+    void SetZ(float z) { mScrollbar.SetZ(z); }
+    int ScrollOffset() const { return mScrollbar.scrollOffset; }
+
+private:
+    UI* mUI;
+    Scrollbar mScrollbar;
+    LayerCache mLayer;
+    int mMargin = 256;
+    int mRenderOffset = -1;    // Scroll offset the layer was drawn at; -1 before the first draw.
+    int mContentHeight = -1;
+};
@@ -13,7 +13,7 @@ class Scrollbar : public MouseHandler
 	public:
 		Scrollbar(UI* _ui);
 		void Draw(Boundary scrollContainer, int fullHeight, Colour col = BUTTON_COLOUR);
-		void MouseCallback(int _mouseState) override;
+		void OnMouseEvent(const MouseEvent& event) override;
 
 		int scrollOffset = 0;
 
@@ -24,12 +24,14 @@ class Shader
         // material vars
         GLenum renderType = GL_TRIANGLES;
 
-        // state
-		GLuint ID;
+        // state (0 until the program is compiled on first Bind)
+		GLuint ID = 0;
         // constructor
 		Shader();
         ~Shader();
+		// Records the shader files; they are read and compiled on first Bind()
 		void Set(const char* vertexFile, const char* fragmentFile);
+		bool IsCompiled() const { return ID != 0; }
 		
         //Shader() {}
         // sets the current shader as active
@@ -49,6 +51,11 @@ class Shader
         void    SetVector4f (const char *name, const glm::vec4 &value, bool useShader = false);
         void    SetMatrix4  (const char *name, const glm::mat4 &matrix, bool useShader = false);
 
+	private:
+		void CompileFiles();
+
+		std::string mVertexFile;
+		std::string mFragmentFile;
 };
 
 
@@ -0,0 +1,96 @@
+// Copyright (c) 2025 Thomas Groom
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+
+// Generational slot map: O(1) insert and remove, handles that stay valid until their own
+// element is removed (and are detected as stale afterwards), and values kept densely packed
+// for linear iteration.
+//
+// Values are stored contiguously in no particular order; removing swaps the last value into
+// the hole. Slots are recycled through a free list and their generation is bumped on removal,
+// so a handle to a removed element never resolves to whatever reuses its slot.
+template <typename T>
+class SlotMap
+{
+public:
+    struct Handle {
+        static constexpr std::uint32_t kInvalid = std::numeric_limits<std::uint32_t>::max();
+
+        std::uint32_t index = kInvalid;
+        std::uint32_t generation = 0;
+
+        bool IsValid() const { return index != kInvalid; }
+        bool operator==(const Handle& other) const { return index == other.index && generation == other.generation; }
+        bool operator!=(const Handle& other) const { return !(*this == other); }
+    };
+
+    Handle Insert(const T& value) {
+        std::uint32_t slotIndex;
+        if (mFreeHead != Handle::kInvalid) {
+            slotIndex = mFreeHead;
+            mFreeHead = mSlots[slotIndex].nextFree;
+        } else {
+            slotIndex = static_cast<std::uint32_t>(mSlots.size());
+            mSlots.push_back({ 0, 0, Handle::kInvalid });
+        }
+        Slot& slot = mSlots[slotIndex];
+        slot.dense = static_cast<std::uint32_t>(mValues.size());
+        mValues.push_back(value);
+        mDenseToSlot.push_back(slotIndex);
+        return { slotIndex, slot.generation };
+    }
+
+    // Returns false if the handle was already stale.
+    bool Remove(Handle handle) {
+        if (!Contains(handle)) return false;
+        Slot& slot = mSlots[handle.index];
+        std::uint32_t hole = slot.dense;
+        std::uint32_t last = static_cast<std::uint32_t>(mValues.size() - 1);
+        if (hole != last) {
+            mValues[hole] = std::move(mValues[last]);
+            mDenseToSlot[hole] = mDenseToSlot[last];
+            mSlots[mDenseToSlot[hole]].dense = hole;
+        }
+        mValues.pop_back();
+        mDenseToSlot.pop_back();
+
+        slot.generation++;
+        slot.nextFree = mFreeHead;
+        mFreeHead = handle.index;
+        return true;
+    }
+
+    bool Contains(Handle handle) const {
+        // Removal bumps the generation, so a matching generation means the slot is live.
+        return handle.index < mSlots.size() && mSlots[handle.index].generation == handle.generation;
+    }
+
+    T* Get(Handle handle) { return Contains(handle) ? &mValues[mSlots[handle.index].dense] : nullptr; }
+    const T* Get(Handle handle) const { return Contains(handle) ? &mValues[mSlots[handle.index].dense] : nullptr; }
+
+    std::size_t Size() const { return mValues.size(); }
+    bool Empty() const { return mValues.empty(); }
+    void Reserve(std::size_t count) { mSlots.reserve(count); mValues.reserve(count); mDenseToSlot.reserve(count); }
+
+    // Dense storage of the live values, for linear passes.
+    const std::vector<T>& Values() const { return mValues; }
+    typename std::vector<T>::const_iterator begin() const { return mValues.begin(); }
+    typename std::vector<T>::const_iterator end() const { return mValues.end(); }
+
+private:
+    struct Slot {
+        std::uint32_t dense;        // Index into mValues while live.
+        std::uint32_t generation;   // Bumped on removal.
+        std::uint32_t nextFree;     // Free-list link while the slot is free.
+    };
+
+    std::vector<Slot> mSlots;
+    std::vector<T> mValues;
+    std::vector<std::uint32_t> mDenseToSlot;
+    std::uint32_t mFreeHead = Handle::kInvalid;
+};
@@ -0,0 +1,60 @@
+// Copyright (c) 2025 Thomas Groom
+
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <ostream>
+#include <string>
+#include <vector>
+
+
+// Records how long each phase of start-up takes, from Application::run until the first frame
+// has been presented. Phases are marked with ScopedPhase; the library marks GLFW init, GLAD,
+// font loading, shader compilation, texture loading and onInit, and applications may add
+// their own. Phases can nest and can run on worker threads, so their times may overlap.
+//
+// Recording stops after the first frame, so phases outside start-up cost one atomic load.
+class StartupTrace
+{
+public:
+    struct Event {
+        std::string name;
+        double start;      // Seconds since Begin().
+        double duration;   // Seconds.
+        unsigned int thread;
+    };
+
+    class ScopedPhase
+    {
+    public:
+        explicit ScopedPhase(const char* name);
+        ~ScopedPhase();
+
+        ScopedPhase(const ScopedPhase&) = delete;
+        ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+    private:
+        const char* mName;
+        double mStart;
+        bool mActive;
+    };
+
+    static void Begin();
+    static void End();
+    static bool IsActive() { return sActive.load(std::memory_order_relaxed); }
+    // Seconds from Begin() to End() (or to now if still recording).
+    static double Elapsed();
+
+    static std::vector<Event> Events();
+    // Total time, count and first start of each phase name, in order of first occurrence.
+    static void Print(std::ostream& out);
+    // Writes the events in the Chrome trace event format (chrome://tracing, Perfetto).
+    static bool WriteChromeTrace(const std::filesystem::path& file);
+
+private:
+    static double Now();
+    static void Record(const char* name, double start, double end);
+
+    static std::atomic<bool> sActive;
+};
@@ -0,0 +1,285 @@
+// Copyright (c) 2025 Thomas Groom
+
+#pragma once
+
+// Coroutine tasks for multi-step UI flows, driven by the Application loop. Only available when
+// the library is built with -DUI_LIBRARY_COROUTINES=ON (which builds as C++20); in the default
+// C++17 build this header is empty.
+#ifdef UI_LIBRARY_COROUTINES
+
+#if !defined(__cpp_impl_coroutine)
+#error "ui_library/Task.h needs a C++20 compiler with coroutine support"
+#endif
+
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "portable-file-dialogs.h"
+
+
+template <typename T = void>
+class Task;
+
+
+// State shared by every Task promise.
+class TaskPromiseBase
+{
+public:
+    // Tasks start when awaited or spawned, not when called.
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+            TaskPromiseBase& promise = handle.promise();
+            if (promise.mContinuation) {
+                return promise.mContinuation;
+            }
+            if (promise.mDetached) {
+                promise.ReportException();
+                handle.destroy();
+            }
+            return std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() { mException = std::current_exception(); }
+
+    std::coroutine_handle<> mContinuation;   // The coroutine awaiting this one, if any.
+    std::exception_ptr mException;
+    bool mDetached = false;                  // Spawned: nothing awaits it, it frees itself.
+
+private:
+    void ReportException() const;
+};
+
+
+template <typename T>
+class TaskPromise : public TaskPromiseBase
+{
+public:
+    Task<T> get_return_object();
+    template <typename U>
+    void return_value(U&& value) { mValue.emplace(std::forward<U>(value)); }
+    std::optional<T> mValue;
+};
+
+
+template <>
+class TaskPromise<void> : public TaskPromiseBase
+{
+public:
+    Task<void> get_return_object();
+    void return_void() {}
+};
+
+
+// A lazily started coroutine returning T. Await it from another task, or hand a Task<> to
+// TaskScheduler::Spawn to run it alongside the frame loop. Exceptions propagate to the
+// awaiting task; for spawned tasks they are printed.
+template <typename T>
+class Task
+{
+public:
+    using promise_type = TaskPromise<T>;
+
+    Task() = default;
+    Task(Task&& other) noexcept : mHandle(std::exchange(other.mHandle, {})) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (mHandle) mHandle.destroy();
+            mHandle = std::exchange(other.mHandle, {});
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() {
+        if (mHandle) mHandle.destroy();
+    }
+
+    bool IsValid() const { return static_cast<bool>(mHandle); }
+    bool Done() const { return !mHandle || mHandle.done(); }
+
+    // Starts the task and resumes the awaiting coroutine with its result once it finishes.
+    auto operator co_await() && noexcept {
+        struct Awaiter {
+            std::coroutine_handle<promise_type> handle;
+            bool await_ready() noexcept { return !handle || handle.done(); }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                handle.promise().mContinuation = awaiting;
+                return handle;
+            }
+            T await_resume() {
+                promise_type& promise = handle.promise();
+                if (promise.mException) {
+                    std::rethrow_exception(promise.mException);
+                }
+                if constexpr (!std::is_void_v<T>) {
+                    return std::move(*promise.mValue);
+                }
+            }
+        };
+        return Awaiter{ mHandle };
+    }
+
+private:
+    friend class TaskPromise<T>;
+    friend class TaskScheduler;
+    explicit Task(std::coroutine_handle<promise_type> handle) : mHandle(handle) {}
+
+    std::coroutine_handle<promise_type> mHandle;
+};
+
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() {
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+
+inline Task<void> TaskPromise<void>::get_return_object() {
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+
+// Resumes suspended tasks from the Application loop. ResumeFrame runs on the UI thread after
+// input is granted and before onUpdate, so a task resumed by nextFrame() or delay() sees the
+// same state as onUpdate and may touch the widgets.
+class TaskScheduler
+{
+public:
+    static TaskScheduler& getInstance() {
+        static TaskScheduler instance;
+        return instance;
+    }
+
+    // Starts `task` now, on the calling thread, and lets it run to completion on its own.
+    void Spawn(Task<> task);
+
+    // Marks the calling thread as the UI thread. Application::run calls it.
+    void BindUiThread() { mUiThread = std::this_thread::get_id(); }
+    bool IsUiThread() const { return std::this_thread::get_id() == mUiThread; }
+
+    // UI thread. Resumes the tasks waiting for this frame and those whose delay has passed.
+    // Returns the time the next frame is needed by: `now` if a task waits for the next frame,
+    // the earliest remaining delay, or infinity.
+    double ResumeFrame(double now);
+
+    // Used by the awaitables below; thread-safe.
+    void WaitFrame(std::coroutine_handle<> handle);
+    void WaitUntil(double time, std::coroutine_handle<> handle);
+    // Runs `work` on a thread of its own (it may block for as long as a dialog is open), then
+    // resumes `handle` on the UI thread.
+    static void RunBlocking(std::function<void()> work, std::coroutine_handle<> handle);
+
+private:
+    TaskScheduler() {}
+    // Tasks still suspended at exit are left unresumed.
+    ~TaskScheduler() {}
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    struct Timer {
+        double time;
+        std::coroutine_handle<> handle;
+    };
+    static bool Later(const Timer& a, const Timer& b) { return a.time > b.time; }
+
+    std::mutex mMutex;
+    std::vector<std::coroutine_handle<>> mNextFrame;
+    std::vector<Timer> mTimers;   // Min-heap on time.
+    std::thread::id mUiThread;
+};
+
+
+// Resumes on the UI thread at the start of the next frame.
+inline auto nextFrame() {
+    struct Awaiter {
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) { TaskScheduler::getInstance().WaitFrame(handle); }
+        void await_resume() const noexcept {}
+    };
+    return Awaiter{};
+}
+
+
+// Resumes on the UI thread in the first frame at least `milliseconds` from now. With
+// redrawOnDemand the loop wakes for it.
+struct DelayAwaiter {
+    double milliseconds;
+    bool await_ready() const noexcept { return milliseconds <= 0.0; }
+    void await_suspend(std::coroutine_handle<> handle);
+    void await_resume() const noexcept {}
+};
+inline DelayAwaiter delay(double milliseconds) { return DelayAwaiter{ milliseconds }; }
+
+
+// Continues on a JobSystem worker (or carries on inline if there is no JobSystem). Code after
+// it must not touch GL or the widgets until it awaits onUiThread().
+struct ThreadPoolAwaiter {
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> handle);
+    void await_resume() const noexcept {}
+};
+inline ThreadPoolAwaiter onThreadPool() { return {}; }
+
+
+// Continues on the UI thread, through the CommandQueue. Carries on directly if already there.
+struct UiThreadAwaiter {
+    bool await_ready() const { return TaskScheduler::getInstance().IsUiThread(); }
+    void await_suspend(std::coroutine_handle<> handle);
+    void await_resume() const noexcept {}
+};
+inline UiThreadAwaiter onUiThread() { return {}; }
+
+
+// Waits for `future` without blocking the frame loop, resuming on the UI thread with its value.
+template <typename T>
+auto awaitFuture(std::future<T> future) {
+    struct Awaiter {
+        std::future<T> future;
+        bool await_ready() const { return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }
+        void await_suspend(std::coroutine_handle<> handle) {
+            TaskScheduler::RunBlocking([this] { future.wait(); }, handle);
+        }
+        T await_resume() { return future.get(); }
+    };
+    return Awaiter{ std::move(future) };
+}
+
+
+// Shows a native open-file dialog and resumes on the UI thread with the chosen paths, empty if
+// it was cancelled. Replaces polling a pfd::open_file every frame.
+inline auto openFileDialog(std::string title, std::string defaultPath = "", std::vector<std::string> filters = { "All Files", "*" }, bool allowMultiple = false) {
+    struct Awaiter {
+        std::string title;
+        std::string defaultPath;
+        std::vector<std::string> filters;
+        bool allowMultiple;
+        std::vector<std::string> result;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) {
+            TaskScheduler::RunBlocking([this] {
+                result = pfd::open_file(title, defaultPath, filters, allowMultiple ? pfd::opt::multiselect : pfd::opt::none).result();
+            }, handle);
+        }
+        std::vector<std::string> await_resume() { return std::move(result); }
+    };
+    return Awaiter{ std::move(title), std::move(defaultPath), std::move(filters), allowMultiple, {} };
+}
+
+#endif  // UI_LIBRARY_COROUTINES
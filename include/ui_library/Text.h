@@ -3,7 +3,11 @@
 #pragma once
 
 #include <map>
+#include <memory>
 #include <iostream>
+#include <atomic>
+#include <mutex>
+#include <vector>
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -11,6 +15,7 @@
 
 #include "Shader.h"
 #include "Utils.h"
+#include "DrawList.h"
 #include "VAO.h"
 #include "VBO.h"
 #include FT_FREETYPE_H
@@ -28,7 +33,7 @@ struct Character {
 // A renderer class for rendering text displayed by a font loaded using the 
 // FreeType library. A single font is loaded, processed into a list of Character
 // items for later rendering.
-class Text
+class Text : public std::enable_shared_from_this<Text>
 {
     public:
         enum Align {
@@ -53,19 +58,42 @@ class Text
         // constructor
         Text(std::string font, unsigned int fontSize);
         ~Text(){};
-        // pre-compiles a list of characters from the given font
+        // selects the font; its characters are pre-compiled on first measure or draw
         void Load(std::string font, unsigned int fontSize);
         glm::ivec2 boundingBox(std::wstring text);
-        // renders a string of text using the precompiled list of characters
+        // renders a string of text using the precompiled list of characters. Lays the text out
+        // on the calling thread and records it if a DrawList is recording, so any thread may call it.
         float RenderText(std::wstring text, Boundary textContainer, float z = 0.0f, Align align = CENTER_MIDDLE, Colour color = Colour(1.0f, 1.0f, 1.0f), bool truncate = true, bool selectable = false, int selectionStart = 0, int selectionEnd = 0, int caretPos = -1);
         unsigned int mFontSize = 12;
 
         float getTextHeight(const std::wstring& text, int containerWidth);
 
+        // Draws laid-out glyphs (GL thread); used by RenderText and DrawList::Submit.
+        void SubmitGlyphs(const DrawList::GlyphRun& run);
+
     private:
+        void EnsureLoaded();
+        // Uploads glyphs rasterised since the last call. GL thread only.
+        void EnsureUploaded();
+        void LoadGlyphs();
+        // Metrics of a loaded glyph, or an empty one if the font has no such character.
+        Character Glyph(wchar_t c) const;
         int getTextWidth(const std::wstring& text);
         void truncateText(std::wstring& text, int maxWidth);
 
+        struct PendingGlyph {
+            char c;
+            int width;
+            int height;
+            std::vector<unsigned char> pixels;
+        };
+
+        std::string mFontFile;
+        std::atomic<bool> mLoaded{ false };
+        bool mGLReady = false;
+        mutable std::mutex mLoadMutex;   // Guards the members below and Characters.
+        std::vector<PendingGlyph> mPendingGlyphs;   // Rasterised, not yet uploaded.
+        std::vector<GLuint> mStaleTextures;         // From before a reload, deleted on the GL thread.
         // holds a list of pre-compiled Characters
         std::map<char, Character> Characters; 
         // shader used for text rendering
@@ -80,6 +108,4 @@ class Text
         
         Colour selectionColor = Colour(0.2f, 0.4f, 0.8f);
 
-        std::vector<std::wstring> lines;
-
 };
@@ -5,6 +5,7 @@
 
 #include <string>
 #include <algorithm>
+#include <cmath>
 #include <GLFW/glfw3.h>
 #include <codecvt>
 #include <locale>
@@ -19,96 +20,125 @@ public:
     int selStart = 0;
     int selEnd = 0;
     bool isActive = false;
-    int caretVisibilityCounter = 0;
-    int caretBlinkRate = 30;
+    bool caretVisible = true;
+    double caretBlinkInterval = 0.53;   // Seconds the caret stays on (and off)
+    double caretBlinkOrigin = 0.0;      // glfwGetTime() when the caret last became solid
 
     // The constructor takes a GLFWwindow pointer.
     TextField(UI* _ui) : mUI(_ui) {}
 
     void handleInput() {
         if (isActive) {
-            // --- OS Clipboard Functionality using GLFW ---
-            // Ctrl+C: Copy selected text to OS clipboard.
-            if (mUI->G_CTRL_C_PRESS) {
-                if (selStart != selEnd) {
-                    if (selStart > selEnd) std::swap(selStart, selEnd);
-                    std::wstring selected = content.substr(selStart, selEnd - selStart);
-                    std::string selected_utf8 = wstring_to_utf8(selected);
-                    glfwSetClipboardString(G_WINDOW, selected_utf8.c_str());
+            // Events are handled in arrival order so fast typing, key repeats and pasted key
+            // sequences are applied exactly as entered, however long the frame took.
+            bool edited = false;
+            for (const InputEvent& event : mUI->G_EVENTS) {
+                if (event.type == InputEvent::CHAR) {
+                    std::wstring typed;
+                    AppendCodepoint(typed, event.codepoint);
+                    insertText(typed);
+                    edited = true;
+                } else if (event.type == InputEvent::KEY && (event.action == GLFW_PRESS || event.action == GLFW_REPEAT)) {
+                    // The owner deactivates the field on Enter; anything after it is not for this field.
+                    if (event.key == GLFW_KEY_ENTER || event.key == GLFW_KEY_KP_ENTER) break;
+                    edited |= handleKey(event.key, event.action, event.mods);
                 }
             }
 
+            // Blink cursor. Based on time rather than frame count so it is independent of the frame
+            // rate, and it schedules a redraw for the next toggle instead of needing continuous frames.
+            double now = glfwGetTime();
+            if (edited) {
+                caretBlinkOrigin = now;  // Keep the caret solid while typing
+            }
+            double phase = std::fmod(now - caretBlinkOrigin, caretBlinkInterval * 2.0);
+            caretVisible = phase < caretBlinkInterval;
+            mUI->InvalidateAt(now + (caretVisible ? caretBlinkInterval : caretBlinkInterval * 2.0) - phase);
+        } else {
+            caretVisible = true;
+            resetSelection();
+        }
+    }
+
+    // Restarts the blink so the caret is visible immediately, e.g. when the field is activated.
+    void resetCaretBlink() {
+        caretBlinkOrigin = glfwGetTime();
+        caretVisible = true;
+    }
+
+    // Applies one key press or repeat. Returns true if the caret or the content changed.
+    bool handleKey(int key, int action, int mods) {
+        bool shift = (mods & GLFW_MOD_SHIFT) != 0;
+
+        // --- OS Clipboard Functionality using GLFW ---
+        if (mods & GLFW_MOD_CONTROL) {
+            // Ctrl+C: Copy selected text to OS clipboard.
             // Ctrl+X: Cut selected text (copy to clipboard then delete selection).
-            if (mUI->G_CTRL_X_PRESS) {
+            if ((key == GLFW_KEY_C || key == GLFW_KEY_X) && action == GLFW_PRESS) {
                 if (selStart != selEnd) {
                     if (selStart > selEnd) std::swap(selStart, selEnd);
                     std::wstring selected = content.substr(selStart, selEnd - selStart);
                     std::string selected_utf8 = wstring_to_utf8(selected);
                     glfwSetClipboardString(G_WINDOW, selected_utf8.c_str());
-                    deleteSelection();
+                    if (key == GLFW_KEY_X) {
+                        deleteSelection();
+                        return true;
+                    }
                 }
+                return false;
             }
-
             // Ctrl+V: Paste clipboard text (replace any selected text).
-            if (mUI->G_CTRL_V_PRESS) {
+            if (key == GLFW_KEY_V) {
                 const char* clipboard_text = glfwGetClipboardString(G_WINDOW);
                 if (clipboard_text) {
-                    std::wstring paste_text = utf8_to_wstring(std::string(clipboard_text));
-                    if (selStart != selEnd) {
-                        deleteSelection();
-                    }
-                    content.insert(caretPos, paste_text);
-                    caretPos += static_cast<int>(paste_text.size());
-                    resetSelection();
-                }
-            }
-            // ------------------------------------------------
-
-            // Character input.
-            if (mUI->G_CHAR_CALLBACK_FLAG) {
-                if (selStart != selEnd) deleteSelection();
-                content.insert(content.begin() + caretPos, static_cast<wchar_t>(mUI->G_CHAR_INPUT));
-                caretPos++;
-                resetSelection();
-            }
-
-            // Backspace and Delete.
-            if (mUI->G_BACKSPACE_PRESS || mUI->G_DELETE_PRESS) {
-                if (selStart != selEnd) {
-                    deleteSelection();
-                } else if (mUI->G_BACKSPACE_PRESS && caretPos > 0) {
-                    content.erase(caretPos - 1, 1);
-                    caretPos--;
-                } else if (mUI->G_DELETE_PRESS && caretPos < content.size()) {
-                    content.erase(caretPos, 1);
+                    insertText(utf8_to_wstring(std::string(clipboard_text)));
+                    return true;
                 }
-                resetSelection();
+                return false;
             }
-
-            // Arrow keys.
-            if (mUI->G_LEFT_ARROW_PRESS) caretPos = std::max(0, caretPos - 1);
-            if (mUI->G_RIGHT_ARROW_PRESS) caretPos = std::min(static_cast<int>(content.size()), caretPos + 1);
-
-            // Update selection with Shift.
-            if (mUI->G_SHIFT_PRESS && selStart == selEnd) {
-                selStart = caretPos;
-            }
-            if (mUI->G_SHIFT_DOWN) {
-                selEnd = caretPos;
-            } else {
-                if (mUI->G_LEFT_ARROW_PRESS || mUI->G_RIGHT_ARROW_PRESS || mUI->G_HOME_PRESS || mUI->G_END_PRESS) {
-                    resetSelection();
-                }
+        }
+        // ------------------------------------------------
+
+        switch (key) {
+        case GLFW_KEY_BACKSPACE:
+        case GLFW_KEY_DELETE:
+            if (selStart != selEnd) {
+                deleteSelection();
+            } else if (key == GLFW_KEY_BACKSPACE && caretPos > 0) {
+                int from = previousPos(caretPos);
+                content.erase(from, caretPos - from);
+                caretPos = from;
+            } else if (key == GLFW_KEY_DELETE && caretPos < static_cast<int>(content.size())) {
+                content.erase(caretPos, nextPos(caretPos) - caretPos);
             }
+            resetSelection();
+            return true;
+        case GLFW_KEY_LEFT:  moveCaret(previousPos(caretPos), shift); return true;
+        case GLFW_KEY_RIGHT: moveCaret(nextPos(caretPos), shift); return true;
+        case GLFW_KEY_HOME:  moveCaret(0, shift); return true;
+        case GLFW_KEY_END:   moveCaret(static_cast<int>(content.size()), shift); return true;
+        default:
+            return false;
+        }
+    }
 
-            // Home and End keys.
-            if (mUI->G_HOME_PRESS) caretPos = 0;
-            if (mUI->G_END_PRESS) caretPos = static_cast<int>(content.size());
+    // Replaces any selection with `text` and places the caret after it.
+    void insertText(const std::wstring& text) {
+        if (selStart != selEnd) deleteSelection();
+        content.insert(caretPos, text);
+        caretPos += static_cast<int>(text.size());
+        resetSelection();
+    }
 
-            // Blink cursor.
-            caretVisibilityCounter = (caretVisibilityCounter + 1) % (caretBlinkRate * 2);
+    // Moves the caret, extending the selection from its anchor (selStart) when `extend` is set.
+    void moveCaret(int position, bool extend) {
+        if (extend && selStart == selEnd) {
+            selStart = caretPos;
+        }
+        caretPos = std::clamp(position, 0, static_cast<int>(content.size()));
+        if (extend) {
+            selEnd = caretPos;
         } else {
-            caretVisibilityCounter = 0;
             resetSelection();
         }
     }
@@ -125,6 +155,20 @@ public:
         selEnd = caretPos;
     }
 private:
+    // Caret steps that do not split a UTF-16 surrogate pair (only possible where wchar_t is 16 bits).
+    static bool isLowSurrogate(wchar_t c) { return c >= 0xDC00 && c <= 0xDFFF; }
+    int previousPos(int pos) const {
+        pos = std::max(0, pos - 1);
+        if (pos > 0 && isLowSurrogate(content[pos])) pos--;
+        return pos;
+    }
+    int nextPos(int pos) const {
+        int size = static_cast<int>(content.size());
+        pos = std::min(size, pos + 1);
+        if (pos < size && isLowSurrogate(content[pos])) pos++;
+        return pos;
+    }
+
     UI* mUI;
 };
 
@@ -9,8 +9,10 @@
 #include <glad/glad.h>
 #include <filesystem>
 #include <queue>
+#include <memory>
 #include <mutex>
-#include <thread>
+#include <atomic>
+#include <cstdint>
 #include <glm/glm.hpp>
 #include <ui_library/stb_image.h>
 #include <ui_library/stb_image_resize2.h>
@@ -19,12 +21,13 @@
 #include "ui_library/Config.h"
 #include "Utils.h"
 #include "Shader.h"
+#include "JobSystem.h"
 #include "VAO.h"
 #include "VBO.h"
 
 // Texture2D is able to store and configure a texture in OpenGL.
 // It also hosts utility functions for easy management.
-class Texture2D
+class Texture2D : public std::enable_shared_from_this<Texture2D>
 {
 public:
     unsigned int ID = 0;
@@ -38,15 +41,14 @@ public:
     unsigned int filterMax;
 
     Texture2D(GLenum internalFormat, GLenum imageFormat, const std::filesystem::path& file, glm::vec2 boundingBox);
-    ~Texture2D() {
-        if (this->ID != 0) {
-            glDeleteTextures(1, &this->ID);
-        }
-    }
+    ~Texture2D();
 
     void loadTextureFromFileAsync(const std::filesystem::path& file, glm::vec2 boundingBox);
     void DrawSprite(glm::vec2 position, glm::vec2 desiredSize, float z = 0.0f, float rotate = 0.0f, glm::vec3 color = glm::vec3(1.0f));
 
+    // Changes whenever a decoded image is queued or uploaded, so cached frames know to redraw.
+    std::uint32_t ContentVersion() const { return mContentVersion.load(std::memory_order_acquire); }
+
     glm::vec2 mDesiredSize = glm::vec2(20.0f, 20.0f);
     glm::vec2 mFitSize = glm::vec2(20.0f, 20.0f);
 
@@ -55,6 +57,7 @@ private:
     void Unbind() const;
     void Create(GLuint texWidth, GLuint texHeight, const unsigned char* pixelData);
     void processTextureQueue();
+    void InitGL();
 
     Shader spriteShader;
     VAO VAO1;
@@ -63,6 +66,9 @@ private:
     std::queue<std::tuple<unsigned char*, glm::vec2>> textureQueue;
     std::mutex queueMutex;
     std::condition_variable queueCondVar;
+    JobSystem::Handle loadJob;
+    bool glReady = false;
+    std::atomic<std::uint32_t> mContentVersion{ 0 };
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,172 @@
+// Copyright (c) 2025 Thomas Groom
+
+#pragma once
+
+#include <glad/glad.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "ui_library/Config.h"
+#include "Utils.h"
+#include "Shader.h"
+#include "VAO.h"
+#include "VBO.h"
+
+
+// Pan and zoom viewer for images that are too large to hold as a single Texture2D.
+//
+// A worker thread cuts the image into a pyramid of fixed-size tiles (level 0 is full
+// resolution, each further level halves it). Tiles are kept either in memory or in an
+// on-disk cache directory; with a warm disk cache the source image is never decoded again.
+// Only the tiles visible at the level matching the current zoom are streamed into a single
+// atlas texture, whose slots are recycled in least-recently-used order. The atlas is sized
+// (and grown with the view) to hold every tile the view can show at once; where the GL
+// texture size limit prevents that, a coarser level is drawn instead. Tiles that could not
+// be fetched are not requested again.
+//
+// Controls: scroll to zoom around the cursor, left or middle drag to pan.
+class TiledImage : public MouseHandler
+{
+public:
+    // `atlasSlotsPerRow` is the smallest atlas, in tiles per side; it grows as the view needs.
+    TiledImage(UI* _ui, const std::filesystem::path& file, const std::filesystem::path& cacheDir = {},
+               int tileSize = 256, int atlasSlotsPerRow = 8);
+    ~TiledImage();
+
+    TiledImage(const TiledImage&) = delete;
+    TiledImage& operator=(const TiledImage&) = delete;
+
+    void Draw(Boundary container, float z = 0.0f);
+    void OnMouseEvent(const MouseEvent& event) override;
+
+    // Fits the whole image inside the current container.
+    void FitToView();
+    // Sets the zoom (screen pixels per image pixel) keeping the given screen point fixed.
+    void SetZoom(double zoom, glm::dvec2 screenAnchor);
+    double GetZoom() const { return mZoom; }
+
+    // True once the pyramid has been built (or found in the disk cache).
+    bool IsReady() const { return mReady.load(std::memory_order_acquire); }
+    int GetImageWidth() const { return mImageWidth; }
+    int GetImageHeight() const { return mImageHeight; }
+
+    // Maximum number of tiles uploaded to the atlas per frame.
+    int mUploadsPerFrame = 8;
+
+private:
+    using TileKey = std::uint64_t;
+
+    struct TileData {
+        TileKey key;
+        int width;
+        int height;
+        std::vector<unsigned char> pixels;
+    };
+
+    struct Resident {
+        int slot;
+        std::list<TileKey>::iterator lruIt;
+    };
+
+    // What one draw shows, worked out on the drawing thread and handed to the GL thread.
+    struct TileView {
+        Boundary view = Boundary(0, 0, 0, 0);
+        float z = 0.0f;
+        glm::dvec2 offset = glm::dvec2(0.0, 0.0);
+        double zoom = 1.0;
+        int level = 0;
+        double x0 = 0.0, y0 = 0.0, x1 = 0.0, y1 = 0.0;   // Visible region in level 0 pixels.
+        std::vector<TileKey> visible;
+    };
+
+    static TileKey MakeKey(int level, int tx, int ty) {
+        return (static_cast<TileKey>(level) << 48) | (static_cast<TileKey>(ty) << 24) | static_cast<TileKey>(tx);
+    }
+    static int KeyLevel(TileKey key) { return static_cast<int>(key >> 48); }
+    static int KeyY(TileKey key) { return static_cast<int>((key >> 24) & 0xFFFFFF); }
+    static int KeyX(TileKey key) { return static_cast<int>(key & 0xFFFFFF); }
+
+    // Worker thread.
+    void WorkerMain();
+    bool LoadManifest();
+    bool BuildPyramid();
+    void StoreTile(int level, int tx, int ty, std::vector<unsigned char>&& pixels);
+    bool FetchTile(TileKey key, TileData& out);
+    std::filesystem::path TilePath(TileKey key) const;
+
+    // GL thread.
+    void DrawTiles(const TileView& view);
+    void CreateAtlas(Boundary view);
+    void UploadReadyTiles();
+    int AcquireSlot(const std::unordered_set<TileKey>& pinned);
+    int MaxVisibleTiles(Boundary view) const;
+    int LevelWidth(int level) const { return std::max(1, (mImageWidth + (1 << level) - 1) >> level); }
+    int LevelHeight(int level) const { return std::max(1, (mImageHeight + (1 << level) - 1) >> level); }
+    int TileWidth(TileKey key) const;
+    int TileHeight(TileKey key) const;
+    void AddQuad(std::vector<GLfloat>& verts, float x0, float y0, float x1, float y1,
+                 float u0, float v0, float u1, float v1);
+    // Changes whenever a draw at `container` would show something else.
+    std::uint64_t ViewKey(Boundary container, float z) const;
+
+    UI* mUI;
+    std::filesystem::path mFile;
+    std::filesystem::path mCacheDir;
+    std::filesystem::path mTileDir;    // Per-image subdirectory of mCacheDir. Worker-only.
+    int mTileSize;
+    int mSlotsPerRow = 0;              // Of the current atlas.
+    int mMinSlotsPerRow;
+    int mMaxSlotsPerRow = 0;           // From GL_MAX_TEXTURE_SIZE, once the atlas is created.
+    std::atomic<int> mSlotCapacity{0}; // Slots in the atlas at its size limit; 0 until known.
+
+    // Pyramid description, written by the worker before mReady is set.
+    int mImageWidth = 0;
+    int mImageHeight = 0;
+    int mLevels = 0;
+    std::atomic<bool> mReady{false};
+    std::atomic<bool> mFailed{false};
+
+    // In-memory tile store (only used when no cache directory is given). Worker-only.
+    std::unordered_map<TileKey, std::vector<unsigned char>> mMemoryTiles;
+
+    // Tile requests and results shared between the GL thread and the worker.
+    std::thread mWorker;
+    std::mutex mQueueMutex;
+    std::condition_variable mQueueCondVar;
+    std::deque<TileKey> mRequests;
+    std::deque<TileData> mLoaded;
+    bool mStop = false;
+
+    // Atlas residency (GL thread only).
+    GLuint mAtlasID = 0;
+    std::unordered_map<TileKey, Resident> mResident;
+    std::list<TileKey> mLru;           // Front is most recently used.
+    std::vector<int> mFreeSlots;
+    std::unordered_set<TileKey> mInFlight;
+    std::unordered_set<TileKey> mFailedTiles;
+    std::unordered_set<TileKey> mVisibleSet;
+    std::atomic<std::uint64_t> mResidentGeneration{0};   // Bumped when tiles are uploaded.
+
+    // View state: level 0 image pixel shown at the container's top-left and zoom factor.
+    glm::dvec2 mOffset = glm::dvec2(0.0, 0.0);
+    double mZoom = 1.0;
+    bool mFitPending = true;
+    bool mPanning = false;
+
+    Boundary mView = Boundary(0, 0, 0, 0);
+
+    Shader mShader;
+    VAO mVAO;
+    VBO mVBO;
+    std::vector<GLfloat> mVerts;
+};
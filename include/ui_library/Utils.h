@@ -26,8 +26,19 @@
 #include <cctype>
 #include <cmath>
 #include <functional>
+#include <memory>
+#include <limits>
+#include <atomic>
+#include <utility>
+#include <vector>
+#include <cstdint>
 
 #include "ui_library/Config.h"
+#include "InputEvents.h"
+#include "HitGrid.h"
+#include "SlotMap.h"
+#include "WidgetStore.h"
+#include "DrawList.h"
 
 
 #define _USE_MATH_DEFINES
@@ -101,8 +112,36 @@ public:
 	bool G_CTRL_X_PRESS = false;
 	bool G_CTRL_C_PRESS = false;
 	bool G_CTRL_V_PRESS = false;
-	char G_CHAR_INPUT = 0;
+	char G_CHAR_INPUT = 0;          // Last character this frame, truncated; prefer G_EVENTS
 	bool G_CHAR_CALLBACK_FLAG = false;
+
+	// Every input event since the previous frame, in order. The flags above only keep the last
+	// state of each key per frame; widgets that must not lose input (text entry) read this.
+	InputQueue G_EVENTS;
+	// Every cursor motion sample, with per-frame delta and velocity helpers.
+	MouseHistory G_MOUSE_HISTORY;
+	// Set each frame by a widget that wants unaccelerated motion (only while the cursor is disabled).
+	bool G_RAW_MOUSE_MOTION = false;
+
+	// Redraw requests. With WindowSettings::redrawOnDemand the application only renders a frame
+	// when one of these is pending; otherwise they are ignored and every iteration renders.
+	// Atomic so widgets drawing on worker threads (see DrawList) can request redraws.
+	std::atomic<bool> G_REDRAW{ true };
+	std::atomic<double> G_NEXT_REDRAW_TIME{ std::numeric_limits<double>::infinity() };
+
+	// Render another frame as soon as possible (animations, state changed by a widget).
+	void Invalidate() { G_REDRAW = true; }
+	// Render a frame no later than `time` (glfwGetTime() seconds), e.g. the next caret blink.
+	void InvalidateAt(double time) {
+		double due = G_NEXT_REDRAW_TIME.load();
+		while (time < due && !G_NEXT_REDRAW_TIME.compare_exchange_weak(due, time)) {}
+	}
+
+	// Thread-safe: may be called from worker threads when async work (texture decode, tile
+	// loads) has finished. Wakes the event loop if it is waiting.
+	static void PostInvalidate();
+	// Returns true (and clears the request) if PostInvalidate was called since the last call.
+	static bool ConsumePostedInvalidate();
 };
 
 
@@ -426,26 +465,138 @@ struct Boundary{
 bool isMouseInBounds(UI* _ui, Boundary* bounds, int margin = 0, int pos_x = -1, int pos_y = -1);
 
 
+// Mouse event delivered to a MouseHandler. Types double as subscription bits for
+// MouseHandler::SetMouseEvents.
+struct MouseEvent {
+    enum Type : std::uint32_t {
+        ENTER      = 1 << 0,   // Became the topmost handler under the cursor in its layer.
+        LEAVE      = 1 << 1,   // Stopped being it (moved off, covered, or no longer drawn).
+        MOVE       = 1 << 2,   // Cursor moved while hovered.
+        PRESS      = 1 << 3,   // Button pressed while hovered; `button` says which.
+        RELEASE    = 1 << 4,
+        SCROLL     = 1 << 5,   // Scroll while hovered; the offset is in G_SCROLL_X/Y.
+        NEAR_ENTER = 1 << 6,   // Cursor came within the near margin (see SetNearMargin).
+        NEAR_LEAVE = 1 << 7,
+        HOVER      = 1 << 8,   // MouseCallback every frame while hovered, as before events existed.
+    };
+
+    Type type;
+    int button = -1;   // GLFW_MOUSE_BUTTON_* for PRESS and RELEASE.
+};
+
+
 class MouseHandler {
 public:
+    using Handle = SlotMap<MouseHandler*>::Handle;
+
     MouseHandler() 
-        : mContainer({0, 0, 0, 0}), isDrawn(false), mZ(0.0f), layer(0) 
+        : mContainer({0, 0, 0, 0}), mZ(0.0f), layer(0) 
     { 
-        instances.push_back(this);
+        mHandle = instances.Insert(this);
+    }
+
+    // Copies get their own registration; they are not drawn until they are drawn themselves.
+    MouseHandler(const MouseHandler& other)
+        : mContainer(other.mContainer), mZ(other.mZ), layer(other.layer),
+          mMouseEvents(other.mMouseEvents), mNearMargin(other.mNearMargin), mPixelPick(other.mPixelPick)
+    {
+        mHandle = instances.Insert(this);
+    }
+
+    MouseHandler& operator=(const MouseHandler& other) {
+        mContainer = other.mContainer;
+        mZ = other.mZ;
+        layer = other.layer;
+        mMouseEvents = other.mMouseEvents;
+        mNearMargin = other.mNearMargin;
+        mPixelPick = other.mPixelPick;
+        return *this;
     }
 
     virtual ~MouseHandler() {
-        instances.erase(std::remove(instances.begin(), instances.end(), this), instances.end());
+        instances.Remove(mHandle);
+        if (IsDrawn()) {
+            drawnStore.Kill(mDrawnRow);  // Skipped by the hit test; keeps draw order.
+            sLayoutChanged = true;
+        }
     }
 
+    // All live handlers, densely packed in no particular order.
     static const std::vector<MouseHandler*>& getInstances() {
-        return instances;
+        return instances.Values();
+    }
+
+    // Handlers drawn since the last grantMouseInput, in draw order. May contain nullptr for
+    // handlers destroyed after being drawn.
+    static const std::vector<MouseHandler*>& getDrawnInstances() {
+        return drawnStore.mOwner;
+    }
+
+    // Bounds, z and layer of the handlers drawn since the last grantMouseInput, one row each.
+    static const WidgetStore& getDrawnStore() {
+        return drawnStore;
+    }
+
+    // Stable identifier for this handler; Find returns nullptr once it has been destroyed.
+    Handle GetHandle() const { return mHandle; }
+    static MouseHandler* Find(Handle handle) {
+        MouseHandler** handler = instances.Get(handle);
+        return handler ? *handler : nullptr;
     }
 
     void SetZ(float z) { mZ = z; };
 
+    // Marks the handler as drawn this frame so it takes part in the next hit test, recording
+    // its current mContainer, mZ and layer (the last call in a frame wins).
+    // While a DrawList is recording this is deferred until the list is submitted.
+    void SetDrawn() {
+        if (DrawList* list = DrawList::Current()) {
+            list->MarkDrawn(this);
+            return;
+        }
+        if (IsDrawn()) {
+            drawnStore.Update(mDrawnRow, mContainer, mZ, layer);
+        } else {
+            mDrawnFrame = sFrame;
+            std::uint8_t flags = (mPixelPick ? WidgetStore::PIXEL_PICK : 0) | (mNearMargin > 0 ? WidgetStore::NEAR : 0);
+            mDrawnRow = drawnStore.Add(this, mContainer, mZ, layer, mHandle.index, flags);
+        }
+        // Compared as rows are written, so an unchanged frame is known without a pass.
+        if (!sLayoutChanged && !drawnStore.SameRow(mDrawnRow, previousStore)) {
+            sLayoutChanged = true;
+        }
+    }
+    bool IsDrawn() const { return mDrawnFrame == sFrame; }
+
+    // With GPU picking enabled (see PickBuffer), only pixels this handler actually drew into
+    // the pick buffer count as hits, rather than its whole mContainer. The handler must draw
+    // its shape into the pick buffer with PickId(); Primitive does this itself.
+    void SetPixelPick(bool pixelPick) { mPixelPick = pixelPick; }
+    bool IsPixelPick() const { return mPixelPick; }
+    std::uint32_t PickId() const { return mHandle.index + 1; }
+
+    // Which MouseEvent types are delivered to OnMouseEvent (MouseEvent::HOVER calls
+    // MouseCallback instead). HOVER by default, so existing MouseCallback overrides keep
+    // being called; a motionless cursor over such a handler costs a grant every frame, so
+    // handlers that do not need it subscribe to their events only.
+    void SetMouseEvents(std::uint32_t events) { mMouseEvents = events; }
+    std::uint32_t GetMouseEvents() const { return mMouseEvents; }
+    // Distance outside mContainer within which the handler counts as near. 0 disables it.
+    void SetNearMargin(int margin) { mNearMargin = margin; }
+    int GetNearMargin() const { return mNearMargin; }
+
+    // Kept up to date by MouseInputSingleton whether or not the events are subscribed.
+    bool IsHovered() const { return mHovered; }
+    bool IsNear() const { return mNear; }
+    // Counts the presses, releases and scrolls received while hovered, subscribed or not.
+    std::uint32_t Interactions() const { return mInteractions; }
+    // True from a press while hovered until any mouse button is released, wherever the cursor
+    // has gone since; i.e. while the handler is being dragged.
+    bool IsHeld() const { return mHeld; }
+    // Override to return true while the handler takes keyboard input.
+    virtual bool HasFocus() const { return false; }
+
     Boundary mContainer;
-    bool isDrawn;
     float mZ;
     int layer;
 
@@ -453,8 +604,32 @@ public:
         // Default behavior. Override in derived classes.
     }
 
+    virtual void OnMouseEvent(const MouseEvent& /*event*/) {
+        // Default behavior. Override in derived classes.
+    }
+
 private:
-    static std::vector<MouseHandler*> instances;
+    friend class MouseInputSingleton;
+
+    std::uint32_t mMouseEvents = MouseEvent::HOVER;
+    int mNearMargin = 0;
+    bool mHovered = false;
+    bool mNear = false;
+    std::uint32_t mInteractions = 0;
+    bool mHeld = false;
+
+    Handle mHandle;
+    bool mPixelPick = false;
+    std::uint32_t mDrawnFrame = sFrame - 1;
+    std::uint32_t mDrawnRow = 0;
+
+    static SlotMap<MouseHandler*> instances;
+    // Rows of the handlers drawn this frame; cleared (and sFrame advanced) after input is granted,
+    // which un-draws every handler without visiting them.
+    static WidgetStore drawnStore;
+    static WidgetStore previousStore;   // The rows as of the last grant.
+    static bool sLayoutChanged;         // A row differs from previousStore's, or was killed.
+    static std::uint32_t sFrame;
 };
 
 
@@ -473,7 +648,34 @@ private:
     MouseInputSingleton() {}
     ~MouseInputSingleton() {}
 
-    std::vector<MouseHandler*> selectedCallbacks;
+    // Delivers `type` to the handler if it still exists and has subscribed.
+    void dispatch(MouseHandler::Handle handle, MouseEvent::Type type, int button = -1);
+    // True if the cursor, buttons and drawn widgets are as they were when input was last
+    // granted, so no event can have occurred.
+    bool unchanged(UI* _ui) const;
+
+    std::vector<std::uint32_t> hits;   // Scratch for the grid query (rows of the drawn store).
+    std::vector<std::uint32_t> selectedRows;
+    HitGrid grid;
+    // The rows flagged WidgetStore::NEAR, by their bounds grown by the handler's near margin.
+    HitGrid nearGrid;
+    std::vector<int> nearMargins;      // Per row of the drawn store, for nearGrid.
+    std::vector<std::uint32_t> nearHits;
+    // What the grids were built for; the rows themselves are tracked by sLayoutChanged.
+    std::size_t gridRows = 0;
+    int gridWidth = -1;
+    int gridHeight = -1;
+
+    // State as of the last grant, diffed against to produce enter and leave events.
+    std::vector<MouseHandler::Handle> hovered;
+    std::vector<MouseHandler::Handle> nextHovered;
+    std::vector<MouseHandler::Handle> nearby;
+    std::vector<MouseHandler::Handle> nextNearby;
+    std::vector<MouseHandler::Handle> held;
+    double lastMouseX = -1.0;
+    double lastMouseY = -1.0;
+    std::uint32_t lastPicked = 0;
+    bool hoverEveryFrame = false;   // A hovered handler subscribes to MouseEvent::HOVER.
 
     MouseInputSingleton(const MouseInputSingleton&) = delete;
     void operator=(const MouseInputSingleton&) = delete;
@@ -493,6 +695,9 @@ public:
 	Primitive& Draw();
 	Primitive& SetCorners(std::vector<bool> corners) { mCorners = corners; return *this; };
 
+	// Draws recorded primitive geometry; used by DrawList::Submit on the GL thread.
+	static void SubmitMesh(const DrawList::Mesh& mesh);
+
 private:
 	std::vector<bool> mCorners = {true, true, true, true};
 	Shape target;
@@ -502,10 +707,12 @@ private:
 	EBO EBO1;
 
     bool isValid = false;
-	Shader shaderProgram;
-	GLuint uMVPMatrixID;
+	std::shared_ptr<Shader> shaderProgram;  // Shared by all primitives, compiled on first draw
+	GLint uMVPMatrixID = -1;
     glm::mat4 mMVPMatrix;
 
+	static std::shared_ptr<Shader> AcquireShader();
+
 	void Arc(int x, int y, int r, float begin, float end, float step);
 	void AddVert(GLfloat x, GLfloat y);
 	void CalcInds();
@@ -515,6 +722,16 @@ private:
 
 class WorkspaceComponent {
 public:
+    // When WorkspaceContainer calls Draw(). Between draws the last output is presented from
+    // the component's layer (see SetLayerCached), which every policy but EVERY_FRAME implies.
+    enum class UpdatePolicy {
+        EVERY_FRAME,    // Whenever the container draws (or, when layer cached, when stale).
+        FIXED_RATE,     // At most `hz` times a second, and straight away after a resize.
+        ON_DIRTY,       // Only when the layer is stale: InvalidateLayer, resize, LayerVersion().
+        WHEN_VISIBLE,   // As EVERY_FRAME, but not at all while hidden: collapsed to nothing,
+                        // or in a container marked occluded (WorkspaceContainer::SetOccluded).
+    };
+
 	WorkspaceComponent() {}
     virtual ~WorkspaceComponent() {}
 
@@ -522,6 +739,44 @@ public:
     //virtual void Register() = 0;
     virtual void Draw() = 0;
 
+    // Opt-in layer caching (see LayerCache): the container keeps what Draw() produced in an
+    // offscreen texture and reuses it until InvalidateLayer, a resize, a change of
+    // LayerVersion() or a hover change on one of its widgets. For mostly static panels.
+    void SetLayerCached(bool cached) { mLayerCached = cached; }
+    bool IsLayerCached() const { return mLayerCached; }
+    void InvalidateLayer() {
+        mLayerDirty = true;
+        UI::PostInvalidate();
+    }
+    // Returns true once after InvalidateLayer. Used by WorkspaceContainer.
+    bool ConsumeLayerDirty() { return std::exchange(mLayerDirty, false); }
+    // Override to return something that changes with the models the component shows (e.g. a
+    // revision counter), so edits to them redraw the cached layer without InvalidateLayer.
+    virtual std::uint64_t LayerVersion() const { return 0; }
+
+    void SetUpdatePolicy(UpdatePolicy policy, double hz = 0.0) {
+        mUpdatePolicy = policy;
+        mUpdateRate = hz;
+    }
+    UpdatePolicy GetUpdatePolicy() const { return mUpdatePolicy; }
+    double GetUpdateRate() const { return mUpdateRate; }
+    // Under a frame budget (WorkspaceContainer::SetFrameBudget) higher priorities are drawn
+    // first and the rest wait, showing their last output, until there is time for them.
+    void SetUpdatePriority(int priority) { mUpdatePriority = priority; }
+    int GetUpdatePriority() const { return mUpdatePriority; }
+
+    // Saved with the layout (WorkspaceContainer::SaveLayout) and handed back to LoadState
+    // when the restored workspace is created. Override to keep view state across sessions,
+    // such as a scroll position or camera; the format is the component's own.
+    virtual std::vector<std::uint8_t> SaveState() const { return {}; }
+    virtual void LoadState(const std::vector<std::uint8_t>& /*state*/) {}
+
+private:
+    bool mLayerCached = false;
+    bool mLayerDirty = false;
+    UpdatePolicy mUpdatePolicy = UpdatePolicy::EVERY_FRAME;
+    double mUpdateRate = 0.0;
+    int mUpdatePriority = 0;
 };
 
 
@@ -8,18 +8,16 @@
 class VAO
 {
 public:
-	// ID reference for the Vertex Array Object
-	GLuint ID;
-	// Constructor that generates a VAO ID
+	// ID reference for the Vertex Array Object (0 until first use)
+	GLuint ID = 0;
+	// Constructor. The VAO ID is generated lazily on first use
 	VAO();
 	// Links a VBO to the VAO using a certain layout
 	void LinkAttrib(VBO& VBO, GLuint layout, GLuint numComponents, GLenum type, GLsizeiptr stride, void* offset);
 	// Binds the VAO
-	void Bind() const;
+	void Bind();
 	// Unbinds the VAO
 	void Unbind() const;
 	// Deletes the VAO
-	~VAO() {
-		glDeleteVertexArrays(1, &ID);
-	}
+	~VAO();
 };
@@ -8,9 +8,9 @@
 class VBO
 {
 public:
-	// Reference ID of the Vertex Buffer Object
-	GLuint ID;
-	// Constructor that generates a Vertex Buffer Object and links it to vertices
+	// Reference ID of the Vertex Buffer Object (0 until first use)
+	GLuint ID = 0;
+	// Constructor. The buffer ID is generated lazily on first use
 	VBO();
 	// Set new data in the VBO
 	void Data(const std::vector<GLfloat>& vertices);
@@ -21,7 +21,5 @@ public:
 	// Unbinds the VBO
 	void Unbind();
 	// Deletes the VBO
-	~VBO() {
-		glDeleteBuffers(1, &ID);
-	}
+	~VBO();
 };
@@ -0,0 +1,72 @@
+// Copyright (c) 2025 Thomas Groom
+
+#pragma once
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "ui_library/Config.h"
+#include "Utils.h"
+
+
+class IconAtlas;
+
+
+// Outline of a vector icon in viewBox units, as parsed from a subset of SVG:
+// <svg viewBox="..."> containing <path d="..."> elements with M/L/H/V/C/S/Q/T/Z commands
+// (absolute and relative), optional fill="#rrggbb" and fill-rule="evenodd".
+// Paths without a fill colour are white so that DrawSprite's colour tints them.
+struct VectorOutline {
+    enum class Op : std::uint8_t { Move, Line, Quad, Cubic, Close };
+
+    struct Path {
+        std::vector<Op> ops;
+        std::vector<glm::vec2> points;   // 1 per Move/Line, 2 per Quad, 3 per Cubic.
+        glm::vec4 fill = glm::vec4(1.0f);
+        bool evenOdd = false;
+    };
+
+    glm::vec4 viewBox = glm::vec4(0.0f, 0.0f, 24.0f, 24.0f);   // x, y, width, height.
+    std::vector<Path> paths;
+
+    static bool ParseSvg(const std::string& svg, VectorOutline& out);
+    // Rasterises to straight-alpha RGBA8 at exactly width x height pixels.
+    std::vector<unsigned char> Rasterise(int width, int height) const;
+};
+
+
+// An icon rasterised from vector data at exactly the pixel size it is drawn at.
+//
+// Drop-in alternative to a Texture2D icon: rendering happens on a worker thread the first
+// time a size is requested, and the result is cached per (icon, size) in an atlas texture
+// shared by all icons. Until a size is ready the closest size already rasterised is drawn
+// scaled, so icons never pop in blank. UI coordinates are framebuffer pixels, so high-DPI
+// displays get a correspondingly larger (and equally crisp) raster.
+class VectorIcon
+{
+public:
+    VectorIcon(const std::filesystem::path& svgFile);
+    ~VectorIcon();
+
+    VectorIcon(const VectorIcon&) = delete;
+    VectorIcon& operator=(const VectorIcon&) = delete;
+
+    // Draws the icon fitted inside desiredSize and snapped to whole pixels. Icons are rasterised
+    // 1:1 into the atlas, so they are not rotated.
+    void DrawSprite(glm::vec2 position, glm::vec2 desiredSize, float z = 0.0f, glm::vec3 color = glm::vec3(1.0f));
+
+    bool IsValid() const { return mValid; }
+
+    glm::vec2 mFitSize = glm::vec2(20.0f, 20.0f);
+
+private:
+    std::shared_ptr<const VectorOutline> mOutline;
+    std::shared_ptr<IconAtlas> mAtlas;
+    std::uint32_t mIconID;
+    bool mValid = false;
+};
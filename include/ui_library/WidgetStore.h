@@ -0,0 +1,57 @@
+// Copyright (c) 2025 Thomas Groom
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+
+class MouseHandler;
+struct Boundary;
+
+
+// Structure-of-arrays store of the per-widget data that the per-frame passes read: bounds,
+// z, layer, flags and a state ID, one row per widget. Passes over many widgets (hit testing,
+// the end of frame reset) iterate these columns linearly instead of visiting each
+// polymorphic widget on the heap; the owner is only dereferenced for the widgets a pass
+// selects.
+//
+// MouseHandler uses one store for the widgets drawn each frame: SetDrawn writes the row and
+// the store is cleared after input has been granted, so each widget keeps only its row index.
+class WidgetStore
+{
+public:
+    enum Flags : std::uint8_t {
+        ALIVE = 1 << 0,        // Cleared when the owner is destroyed mid-frame.
+        PIXEL_PICK = 1 << 1,   // Hit only where the GPU pick buffer reports this widget.
+        NEAR = 1 << 2,         // Owner tracks whether the cursor is within its near margin.
+    };
+
+    std::uint32_t Add(MouseHandler* owner, const Boundary& bounds, float z, int layer, std::uint32_t stateId, std::uint8_t flags = 0);
+    void Update(std::uint32_t row, const Boundary& bounds, float z, int layer);
+    // Keeps the row (indices stay stable) but excludes it from every pass.
+    void Kill(std::uint32_t row);
+    void Clear();
+    void Reserve(std::size_t count);
+
+    std::size_t Size() const { return mOwner.size(); }
+    bool IsAlive(std::uint32_t row) const { return (mFlags[row] & ALIVE) != 0; }
+    // True if `other` has a row at `row` with the same bounds, z, layer, flags and state ID
+    // (owners are not compared).
+    bool SameRow(std::uint32_t row, const WidgetStore& other) const;
+
+    // Appends the rows whose bounds strictly contain (px, py), in row order. The loop has no
+    // data-dependent branches, so the compiler can vectorise it.
+    void HitTest(int px, int py, std::vector<std::uint32_t>& out) const;
+
+    // Columns. Bounds are stored as edges so a containment test is four compares.
+    std::vector<std::int32_t> mLeft;
+    std::vector<std::int32_t> mTop;
+    std::vector<std::int32_t> mRight;
+    std::vector<std::int32_t> mBottom;
+    std::vector<float> mZ;
+    std::vector<std::int32_t> mLayer;
+    std::vector<std::uint8_t> mFlags;
+    std::vector<std::uint32_t> mStateId;
+    std::vector<MouseHandler*> mOwner;
+};
@@ -10,9 +10,14 @@
 #include <any>
 #include <unordered_map>
 #include <string>
+#include <vector>
+#include <cstdint>
+#include <filesystem>
 
 #include "Button.h"
 #include "DropdownButton.h"
+#include "DrawList.h"
+#include "LayerCache.h"
 #include "ui_library/Config.h"
 
 // A constant offset for the Y-coordinate in layout.
@@ -56,50 +61,167 @@ public:
     WorkspaceContainer(UI* _ui, Bounds _b = Bounds(), const ModelMap& models = ModelMap());
     ~WorkspaceContainer();
 
-    // Sets the current workspace using a registered factory.
+    // Sets the current workspace using a registered factory. The workspace is created when
+    // the leaf is first drawn visible with a non-zero size, not straight away.
     void setWorkspace(int workspaceType);
-    // Splits the container (horizontally or vertically) into two child containers.
+    // Splits the container (horizontally or vertically) into two child containers, `_split`
+    // of the way across it.
     void split(bool _type, double _split);
-    // Recursively draws this container (or its children) to the screen.
+    // Splits the container into fractions.size() + 1 children, divided at `fractions` (0 to 1
+    // across the container, ascending).
+    void split(bool _type, const std::vector<double>& fractions);
+    std::size_t getChildCount() const { return mChildren.size(); }
+    WorkspaceContainer& getChild(std::size_t index) { return *mChildren[index]; }
+
+    // Draws the tree under `node` to the screen and handles dragging its splits. Pixel
+    // rectangles are only recomputed when the window size, a split or the tree changes.
     void DrawContainers(WorkspaceContainer& node);
 
+    // Records each leaf into its own DrawList on the job system, then submits the lists on
+    // this thread. Leaves must draw only through Primitive, Text, the texture and icon classes
+    // and DrawList, and must not create or destroy widgets while drawing. Off by default.
+    static void SetParallelRecording(bool enabled) { sParallelRecording = enabled; }
+
+    // Caches every leaf under this container in an offscreen layer (see LayerCache), as if
+    // each component had called SetLayerCached. Children created by split inherit it.
+    void SetLayerCached(bool cached);
+    // Redraws the cached leaves under this container next frame.
+    void InvalidateLayers();
+    // Marks the leaves under this container as covered (e.g. by a full-screen overlay), which
+    // pauses those with the WHEN_VISIBLE update policy.
+    void SetOccluded(bool occluded);
+
+    // Time the stale leaves may take to draw each frame, estimated from their recent draws.
+    // Leaves over it that have output to show keep showing it, lowest priority first (see
+    // WorkspaceComponent::SetUpdatePriority), and are drawn in a later frame. 0 (the default)
+    // draws every stale leaf.
+    static void SetFrameBudget(double milliseconds) { sFrameBudget = milliseconds / 1000.0; }
+
+    // Layout snapshots: the split tree under this container, each leaf's workspace type and
+    // its component's SaveState(), in a compact versioned binary format. Leaves whose
+    // workspace was never created keep the state they were restored with.
+    std::vector<std::uint8_t> SaveLayout() const;
+    // Replaces the tree under this container with a snapshot. Workspaces are created lazily,
+    // as by setWorkspace, and then given their saved state. Returns false, leaving the tree
+    // as it was, if the snapshot is malformed or from a newer version.
+    bool LoadLayout(const std::vector<std::uint8_t>& data);
+    bool SaveLayoutFile(const std::filesystem::path& file) const;
+    bool LoadLayoutFile(const std::filesystem::path& file);
+
     // Public members for convenience.
     GLFWwindow* mWindow;
-    std::unique_ptr<WorkspaceContainer> A;
-    std::unique_ptr<WorkspaceContainer> B;
 
 private:
+    struct LeafRegion {
+        WorkspaceContainer* node;
+        int x, y, xEnd, yEnd;
+        bool update = true;    // Call the workspace's Draw() this frame.
+        bool hidden = false;   // Paused by its policy: draw nothing of the workspace.
+    };
+
+    // A parsed snapshot node (see LoadLayout).
+    struct LayoutNode;
+    struct LayoutReader;
+
+    // A draggable line between two children, in pixels.
+    struct Splitter {
+        WorkspaceContainer* node;
+        std::size_t index;     // Between children index and index + 1.
+        bool vertical;         // A vertical line, dragged along x.
+        int position;
+        int from, to;          // Extent along the line.
+    };
+
     UI* mUI;
-    // Draws this container into a specified pixel region.
-    void Draw(int x, int y, int w, int h);
-    // Used to constrain split resizing: recursively calculates bounds.
-    Bounds recursiveMinMaxSearch(const WorkspaceContainer& node);
+    // Recomputes the cached leaves and splitters if the tree or a split changed since.
+    void RefreshLayout(WorkspaceContainer& node);
+    // Recomputes the pixel rectangles of the leaves and splitters under `node`.
+    void LayoutContainers(WorkspaceContainer& node);
+    // Starts, continues and ends split drags using the cached splitters.
+    void UpdateSplitDrag();
+    // Moves split `index` to `position` (window-relative), kept at least 30 pixels from the
+    // splits inside either neighbour. Returns true if it moved.
+    bool MoveSplit(std::size_t index, double position);
+    // Re-applies the 30 pixel limits to every split under this container, after a resize.
+    void ClampSplits();
+    // Sets the children's bounds from this container's bounds and splits, recursively.
+    void ApplyBounds();
+    void ApplyChildBounds(std::size_t index);
+    // The innermost edges of the leaves under this container: the largest W and N and the
+    // smallest E and S. Cached, and invalidated along the paths of moved splits.
+    const Bounds& Extents();
+    void InvalidateExtentsUp();
+    void InvalidateExtentsDown();
+    // Applies each leaf workspace's update policy and the frame budget, deciding which leaves
+    // call Draw() this frame and which show their cached layer.
+    void ScheduleLeaves(std::vector<LeafRegion>& leaves);
+    // Draws this container into its leaf region.
+    void Draw(const LeafRegion& leaf);
+    static DrawList::Rect LeafArea(const LeafRegion& leaf);
+    // True if the leaf workspace is drawn through mLayer.
+    bool IsLayered() const;
+    // The Text shared by every container's selector buttons.
+    static std::shared_ptr<Text> SharedText();
+    // Create what a leaf needs on its first visible frame; UI thread.
+    void CreateSelector();
+    void CreateWorkspace();
+
+    void WriteLayout(std::vector<std::uint8_t>& out) const;
+    static bool ReadLayout(LayoutReader& reader, LayoutNode& node, int depth);
+    void ApplyLayout(const LayoutNode& node);
 
     // The generic model container used by workspaces.
     ModelMap models;
     // The actual workspace (leaf)  a subclass of WorkspaceComponent.
     std::unique_ptr<WorkspaceComponent> LeafWorkspace;
 
-    // A selector button for choosing the workspace type.
-    DropdownButton* WS_Selector_Button;
-    std::shared_ptr<Texture2D> fileNewIcon;
+    // A selector button for choosing the workspace type; leaves only, created when first drawn.
+    DropdownButton* WS_Selector_Button = nullptr;
+    std::shared_ptr<VectorIcon> fileNewIcon;
     // The container boundary used by the contained workspace.
     Boundary mContainer = Boundary(0, 0, 10, 10);
     // The layout bounds (in relative coordinates).
     Bounds boundingBox;
 
-    int mWorkspaceType;
+    int mWorkspaceType = -1;
+    std::vector<std::uint8_t> mPendingState;   // Restored state for the workspace not yet created.
     bool type;          // true = horizontal split, false = vertical split.
-    double splitRatio;  // Split ratio (0.0 to 1.0).
+    std::vector<double> mSplits;   // Split positions (0.0 to 1.0 of the window), ascending.
+    std::vector<std::unique_ptr<WorkspaceContainer>> mChildren;
+    WorkspaceContainer* mParent = nullptr;
     bool isLeaf;
-    bool isResizing;
+
+    Bounds mExtents;
+    bool mExtentsValid = false;
+
+    // Layout cache, kept by the container DrawContainers is called on.
+    std::vector<LeafRegion> mLeaves;
+    std::vector<Splitter> mSplitters;
+    WorkspaceContainer* mLayoutRoot = nullptr;
+    int mLayoutWidth = -1;
+    int mLayoutHeight = -1;
+    std::uint64_t mLayoutGeneration = 0;
+    std::uint64_t mTreeGeneration = 0;
+    WorkspaceContainer* mDragNode = nullptr;
+    std::size_t mDragIndex = 0;
 
     Primitive mPrim;
-    std::shared_ptr<Text> UIText = std::make_shared<Text>(std::string(UI_LIBRARY_RESOURCES_DIR) + "/fonts/arial.ttf", 12);
+    DrawList mDrawList;   // This leaf's commands when recording in parallel.
+    LayerCache mLayer;    // This leaf's workspace, when layer cached.
+    bool mLayerCached = false;
+    bool mOccluded = false;
+    double mNextUpdate = 0.0;   // FIXED_RATE: when the workspace is next due.
+    double mDrawCost = 0.0;     // Seconds, smoothed over recent Draw() calls.
+    int mDeferredFrames = 0;    // Frames in a row the budget has deferred it.
+    std::shared_ptr<Text> UIText = SharedText();
 
     // Static containers for workspace registrations and prototype buttons.
     static std::unordered_map<int, WorkspaceRegistration> sWorkspaceRegistrations;
     static std::map<std::string, std::shared_ptr<Button>> Buttons;
+    static bool sParallelRecording;
+    static double sFrameBudget;   // Seconds.
+    static std::uint64_t sLayoutGeneration;   // Bumped by any split or structure change.
+    static std::uint64_t sTreeGeneration;     // Bumped when containers are created or destroyed.
 };
 
 
@@ -0,0 +1,13 @@
+#version 330 core
+layout (location = 0) in vec4 vertex; // <vec2 position, vec2 texCoords>
+
+out vec2 TexCoords;
+
+uniform mat4 projection;
+uniform float z;
+
+void main()
+{
+    TexCoords = vertex.zw;
+    gl_Position = projection * vec4(vertex.xy, z, 1.0);
+}
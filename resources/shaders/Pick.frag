@@ -0,0 +1,9 @@
+#version 330 core
+out uint pickId;
+
+uniform uint id;
+
+void main()
+{
+   pickId = id;
+}
@@ -0,0 +1,12 @@
+#version 330 core
+in vec2 TexCoords;
+out vec4 color;
+
+uniform sampler2DArray image;
+uniform float layer;
+uniform vec3 spriteColor;
+
+void main()
+{
+    color = vec4(spriteColor, 1.0) * texture(image, vec3(TexCoords, layer));
+}
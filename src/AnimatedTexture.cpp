@@ -0,0 +1,348 @@
+// Copyright (c) 2025 Thomas Groom
+
+
+#include "ui_library/AnimatedTexture.h"
+#include "ui_library/RenderThread.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <ui_library/stb_image.h>
+#include <ui_library/stb_image_resize2.h>
+
+#include "ui_library/GifStream.h"
+
+
+// GIF delays below this are treated as the browser default; many files store 0 or 1.
+static constexpr int kMinGifDelayMs = 20;
+static constexpr int kDefaultGifDelayMs = 100;
+
+
+AnimatedTexture2D::AnimatedTexture2D(const std::filesystem::path& gifFile, int residentFrames)
+    : mGifFile(gifFile), mResidentFrames(std::max(residentFrames, 2)) {
+    Init();
+    mWorker = std::thread(&AnimatedTexture2D::DecodeGif, this);
+}
+
+
+AnimatedTexture2D::AnimatedTexture2D(const std::vector<std::filesystem::path>& frameFiles, double frameInterval, int residentFrames)
+    : mFrameFiles(frameFiles), mFrameInterval(std::max(frameInterval, 0.001)), mResidentFrames(std::max(residentFrames, 2)) {
+    Init();
+    mWorker = std::thread(&AnimatedTexture2D::DecodeSequence, this);
+}
+
+
+AnimatedTexture2D::~AnimatedTexture2D() {
+    {
+        std::lock_guard<std::mutex> lock(mQueueMutex);
+        mStop = true;
+    }
+    mQueueCondVar.notify_all();
+    if (mWorker.joinable()) {
+        mWorker.join();
+    }
+    if (mArrayID != 0) {
+        GLuint id = mArrayID;
+        RenderThread::RunOnGLThread([id] { glDeleteTextures(1, &id); });
+    }
+}
+
+
+// Only CPU-side setup; GL objects are created on first draw.
+void AnimatedTexture2D::Init() {
+    mShader.Set((std::string(UI_LIBRARY_RESOURCES_DIR) + "/shaders/Sprite.vert").c_str(), (std::string(UI_LIBRARY_RESOURCES_DIR) + "/shaders/SpriteArray.frag").c_str());
+    mLayers.resize(mResidentFrames);
+}
+
+
+void AnimatedTexture2D::InitGL() {
+    std::vector<GLfloat> vertices = {
+        // pos      // tex
+        0.0f, 1.0f, 0.0f, 1.0f,
+        1.0f, 0.0f, 1.0f, 0.0f,
+        0.0f, 0.0f, 0.0f, 0.0f,
+
+        0.0f, 1.0f, 0.0f, 1.0f,
+        1.0f, 1.0f, 1.0f, 1.0f,
+        1.0f, 0.0f, 1.0f, 0.0f
+    };
+
+    mVBO.Data(vertices);
+    mVAO.Bind();
+    mVAO.LinkAttrib(mVBO, 0, 4, GL_FLOAT, 4 * sizeof(float), (void*)0);
+    mVAO.Unbind();
+    mGLReady = true;
+}
+
+
+// ---------------------------------------------------------------------------
+// Worker thread: incremental decoding
+// ---------------------------------------------------------------------------
+
+// Blocks until there is room in the queue. Returns false if the texture is being destroyed.
+bool AnimatedTexture2D::PushFrame(Frame&& frame) {
+    std::unique_lock<std::mutex> lock(mQueueMutex);
+    mQueueCondVar.wait(lock, [this]() { return mStop || mPending.size() < kMaxPending; });
+    if (mStop) return false;
+    mPending.push_back(std::move(frame));
+    lock.unlock();
+    UI::PostInvalidate();
+    return true;
+}
+
+
+void AnimatedTexture2D::DecodeGif() {
+    std::ifstream in(mGifFile, std::ios::binary);
+    std::vector<unsigned char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    GifStream gif(data.data(), static_cast<int>(data.size()));
+    data = {};
+
+    if (!gif.IsValid()) {
+        std::cerr << "Could not open or decode the GIF: " << mGifFile.string() << std::endl;
+    }
+
+    long long sequence = 0;
+    int framesPerLoop = 0;
+    while (gif.IsValid()) {
+        const unsigned char* rgba = nullptr;
+        int width = 0, height = 0, delayMs = 0;
+        if (!gif.Next(rgba, width, height, delayMs)) {
+            // End of the animation. A still image or a one-shot animation needs no more frames.
+            if (framesPerLoop <= 1 || !mLooping.load()) break;
+            gif.Rewind();
+            framesPerLoop = 0;
+            continue;
+        }
+        ++framesPerLoop;
+
+        if (delayMs < kMinGifDelayMs) delayMs = kDefaultGifDelayMs;
+        Frame frame{ sequence++, width, height, delayMs / 1000.0,
+                     std::vector<unsigned char>(rgba, rgba + static_cast<size_t>(width) * height * 4) };
+        if (!PushFrame(std::move(frame))) return;
+    }
+
+    std::lock_guard<std::mutex> lock(mQueueMutex);
+    mDecodeFinished = true;
+}
+
+
+void AnimatedTexture2D::DecodeSequence() {
+    long long sequence = 0;
+    int width = 0, height = 0;
+    int decodedPerLoop = 0;
+
+    for (size_t i = 0; !mFrameFiles.empty(); ++i) {
+        if (i == mFrameFiles.size()) {
+            if (decodedPerLoop <= 1 || !mLooping.load()) break;
+            i = 0;
+            decodedPerLoop = 0;
+        }
+
+        int w = 0, h = 0, channels = 0;
+        unsigned char* pixels = stbi_load(mFrameFiles[i].string().c_str(), &w, &h, &channels, 4);
+        if (!pixels) {
+            std::cerr << "Could not open or find the image: " << mFrameFiles[i].string() << std::endl;
+            continue;
+        }
+        ++decodedPerLoop;
+
+        // Every layer of the array has the size of the first frame.
+        if (width == 0) {
+            width = w;
+            height = h;
+        }
+        Frame frame{ sequence++, width, height, mFrameInterval,
+                     std::vector<unsigned char>(static_cast<size_t>(width) * height * 4) };
+        if (w == width && h == height) {
+            std::copy(pixels, pixels + frame.pixels.size(), frame.pixels.begin());
+        } else {
+            stbir_resize(pixels, w, h, w * 4, frame.pixels.data(), width, height, width * 4,
+                         STBIR_RGBA, STBIR_TYPE_UINT8, STBIR_EDGE_CLAMP, STBIR_FILTER_DEFAULT);
+        }
+        stbi_image_free(pixels);
+
+        if (!PushFrame(std::move(frame))) return;
+    }
+
+    std::lock_guard<std::mutex> lock(mQueueMutex);
+    mDecodeFinished = true;
+}
+
+
+// ---------------------------------------------------------------------------
+// UI thread: playback
+// ---------------------------------------------------------------------------
+
+// Moves decoded frames into free layers of the ring. A layer is free once the frame it holds
+// has been displayed and replaced, so at most mResidentFrames - 1 frames are buffered ahead.
+// Their pixels are handed to the next draw, which uploads them on the GL thread.
+void AnimatedTexture2D::AcceptFrames() {
+    bool accepted = false;
+    while (mAccepted - std::max(mDisplayed, 0LL) < mResidentFrames - 1) {
+        Frame frame;
+        {
+            std::lock_guard<std::mutex> lock(mQueueMutex);
+            if (mPending.empty()) break;
+            frame = std::move(mPending.front());
+            mPending.pop_front();
+        }
+        accepted = true;
+
+        if (mWidth == 0) {
+            mWidth = frame.width;
+            mHeight = frame.height;
+        }
+
+        // A frame not yet uploaded is dropped if a later one takes its layer before any draw.
+        int layer = static_cast<int>(frame.sequence % mResidentFrames);
+        mStaged.erase(std::remove_if(mStaged.begin(), mStaged.end(), [this, layer](const Frame& staged) {
+            return staged.sequence % mResidentFrames == layer;
+        }), mStaged.end());
+
+        mLayers[layer] = { frame.sequence, frame.delay };
+        mAccepted = frame.sequence;
+        mStaged.push_back(std::move(frame));
+    }
+
+    if (accepted) {
+        mQueueCondVar.notify_all();  // Room in the queue for the worker.
+    }
+}
+
+
+bool AnimatedTexture2D::Update(double time) {
+    AcceptFrames();
+
+    if (mAccepted < 0) return false;
+
+    if (mDisplayed < 0) {
+        mDisplayed = 0;
+        mFrameDeadline = time + mLayers[0].delay;
+        mClockStarted = true;
+        return true;
+    }
+
+    if (!mPlaying) return false;
+    if (!mClockStarted) {
+        // Resuming after Pause(): show the current frame for its full delay again.
+        mFrameDeadline = time + mLayers[mDisplayed % mResidentFrames].delay;
+        mClockStarted = true;
+        return false;
+    }
+
+    bool changed = false;
+    while (time >= mFrameDeadline && mDisplayed < mAccepted) {
+        ++mDisplayed;
+        mFrameDeadline += mLayers[mDisplayed % mResidentFrames].delay;
+        changed = true;
+    }
+    // After a stall (minimised window, slow decode) restart the clock rather than fast-forwarding.
+    if (time >= mFrameDeadline) {
+        mFrameDeadline = time + mLayers[mDisplayed % mResidentFrames].delay;
+    }
+
+    if (changed) {
+        AcceptFrames();  // The previous frame's layer is free now.
+    }
+    return changed;
+}
+
+
+double AnimatedTexture2D::NextFrameTime() const {
+    if (mDisplayed < 0 || !mPlaying) return -1.0;
+    if (mDisplayed >= mAccepted) {
+        std::lock_guard<std::mutex> lock(mQueueMutex);
+        if (mDecodeFinished && mPending.empty()) return -1.0;
+    }
+    return mFrameDeadline;
+}
+
+
+void AnimatedTexture2D::DrawSprite(glm::vec2 position, glm::vec2 desiredSize, float z, glm::vec3 color) {
+    if (mDisplayed < 0) return;
+
+    // Fit the frame inside the desired size, keeping its aspect ratio.
+    float scale = std::min(desiredSize.x / mWidth, desiredSize.y / mHeight);
+    mFitSize = glm::vec2(std::floor(mWidth * scale), std::floor(mHeight * scale));
+    glm::vec2 topLeft = position + ((desiredSize - mFitSize) / 2.0f);
+    glm::vec2 fitSize = mFitSize;
+    int layer = static_cast<int>(mDisplayed % mResidentFrames);
+
+    // Every layer the frame shown here may need is uploaded before it is drawn, and no later.
+    auto uploads = std::make_shared<std::vector<Frame>>();
+    uploads->swap(mStaged);
+
+    // Draws the same until another frame is displayed.
+    DrawList::Hasher key;
+    key.Add(this).Add(mDisplayed).Add(desiredSize).Add(z).Add(color);
+    DrawList::Defer([this, uploads, topLeft, fitSize, z, color, layer] { DrawLayer(*uploads, topLeft, fitSize, z, color, layer); },
+                    DrawList::Rect::Covering(position, desiredSize), key.Value());
+}
+
+
+// ---------------------------------------------------------------------------
+// GL thread: residency and drawing
+// ---------------------------------------------------------------------------
+void AnimatedTexture2D::CreateArray(int width, int height) {
+    glGenTextures(1, &mArrayID);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, mArrayID);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, mResidentFrames, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+
+void AnimatedTexture2D::UploadFrames(const std::vector<Frame>& frames) {
+    for (const Frame& frame : frames) {
+        if (mArrayID == 0) {
+            CreateArray(frame.width, frame.height);
+        }
+        int layer = static_cast<int>(frame.sequence % mResidentFrames);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, mArrayID);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, frame.width, frame.height, 1, GL_RGBA, GL_UNSIGNED_BYTE, frame.pixels.data());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    }
+}
+
+
+void AnimatedTexture2D::DrawLayer(const std::vector<Frame>& uploads, glm::vec2 position, glm::vec2 size, float z, glm::vec3 color, int layer) {
+    if (!mGLReady) InitGL();
+    UploadFrames(uploads);
+    if (mArrayID == 0) return;
+
+    mShader.Bind();
+    mShader.SetInteger("image", 0);
+    int wWidth = 0;
+    int wHeight = 0;
+    DrawList::GetTargetSize(wWidth, wHeight);
+    glm::mat4 projection = glm::ortho(0.0f, static_cast<float>(wWidth), static_cast<float>(wHeight), 0.0f, -1.0f, 1.0f);
+    mShader.SetMatrix4("projection", projection);
+
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::translate(model, glm::vec3(position, z));
+    model = glm::scale(model, glm::vec3(size, 1.0f));
+
+    mShader.SetMatrix4("model", model);
+    mShader.SetVector3f("spriteColor", color);
+    mShader.SetFloat("layer", static_cast<float>(layer));
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, mArrayID);
+
+    mVAO.Bind();
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    mVAO.Unbind();
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    mShader.Unbind();
+}
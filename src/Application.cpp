@@ -1,8 +1,23 @@
 #include "ui_library/Application.h"
+#include "ui_library/StartupTrace.h"
+#include "ui_library/PickBuffer.h"
+#include "ui_library/DamageTracker.h"
+#include "ui_library/BackBuffer.h"
+#include "ui_library/CommandQueue.h"
+#include "ui_library/Task.h"
 
 
 // Static callbacks that forward to the singleton instance.
 void Application::handleMouseButton(GLFWwindow* window, int button, int action, int mods) {
+    double time = glfwGetTime();
+    mUIContext->Invalidate();
+    mFramePacer.MarkInput(time);
+    InputEvent event{ InputEvent::MOUSE_BUTTON, time };
+    event.key = button;
+    event.action = action;
+    event.mods = mods;
+    glfwGetCursorPos(window, &event.x, &event.y);
+    mUIContext->G_EVENTS.Push(event);
     if (button == GLFW_MOUSE_BUTTON_LEFT)
         mUIContext->G_LEFT_MOUSE_STATE = action;
     if (button == GLFW_MOUSE_BUTTON_MIDDLE)
@@ -12,6 +27,15 @@ void Application::handleMouseButton(GLFWwindow* window, int button, int action,
 }
 
 void Application::handleKey(GLFWwindow* window, int key, int scancode, int action, int mods) {
+    double time = glfwGetTime();
+    mUIContext->Invalidate();
+    mFramePacer.MarkInput(time);
+    InputEvent event{ InputEvent::KEY, time };
+    event.key = key;
+    event.scancode = scancode;
+    event.action = action;
+    event.mods = mods;
+    mUIContext->G_EVENTS.Push(event);
     if (key == GLFW_KEY_LEFT_SHIFT || key == GLFW_KEY_RIGHT_SHIFT) {
         if (action == GLFW_PRESS) {
             mUIContext->G_SHIFT_PRESS = true;
@@ -68,16 +92,45 @@ void Application::handleKey(GLFWwindow* window, int key, int scancode, int actio
 }
 
 void Application::handleScroll(GLFWwindow* window, double xoffset, double yoffset) {
-    mUIContext->G_SCROLL_X = xoffset;
-    mUIContext->G_SCROLL_Y = yoffset;
+    double time = glfwGetTime();
+    mUIContext->Invalidate();
+    mFramePacer.MarkInput(time);
+    InputEvent event{ InputEvent::SCROLL, time };
+    event.x = xoffset;
+    event.y = yoffset;
+    mUIContext->G_EVENTS.Push(event);
+
+    // Accumulate so several wheel steps in one frame are not collapsed into one.
+    if (!mUIContext->G_SCROLL_TRIGGER) {
+        mUIContext->G_SCROLL_X = 0;
+        mUIContext->G_SCROLL_Y = 0;
+    }
+    mUIContext->G_SCROLL_X += xoffset;
+    mUIContext->G_SCROLL_Y += yoffset;
     mUIContext->G_SCROLL_TRIGGER = true;
 }
 
 void Application::handleCharacter(GLFWwindow* window, unsigned int codepoint) {
+    double time = glfwGetTime();
+    mUIContext->Invalidate();
+    mFramePacer.MarkInput(time);
+    InputEvent event{ InputEvent::CHAR, time };
+    event.codepoint = static_cast<char32_t>(codepoint);
+    mUIContext->G_EVENTS.Push(event);
     mUIContext->G_CHAR_INPUT = static_cast<char>(codepoint);
     mUIContext->G_CHAR_CALLBACK_FLAG = true;
 }
 
+void Application::handleCursorPos(GLFWwindow* window, double x, double y) {
+    double time = glfwGetTime();
+    mUIContext->Invalidate();
+    mUIContext->G_MOUSE_HISTORY.Add(time, x, y);
+    InputEvent event{ InputEvent::MOUSE_MOVE, time };
+    event.x = x;
+    event.y = y;
+    mUIContext->G_EVENTS.Push(event);
+}
+
 void Application::handleFramebufferSize(GLFWwindow* window, int width, int height)
 {
 	// Only if not minimized
@@ -85,40 +138,134 @@ void Application::handleFramebufferSize(GLFWwindow* window, int width, int heigh
 		// make sure the viewport matches the new window dimensions
 		mUIContext->G_WIDTH = width;
 		mUIContext->G_HEIGHT = height;
-		glViewport(0, 0, mUIContext->G_WIDTH, mUIContext->G_HEIGHT);
+		if (!mRenderThread.IsRunning()) {
+			glViewport(0, 0, mUIContext->G_WIDTH, mUIContext->G_HEIGHT);  // Otherwise set from the frame packet.
+		}
 		mUIContext->G_RESIZE_FLAG = true;
+		InputEvent event{ InputEvent::RESIZE, glfwGetTime() };
+		event.x = width;
+		event.y = height;
+		mUIContext->G_EVENTS.Push(event);
 		
-		onUpdate();
-		glfwSwapBuffers(window);
+		drawFrame();
+		if (mRenderThread.IsRunning()) {
+			mRenderThread.SubmitPacket();
+			mRenderThread.Flush();  // Keep the window contents in step with the resize.
+		} else {
+			glfwSwapBuffers(window);
+		}
+		mUIContext->G_EVENTS.Clear();  // Consumed by the frame above.
 	}
 }
 
 
+// Runs onUpdate for one frame. With a render thread the frame is recorded into a packet for it
+// to draw; SetDrawn calls are applied here so hit testing stays on the UI thread.
+void Application::drawFrame() {
+	if (mRenderThread.IsRunning()) {
+		RenderThread::FramePacket& packet = mRenderThread.BeginPacket();
+		packet.width = mUIContext->G_WIDTH;
+		packet.height = mUIContext->G_HEIGHT;
+		packet.cursorX = static_cast<int>(mUIContext->G_MOUSE_X);
+		packet.cursorY = static_cast<int>(mUIContext->G_MOUSE_Y);
+		packet.frameStart = mFramePacer.GetFrameStart();
+		{
+			DrawList::Recording recording(&packet.drawList);
+			onUpdate();
+		}
+		packet.drawList.FlushDrawn();
+		DamageTracker& damage = DamageTracker::getInstance();
+		packet.partial = damage.IsEnabled();
+		if (packet.partial) {
+			packet.damage = damage.Collect(packet.drawList, packet.width, packet.height);
+		}
+		return;
+	}
+	PickBuffer& picker = PickBuffer::getInstance();
+	DamageTracker& damage = DamageTracker::getInstance();
+	if (damage.IsEnabled()) {
+		// Recorded first, so the changes can be found before anything is drawn.
+		mFrameList.Clear();
+		{
+			DrawList::Recording recording(&mFrameList);
+			onUpdate();
+		}
+		mFrameList.FlushDrawn();
+		std::vector<DrawList::Rect> rects = damage.Collect(mFrameList, mUIContext->G_WIDTH, mUIContext->G_HEIGHT);
+		picker.BeginFrame(static_cast<int>(mUIContext->G_MOUSE_X), static_cast<int>(mUIContext->G_MOUSE_Y), mUIContext->G_WIDTH, mUIContext->G_HEIGHT);
+		BackBuffer::getInstance().Draw(mFrameList, std::move(rects), mUIContext->G_WIDTH, mUIContext->G_HEIGHT);
+		picker.EndFrame();
+		return;
+	}
+	picker.BeginFrame(static_cast<int>(mUIContext->G_MOUSE_X), static_cast<int>(mUIContext->G_MOUSE_Y), mUIContext->G_WIDTH, mUIContext->G_HEIGHT);
+	onUpdate();
+	picker.EndFrame();
+}
+
+
+void Application::presentFrame() {
+	if (mRenderThread.IsRunning()) {
+		mRenderThread.SubmitPacket();
+	} else {
+		mFramePacer.Present(G_WINDOW);
+	}
+}
+
+
+// Blocks until something needs a frame: input (the GLFW callbacks invalidate), a UI::Invalidate
+// or InvalidateAt deadline from the previous frame, or a UI::PostInvalidate from another thread.
+void Application::waitForRedraw() {
+    while (running) {
+        if (UI::ConsumePostedInvalidate() || mUIContext->G_REDRAW) {
+            return;
+        }
+        double now = glfwGetTime();
+        double due = mUIContext->G_NEXT_REDRAW_TIME;
+        if (now >= due) {
+            return;
+        }
+        if (std::isinf(due)) {
+            glfwWaitEvents();
+        } else {
+            glfwWaitEventsTimeout(due - now);
+        }
+    }
+}
+
+
 void Application::run(const WindowSettings& settings, const GLFWimage* icon) {  // TODO: Allow user to set other settings rather than the hardcoded ones below VVV ALSO Add defaults for each
 	// Use the settings provided or fallback to defaults.
     mUIContext->G_WIDTH = settings.width;
     mUIContext->G_HEIGHT = settings.height;
 
-    // Initialize GLFW
-    if (!glfwInit()) {
-        throw std::runtime_error("Failed to initialize GLFW");
+    if (settings.printStartupTrace || !settings.startupTraceFile.empty()) {
+        StartupTrace::Begin();
     }
-	
-    // Set window hints based on user settings.
-    glfwWindowHint(GLFW_SAMPLES, settings.samples);
-    glfwSwapInterval(settings.vsyncEnabled ? 1 : 0);
-	
-    // Get monitor information (for future use if needed)
-    int monitorCount = 0;
-    GLFWmonitor** monitors = glfwGetMonitors(&monitorCount);
-    const GLFWvidmode* mode = (monitorCount > 0) ? glfwGetVideoMode(monitors[0]) : nullptr;
-
-    // Create the window using user-specified title and dimensions.
-    G_WINDOW = glfwCreateWindow(mUIContext->G_WIDTH, mUIContext->G_HEIGHT, settings.title.c_str(), nullptr, nullptr);
-    if (G_WINDOW == nullptr) {
-        throw std::runtime_error("Failed to create GLFW window");
+
+    {
+        StartupTrace::ScopedPhase phase("GLFW init");
+
+        // Initialize GLFW
+        if (!glfwInit()) {
+            throw std::runtime_error("Failed to initialize GLFW");
+        }
+
+        // Set window hints based on user settings.
+        // With partial redraw the offscreen BackBuffer is multisampled instead of the window.
+        glfwWindowHint(GLFW_SAMPLES, settings.partialRedraw ? 0 : settings.samples);
+
+        // Get monitor information (for future use if needed)
+        int monitorCount = 0;
+        GLFWmonitor** monitors = glfwGetMonitors(&monitorCount);
+        const GLFWvidmode* mode = (monitorCount > 0) ? glfwGetVideoMode(monitors[0]) : nullptr;
+
+        // Create the window using user-specified title and dimensions.
+        G_WINDOW = glfwCreateWindow(mUIContext->G_WIDTH, mUIContext->G_HEIGHT, settings.title.c_str(), nullptr, nullptr);
+        if (G_WINDOW == nullptr) {
+            throw std::runtime_error("Failed to create GLFW window");
+        }
+        glfwMakeContextCurrent(G_WINDOW);
     }
-    glfwMakeContextCurrent(G_WINDOW);
 
     // Optionally set the window icon if provided.
     if (icon) {
@@ -140,11 +287,23 @@ void Application::run(const WindowSettings& settings, const GLFWimage* icon) {
 	}
 
 	//gladLoadGL(); // Load OpenGL
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        throw std::runtime_error("Failed to initialize GLAD");
+    {
+        StartupTrace::ScopedPhase phase("GLAD");
+        if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+            throw std::runtime_error("Failed to initialize GLAD");
+        }
     }
     glViewport(0, 0, mUIContext->G_WIDTH, mUIContext->G_HEIGHT);
     glEnable(GL_MULTISAMPLE); // Enable MSAA
+
+    // The swap interval applies to the current context, so this must come after MakeContextCurrent
+    // (and after GLAD, as adaptive vsync is detected from the context's extensions).
+    mFramePacer.SetTargetFps(settings.targetFps);
+    mFramePacer.SetLowLatency(settings.lowLatency);
+    PickBuffer::getInstance().SetEnabled(settings.gpuPicking);
+    DamageTracker::getInstance().SetEnabled(settings.partialRedraw);
+    BackBuffer::getInstance().SetSamples(settings.samples);
+    mFramePacer.SetVsync(!settings.vsyncEnabled ? FramePacer::Vsync::Off : settings.adaptiveVsync ? FramePacer::Vsync::Adaptive : FramePacer::Vsync::On);
     glEnable(GL_SCISSOR_TEST);
 
     mCursorLUT[0] = nullptr;
@@ -171,6 +330,16 @@ void Application::run(const WindowSettings& settings, const GLFWimage* icon) {
     auto characterInputCallback = [](GLFWwindow* window, unsigned int codepoint) {
         static_cast<Application*>(glfwGetWindowUserPointer(window))->handleCharacter(window, codepoint);
     };
+    auto cursorPosCallback = [](GLFWwindow* window, double x, double y) {
+        static_cast<Application*>(glfwGetWindowUserPointer(window))->handleCursorPos(window, x, y);
+    };
+    // Exposure, focus changes and close requests all need a frame so onUpdate can react.
+    auto invalidateCallback = [](GLFWwindow* window) {
+        static_cast<Application*>(glfwGetWindowUserPointer(window))->mUIContext->Invalidate();
+    };
+    auto focusCallback = [](GLFWwindow* window, int /*focused*/) {
+        static_cast<Application*>(glfwGetWindowUserPointer(window))->mUIContext->Invalidate();
+    };
 
     // Set GLFW callbacks.
     glfwSetFramebufferSizeCallback(G_WINDOW, framebufferResizeCallback);
@@ -178,12 +347,23 @@ void Application::run(const WindowSettings& settings, const GLFWimage* icon) {
     glfwSetKeyCallback(G_WINDOW, keyInputCallback);
     glfwSetScrollCallback(G_WINDOW, scrollInputCallback);
     glfwSetCharCallback(G_WINDOW, characterInputCallback);
-	
-	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-		throw std::runtime_error("Failed to initialize GLAD");
-	}
-	
-    onInit();
+    glfwSetCursorPosCallback(G_WINDOW, cursorPosCallback);
+    glfwSetCursorEnterCallback(G_WINDOW, focusCallback);
+    glfwSetWindowFocusCallback(G_WINDOW, focusCallback);
+    glfwSetWindowRefreshCallback(G_WINDOW, invalidateCallback);
+    glfwSetWindowCloseCallback(G_WINDOW, invalidateCallback);
+
+#ifdef UI_LIBRARY_COROUTINES
+    TaskScheduler::getInstance().BindUiThread();
+#endif
+    {
+        StartupTrace::ScopedPhase phase("onInit");
+        onInit();
+    }
+
+    if (settings.renderThread) {
+        mRenderThread.Start(G_WINDOW);
+    }
 
     while (running) {
 
@@ -193,6 +373,24 @@ void Application::run(const WindowSettings& settings, const GLFWimage* icon) {
 			return;
 		}
 
+		if (settings.redrawOnDemand) {
+			waitForRedraw();
+			if (!running) break;
+		}
+		mFramePacer.BeginFrame();
+		if (mFramePacer.IsLowLatency()) {
+			glfwPollEvents();  // Read input as late as possible, after any limiter sleep.
+		}
+
+		// Requests made while rendering this frame schedule the next one.
+		mUIContext->G_REDRAW = false;
+		mUIContext->G_NEXT_REDRAW_TIME = std::numeric_limits<double>::infinity();
+
+		// Results posted by worker threads, applied before this frame's input and layout.
+		if (CommandQueue::getInstance().Drain(settings.commandBudget)) {
+			mUIContext->Invalidate();  // Over budget; continue next frame.
+		}
+
 		glfwGetCursorPos(G_WINDOW, &mUIContext->G_MOUSE_X, &mUIContext->G_MOUSE_Y);
 		
 		glm::vec2 currentMousePos(mUIContext->G_MOUSE_X, mUIContext->G_MOUSE_Y);
@@ -228,14 +426,34 @@ void Application::run(const WindowSettings& settings, const GLFWimage* icon) {
 			mUIContext->G_MOUSE_DRAG_END_Y = static_cast<int>(mUIContext->G_MOUSE_Y);
 		}
 		
-		glfwSetInputMode(G_WINDOW, GLFW_CURSOR, mUIContext->G_SET_CURSOR_MODE);
+		if (mUIContext->G_SET_CURSOR_MODE != mCursorMode) {
+			glfwSetInputMode(G_WINDOW, GLFW_CURSOR, mUIContext->G_SET_CURSOR_MODE);
+			mCursorMode = mUIContext->G_SET_CURSOR_MODE;
+			mUIContext->G_MOUSE_HISTORY.Reset();  // The cursor may be warped back when re-enabled.
+		}
 		mUIContext->G_SET_CURSOR_MODE = GLFW_CURSOR_NORMAL;
+		bool rawMotion = mUIContext->G_RAW_MOUSE_MOTION && mCursorMode == GLFW_CURSOR_DISABLED && glfwRawMouseMotionSupported();
+		if (rawMotion != mRawMouseMotion) {
+			glfwSetInputMode(G_WINDOW, GLFW_RAW_MOUSE_MOTION, rawMotion ? GLFW_TRUE : GLFW_FALSE);
+			mRawMouseMotion = rawMotion;
+		}
+		mUIContext->G_RAW_MOUSE_MOTION = false;
 		mUIContext->G_MOUSE_DRAG_DELTA = mouseDelta;
 		previousMousePos = currentMousePos;
 
+		if (!mRenderThread.IsRunning()) {
+			PickBuffer::getInstance().Poll();  // Otherwise polled by the render thread.
+		}
 		MouseInputSingleton::getInstance().grantMouseInput(mUIContext);
 
-        onUpdate();
+		mJobs.SyncFrame();  // Frame jobs finish before anything is drawn.
+#ifdef UI_LIBRARY_COROUTINES
+		double taskWake = TaskScheduler::getInstance().ResumeFrame(glfwGetTime());
+		if (!std::isinf(taskWake)) {
+			mUIContext->InvalidateAt(taskWake);
+		}
+#endif
+		drawFrame();
 		
 		glfwSetCursor(G_WINDOW, mCursorLUT[mUIContext->G_SET_CURSOR]);
 
@@ -263,12 +481,28 @@ void Application::run(const WindowSettings& settings, const GLFWimage* icon) {
 		mUIContext->G_CTRL_X_PRESS = false;
 		mUIContext->G_CTRL_C_PRESS = false;
 		mUIContext->G_CTRL_V_PRESS = false;
+		mUIContext->G_EVENTS.Clear();
+		mUIContext->G_MOUSE_HISTORY.EndFrame();
+
+		// Swap front and back buffers to see the pixels (or hand the frame to the render thread)
+		presentFrame();
+
+		if (StartupTrace::IsActive()) {
+			StartupTrace::End();
+			if (settings.printStartupTrace) {
+				StartupTrace::Print(std::cout);
+			}
+			if (!settings.startupTraceFile.empty()) {
+				StartupTrace::WriteChromeTrace(settings.startupTraceFile);
+			}
+		}
 
-		// Swap front and back buffers to see the pixels
-		glfwSwapBuffers(G_WINDOW);
-		glfwPollEvents();
+		if (!mFramePacer.IsLowLatency()) {
+			glfwPollEvents();
+		}
     }
 
+    mRenderThread.Stop();  // The context comes back to this thread for shutdown.
     onShutdown();
 
 	glfwDestroyWindow(G_WINDOW);
@@ -0,0 +1,113 @@
+// Copyright (c) 2025 Thomas Groom
+
+
+#include "ui_library/BackBuffer.h"
+#include "ui_library/PickBuffer.h"
+#include <algorithm>
+#include <iostream>
+
+
+bool BackBuffer::EnsureTarget(int width, int height) {
+    if (mFBO != 0 && width == mWidth && height == mHeight && mSamples == mCreatedSamples) {
+        return false;
+    }
+    if (mFBO == 0) {
+        glGenFramebuffers(1, &mFBO);
+        glGenRenderbuffers(1, &mColour);
+    }
+    mWidth = width;
+    mHeight = height;
+    mCreatedSamples = mSamples;
+
+    glBindRenderbuffer(GL_RENDERBUFFER, mColour);
+    if (mSamples > 0) {
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, mSamples, GL_RGBA8, width, height);
+    } else {
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    }
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, mFBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, mColour);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Back buffer framebuffer is incomplete" << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return true;
+}
+
+
+// Merges the rectangles in `damage` that any of `commands` intersects, until each command
+// intersects at most one of them.
+static void MergeReached(std::vector<DrawList::Rect>& damage, const std::vector<DrawList::Rect>& commands) {
+    bool merged = true;
+    while (merged && damage.size() > 1) {
+        merged = false;
+        for (const DrawList::Rect& command : commands) {
+            std::size_t first = damage.size();
+            for (std::size_t i = 0; i < damage.size(); i++) {
+                if (!command.Intersects(damage[i])) continue;
+                if (first == damage.size()) {
+                    first = i;
+                    continue;
+                }
+                damage[first] = damage[first].Union(damage[i]);
+                damage.erase(damage.begin() + i);
+                i--;
+                merged = true;
+            }
+        }
+    }
+}
+
+
+void BackBuffer::Draw(const DrawList& frame, std::vector<DrawList::Rect> damage, int width, int height) {
+    if (width <= 0 || height <= 0) return;
+    const DrawList::Rect target = { 0, 0, width, height };
+    if (EnsureTarget(width, height)) {
+        damage.assign(1, target);
+    }
+
+    // The pick pass only draws what is submitted, so its square is always redrawn.
+    PickBuffer& picker = PickBuffer::getInstance();
+    if (picker.IsActive()) {
+        damage.push_back(picker.Region());
+    }
+    for (DrawList::Rect& rect : damage) {
+        rect = rect.Intersect(target);
+    }
+    damage.erase(std::remove_if(damage.begin(), damage.end(), [](const DrawList::Rect& rect) { return rect.Empty(); }), damage.end());
+    // Deferred commands can have side effects, so they must not run once per rectangle:
+    // rectangles that one of them reaches are merged until none reaches more than one.
+    if (damage.size() > 1 && frame.HasFunctions()) {
+        std::vector<DrawList::Rect> commands;
+        if (frame.DeferredBounds(commands)) {
+            MergeReached(damage, commands);
+        } else {
+            DrawList::Rect bounds;
+            for (const DrawList::Rect& rect : damage) {
+                bounds = bounds.Union(rect);
+            }
+            damage.assign(1, bounds);
+        }
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, mFBO);
+    glEnable(GL_SCISSOR_TEST);
+    for (const DrawList::Rect& clip : damage) {
+        glScissor(clip.x, height - clip.y - clip.height, clip.width, clip.height);
+        glClear(GL_COLOR_BUFFER_BIT);
+        frame.Submit(clip);
+    }
+    // The rest still run once, drawing nothing, for what they do besides drawing.
+    frame.SubmitUnreached(damage);
+
+    // Copy (and resolve) the whole buffer: the window's back buffer holds nothing useful.
+    glDisable(GL_SCISSOR_TEST);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, mFBO);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(0, 0, width, height);
+}
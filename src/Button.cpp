@@ -10,6 +10,8 @@ Button::Button(UI* _ui, std::shared_ptr<Text> tr, std::wstring _text, Text::Alig
     {
     mZ = z;
     mContainer = container;
+    SetMouseEvents(MouseEvent::PRESS | MouseEvent::RELEASE);
+    SetNearMargin(100);
 
 	rectPrim.Rect(mContainer.x, mContainer.y, mContainer.width, mContainer.height, r, mZ);  // TODO: Rect should use a boundary as input
 }
@@ -21,33 +23,46 @@ Button& Button::setIcon(std::shared_ptr<Texture2D> texture, int iconX, int iconY
     mIconW = iconW;
     mIconH = iconH;
     mIconTexture = texture;
+    mVectorIcon.reset();
     return *this;
 }
 
 
-void Button::MouseCallback(int _mouseState) {
-    mInContainer = true;
-    if(mActiveState != DISABLED) {
-        if (_mouseState == mTriggerEdge && isMouseInBounds(mUI, &mContainer)) {
-            if (onClickCallback) onClickCallback(); // TODO: Perhaps move this to the draw call so that only buttons which are drawn are actually functional
-            btnState = 4;  // Button has been clicked
-            return;
-        }
-        btnState = 3;  // Mouse is over the button but not yet clicked (hover state)
-        return;
+Button& Button::setIcon(std::shared_ptr<VectorIcon> icon, int iconX, int iconY, int iconW, int iconH) {
+    mIconX = iconX;
+    mIconY = iconY;
+    mIconW = iconW;
+    mIconH = iconH;
+    mVectorIcon = icon;
+    mIconTexture.reset();
+    return *this;
+}
+
+
+void Button::OnMouseEvent(const MouseEvent& event) {
+    if (event.button != GLFW_MOUSE_BUTTON_LEFT || mActiveState == DISABLED) return;
+    int edge = event.type == MouseEvent::PRESS ? GLFW_PRESS : GLFW_RELEASE;
+    if (edge == mTriggerEdge) {
+        if (onClickCallback) onClickCallback(); // TODO: Perhaps move this to the draw call so that only buttons which are drawn are actually functional
+        mClicked = true;
     }
-	btnState = 2; // Mouse is over the button, but it's disabled (disabled state)
 }
 
 
 void Button::Draw(){
-    isDrawn = true;
+    SetDrawn();
 
-    if (!mInContainer){
+    if (IsHovered()) {
+        // 2: Mouse is over the button, but it's disabled (disabled state)
+        // 3: Mouse is over the button but not yet clicked (hover state)
+        // 4: Button has been clicked
+        btnState = mActiveState == DISABLED ? 2 : (mClicked ? 4 : 3);
+    } else {
         // 0: Mouse is far away from the button (inactive or idle state)
 	    // 1: Mouse is outside the button but not far enough to be considered idle
-        btnState = isMouseInBounds(mUI, &mContainer, -100) ? 1 : 0;
+        btnState = IsNear() ? 1 : 0;
     }
+    mClicked = false;
 
     if (btnState >= 2) {
         isBold = true;
@@ -73,9 +88,11 @@ void Button::Draw(){
 	// Draw the button icon if texture is available
     if (mIconTexture) {
         mIconTexture->DrawSprite(glm::vec2(mContainer.x + mIconX, mContainer.y + mIconY), glm::vec2(mIconW, mIconH), mZ + 0.001f);
+    }
+    else if (mVectorIcon) {
+        mVectorIcon->DrawSprite(glm::vec2(mContainer.x + mIconX, mContainer.y + mIconY), glm::vec2(mIconW, mIconH), mZ + 0.001f);
     }
 	isBold = false;
-    mInContainer = false;
 }
 
 
@@ -0,0 +1,68 @@
+// Copyright (c) 2025 Thomas Groom
+
+
+#include "ui_library/CommandQueue.h"
+#include "ui_library/Utils.h"
+
+
+CommandQueue::~CommandQueue() {
+    // Commands still queued at exit are dropped without running.
+    while (Node* node = Pop()) {
+        delete node;
+    }
+}
+
+
+void CommandQueue::Post(Command command) {
+    Node* node = new Node();
+    node->command = std::move(command);
+    Push(node);
+    UI::PostInvalidate();  // Wakes the loop if it is waiting for events.
+}
+
+
+void CommandQueue::Push(Node* node) {
+    node->next.store(nullptr, std::memory_order_relaxed);
+    Node* previous = mHead.exchange(node, std::memory_order_acq_rel);
+    // Until this store the node is unreachable from the consumer side; Pop treats that gap
+    // as an empty queue and picks the node up on a later drain.
+    previous->next.store(node, std::memory_order_release);
+}
+
+
+CommandQueue::Node* CommandQueue::Pop() {
+    Node* tail = mTail;
+    Node* next = tail->next.load(std::memory_order_acquire);
+    if (tail == &mStub) {
+        if (!next) return nullptr;
+        mTail = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+    if (next) {
+        mTail = next;
+        return tail;
+    }
+    // `tail` is the last linked node. It can only be taken once the stub is queued behind it.
+    if (tail != mHead.load(std::memory_order_acquire)) return nullptr;  // A push is midway.
+    Push(&mStub);
+    next = tail->next.load(std::memory_order_acquire);
+    if (next) {
+        mTail = next;
+        return tail;
+    }
+    return nullptr;
+}
+
+
+bool CommandQueue::Drain(double budgetSeconds) {
+    double start = glfwGetTime();
+    while (Node* node = Pop()) {
+        node->command();
+        delete node;
+        if (glfwGetTime() - start >= budgetSeconds) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,120 @@
+// Copyright (c) 2025 Thomas Groom
+
+
+#include "ui_library/DamageTracker.h"
+
+#include <algorithm>
+
+
+// Pixels added around each damaged rectangle, for antialiased edges.
+static constexpr int kPadding = 1;
+// Two rectangles are merged if their bounding box wastes no more than this many pixels.
+static constexpr long long kMergeSlack = 32 * 32;
+// Above this fraction of the target, the whole target is redrawn as one rectangle.
+static constexpr double kFullFraction = 0.6;
+
+
+void DamageTracker::Add(const DrawList::Rect& rect) {
+    if (rect.Empty()) return;
+    std::lock_guard<std::mutex> lock(mMutex);
+    mPending.push_back(rect);
+}
+
+
+void DamageTracker::AddAll() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mFull = true;
+}
+
+
+std::vector<DrawList::Rect> DamageTracker::Collect(DrawList& frame, int width, int height) {
+    const DrawList::Rect target = { 0, 0, width, height };
+    std::vector<DrawList::Rect> damage;
+    bool full = false;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        damage.swap(mPending);
+        full = mFull;
+        mFull = false;
+    }
+    if (width != mWidth || height != mHeight) {
+        full = true;
+        mWidth = width;
+        mHeight = height;
+    }
+
+    mCurrent.clear();
+    frame.ComputeFootprints(width, height, mCurrent);
+
+    // Footprints present in only one of the two frames are what changed.
+    auto byHash = [](const DrawList::Footprint& a, const DrawList::Footprint& b) { return a.hash < b.hash; };
+    std::sort(mCurrent.begin(), mCurrent.end(), byHash);
+    if (!full) {
+        std::size_t i = 0;
+        std::size_t j = 0;
+        while (i < mCurrent.size() || j < mPrevious.size()) {
+            if (j == mPrevious.size() || (i < mCurrent.size() && mCurrent[i].hash < mPrevious[j].hash)) {
+                damage.push_back(mCurrent[i++].bounds);
+            } else if (i == mCurrent.size() || mPrevious[j].hash < mCurrent[i].hash) {
+                damage.push_back(mPrevious[j++].bounds);
+            } else {
+                i++;
+                j++;
+            }
+        }
+    }
+    mPrevious.swap(mCurrent);
+
+    if (full) {
+        return { target };
+    }
+    return Merge(std::move(damage), target);
+}
+
+
+std::vector<DrawList::Rect> DamageTracker::Merge(std::vector<DrawList::Rect> rects, const DrawList::Rect& target) const {
+    DrawList::Rect bounds;
+    long long area = 0;
+    std::size_t kept = 0;
+    for (const DrawList::Rect& rect : rects) {
+        DrawList::Rect padded = DrawList::Rect{ rect.x - kPadding, rect.y - kPadding, rect.width + 2 * kPadding, rect.height + 2 * kPadding }.Intersect(target);
+        if (padded.Empty()) continue;
+        bounds = bounds.Union(padded);
+        area += padded.Area();
+        rects[kept++] = padded;
+    }
+    rects.resize(kept);
+    if (rects.empty()) return {};
+    if (area >= static_cast<long long>(kFullFraction * target.Area()) || bounds.Area() >= static_cast<long long>(kFullFraction * target.Area())) {
+        return { target };
+    }
+    if (rects.size() > 64) {
+        return { bounds };  // Too many to merge pairwise each frame.
+    }
+
+    // Merge pairs whose bounding box costs little extra, then the cheapest pairs until few
+    // enough are left.
+    while (rects.size() > 1) {
+        std::size_t bestA = 0;
+        std::size_t bestB = 0;
+        long long bestWaste = 0;
+        bool found = false;
+        for (std::size_t a = 0; a < rects.size(); a++) {
+            for (std::size_t b = a + 1; b < rects.size(); b++) {
+                long long waste = rects[a].Union(rects[b]).Area() - rects[a].Area() - rects[b].Area();
+                if (!found || waste < bestWaste) {
+                    found = true;
+                    bestWaste = waste;
+                    bestA = a;
+                    bestB = b;
+                }
+            }
+        }
+        if (bestWaste > kMergeSlack && rects.size() <= static_cast<std::size_t>(mMaxRects)) {
+            break;
+        }
+        rects[bestA] = rects[bestA].Union(rects[bestB]);
+        rects.erase(rects.begin() + bestB);
+    }
+    return rects;
+}
@@ -0,0 +1,556 @@
+// Copyright (c) 2025 Thomas Groom
+
+
+#include "ui_library/DrawList.h"
+#include "ui_library/LayerCache.h"
+#include "ui_library/Utils.h"
+#include "ui_library/Text.h"
+#include "ui_library/Texture.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+
+static thread_local DrawList* tCurrent = nullptr;
+
+// Scissor state to restore at each immediate PopScissor, innermost last.
+struct SavedScissor {
+    GLint box[4];
+    GLboolean enabled;
+};
+static thread_local std::vector<SavedScissor> tSavedScissors;
+static thread_local int tTargetWidth = 0;
+static thread_local int tTargetHeight = 0;
+// Box every immediate scissor is limited to during Submit(clip), in GL window coordinates.
+static thread_local bool tClipActive = false;
+static thread_local GLint tClip[4];
+// GL window position of the bound framebuffer's origin during SubmitToLayer.
+static thread_local int tOriginX = 0;
+static thread_local int tOriginY = 0;
+
+
+// Bounding box of the xy positions in `count` vertices of `stride` floats.
+static DrawList::Rect VertexBounds(const float* verts, std::size_t count, std::size_t stride) {
+    if (count == 0) return {};
+    float minX = verts[0], maxX = verts[0], minY = verts[1], maxY = verts[1];
+    for (std::size_t i = 1; i < count; i++) {
+        const float* v = verts + i * stride;
+        minX = std::min(minX, v[0]);
+        maxX = std::max(maxX, v[0]);
+        minY = std::min(minY, v[1]);
+        maxY = std::max(maxY, v[1]);
+    }
+    int x = static_cast<int>(std::floor(minX));
+    int y = static_cast<int>(std::floor(minY));
+    return { x, y, static_cast<int>(std::ceil(maxX)) - x, static_cast<int>(std::ceil(maxY)) - y };
+}
+
+
+DrawList::Rect DrawList::Rect::Intersect(const Rect& other) const {
+    int left = std::max(x, other.x);
+    int top = std::max(y, other.y);
+    int right = std::min(x + width, other.x + other.width);
+    int bottom = std::min(y + height, other.y + other.height);
+    if (right <= left || bottom <= top) return {};
+    return { left, top, right - left, bottom - top };
+}
+
+
+DrawList::Rect DrawList::Rect::Covering(glm::vec2 position, glm::vec2 size) {
+    int x = static_cast<int>(std::floor(position.x));
+    int y = static_cast<int>(std::floor(position.y));
+    return { x, y, static_cast<int>(std::ceil(position.x + size.x)) - x, static_cast<int>(std::ceil(position.y + size.y)) - y };
+}
+
+
+DrawList::Rect DrawList::Rect::Union(const Rect& other) const {
+    if (Empty()) return other;
+    if (other.Empty()) return *this;
+    int left = std::min(x, other.x);
+    int top = std::min(y, other.y);
+    int right = std::max(x + width, other.x + other.width);
+    int bottom = std::max(y + height, other.y + other.height);
+    return { left, top, right - left, bottom - top };
+}
+
+
+DrawList::Recording::Recording(DrawList* list) : mPrevious(tCurrent) {
+    tCurrent = list;
+}
+
+
+DrawList::Recording::~Recording() {
+    tCurrent = mPrevious;
+}
+
+
+DrawList* DrawList::Current() {
+    return tCurrent;
+}
+
+
+void DrawList::PushScissor(int x, int y, int width, int height) {
+    if (tCurrent) {
+        tCurrent->mScissors.push_back({ x, y, width, height, true });
+        tCurrent->Push(Kind::PUSH_SCISSOR, tCurrent->mScissors.size() - 1);
+        return;
+    }
+    SavedScissor saved;
+    glGetIntegerv(GL_SCISSOR_BOX, saved.box);
+    saved.enabled = glIsEnabled(GL_SCISSOR_TEST);
+    tSavedScissors.push_back(saved);
+    glEnable(GL_SCISSOR_TEST);
+    x -= tOriginX;
+    y -= tOriginY;
+    if (tClipActive) {
+        int left = std::max(x, tClip[0]);
+        int bottom = std::max(y, tClip[1]);
+        int right = std::min(x + width, tClip[0] + tClip[2]);
+        int top = std::min(y + height, tClip[1] + tClip[3]);
+        glScissor(left, bottom, std::max(right - left, 0), std::max(top - bottom, 0));
+        return;
+    }
+    glScissor(x, y, width, height);
+}
+
+
+void DrawList::PushScissor() {
+    if (tCurrent) {
+        tCurrent->mScissors.push_back({ 0, 0, 0, 0, false });
+        tCurrent->Push(Kind::PUSH_SCISSOR, tCurrent->mScissors.size() - 1);
+        return;
+    }
+    SavedScissor saved;
+    glGetIntegerv(GL_SCISSOR_BOX, saved.box);
+    saved.enabled = glIsEnabled(GL_SCISSOR_TEST);
+    tSavedScissors.push_back(saved);
+    if (tClipActive) {
+        glScissor(tClip[0], tClip[1], tClip[2], tClip[3]);  // Unclipped, but not past the clip.
+        return;
+    }
+    glDisable(GL_SCISSOR_TEST);
+}
+
+
+void DrawList::PopScissor() {
+    if (tCurrent) {
+        tCurrent->Push(Kind::POP_SCISSOR, 0);
+        return;
+    }
+    if (tSavedScissors.empty()) {
+        std::cerr << "DrawList::PopScissor without a matching PushScissor" << std::endl;
+        return;
+    }
+    SavedScissor saved = tSavedScissors.back();
+    tSavedScissors.pop_back();
+    glScissor(saved.box[0], saved.box[1], saved.box[2], saved.box[3]);
+    if (saved.enabled) {
+        glEnable(GL_SCISSOR_TEST);
+    } else {
+        glDisable(GL_SCISSOR_TEST);
+    }
+}
+
+
+void DrawList::Defer(std::function<void()> command) {
+    if (tCurrent) {
+        tCurrent->AddCommand(std::move(command));
+    } else {
+        command();
+    }
+}
+
+
+void DrawList::Defer(std::function<void()> command, const Rect& bounds, std::uint64_t key) {
+    if (tCurrent) {
+        tCurrent->AddCommand(std::move(command), bounds, key, true);
+    } else {
+        command();
+    }
+}
+
+
+void DrawList::DeferGL(std::function<void()> command, const Rect& bounds, std::uint64_t key) {
+    if (tCurrent) {
+        tCurrent->AddCommand(std::move(command), bounds, key, false);
+    } else {
+        command();
+    }
+}
+
+
+void DrawList::SetTargetSize(int width, int height) {
+    tTargetWidth = width;
+    tTargetHeight = height;
+}
+
+
+void DrawList::GetTargetSize(int& width, int& height) {
+    if (tTargetWidth > 0 && tTargetHeight > 0) {
+        width = tTargetWidth;
+        height = tTargetHeight;
+        return;
+    }
+    glfwGetFramebufferSize(G_WINDOW, &width, &height);
+}
+
+
+void DrawList::AddMesh(Mesh mesh) {
+    mMeshes.push_back(std::move(mesh));
+    Push(Kind::MESH, mMeshes.size() - 1);
+}
+
+
+void DrawList::AddGlyphs(GlyphRun run) {
+    if (run.font.use_count() == 0) mMustWait = true;   // Not kept alive.
+    mGlyphRuns.push_back(std::move(run));
+    Push(Kind::GLYPHS, mGlyphRuns.size() - 1);
+}
+
+
+void DrawList::AddSprite(const Sprite& sprite) {
+    if (sprite.texture.use_count() == 0) mMustWait = true;
+    mSprites.push_back(sprite);
+    Push(Kind::SPRITE, mSprites.size() - 1);
+}
+
+
+void DrawList::AddCommand(std::function<void()> command) {
+    mFunctions.push_back({ std::move(command), Rect{}, 0, false, true });
+    Push(Kind::COMMAND, mFunctions.size() - 1);
+    mMustWait = true;
+}
+
+
+void DrawList::AddCommand(std::function<void()> command, const Rect& bounds, std::uint64_t key, bool touchesWidgets) {
+    mFunctions.push_back({ std::move(command), bounds, key, true, touchesWidgets });
+    Push(Kind::COMMAND, mFunctions.size() - 1);
+    mMustWait = mMustWait || touchesWidgets;
+}
+
+
+void DrawList::AddLayer(Layer layer) {
+    if (layer.content && layer.content->MustWait()) mMustWait = true;
+    mLayers.push_back(std::move(layer));
+    Push(Kind::LAYER, mLayers.size() - 1);
+}
+
+
+void DrawList::MarkDrawn(MouseHandler* handler) {
+    mDrawn.push_back(handler);
+    Push(Kind::DRAWN, mDrawn.size() - 1);
+}
+
+
+void DrawList::Append(const DrawList& other) {
+    mMustWait = mMustWait || other.mMustWait;
+    for (const Entry& entry : other.mCommands) {
+        switch (entry.kind) {
+        case Kind::MESH:
+            AddMesh(other.mMeshes[entry.index]);
+            break;
+        case Kind::GLYPHS:
+            AddGlyphs(other.mGlyphRuns[entry.index]);
+            break;
+        case Kind::SPRITE:
+            AddSprite(other.mSprites[entry.index]);
+            break;
+        case Kind::LAYER:
+            AddLayer(other.mLayers[entry.index]);
+            break;
+        case Kind::PUSH_SCISSOR:
+            mScissors.push_back(other.mScissors[entry.index]);
+            Push(Kind::PUSH_SCISSOR, mScissors.size() - 1);
+            break;
+        case Kind::POP_SCISSOR:
+            Push(Kind::POP_SCISSOR, 0);
+            break;
+        case Kind::COMMAND:
+            mFunctions.push_back(other.mFunctions[entry.index]);
+            Push(Kind::COMMAND, mFunctions.size() - 1);
+            break;
+        case Kind::DRAWN:
+            MarkDrawn(other.mDrawn[entry.index]);
+            break;
+        }
+    }
+}
+
+
+void DrawList::FlushDrawn() {
+    if (mDrawn.empty()) return;
+    Recording immediate(nullptr);  // So SetDrawn writes the store rather than deferring again.
+    for (MouseHandler* handler : mDrawn) {
+        handler->SetDrawn();
+    }
+    mCommands.erase(std::remove_if(mCommands.begin(), mCommands.end(), [](const Entry& entry) { return entry.kind == Kind::DRAWN; }), mCommands.end());
+    mDrawn.clear();
+    mBounds.clear();
+}
+
+
+std::vector<MouseHandler*> DrawList::TakeDrawn() {
+    std::vector<MouseHandler*> drawn;
+    drawn.swap(mDrawn);
+    mCommands.erase(std::remove_if(mCommands.begin(), mCommands.end(), [](const Entry& entry) { return entry.kind == Kind::DRAWN; }), mCommands.end());
+    mBounds.clear();
+    return drawn;
+}
+
+
+void DrawList::Clear() {
+    mCommands.clear();
+    mMeshes.clear();
+    mGlyphRuns.clear();
+    mSprites.clear();
+    mLayers.clear();
+    mScissors.clear();
+    mFunctions.clear();
+    mDrawn.clear();
+    mBounds.clear();
+    mMustWait = false;
+}
+
+
+void DrawList::ComputeFootprints(int targetWidth, int targetHeight, std::vector<Footprint>& footprints) {
+    static std::atomic<std::uint64_t> sOpaque{ 0 };
+    const Rect target = { 0, 0, targetWidth, targetHeight };
+    std::vector<Rect> clips;
+    mBounds.assign(mCommands.size(), Rect());
+
+    for (std::size_t i = 0; i < mCommands.size(); i++) {
+        const Entry& entry = mCommands[i];
+        const Rect clip = clips.empty() ? target : clips.back();
+        Rect& bounds = mBounds[i];
+        switch (entry.kind) {
+        case Kind::MESH: {
+            const Mesh& mesh = mMeshes[entry.index];
+            bounds = VertexBounds(mesh.verts.data(), mesh.verts.size() / 7, 7).Intersect(clip);
+            if (bounds.Empty()) break;
+            Hasher hash;
+            hash.Add(entry.kind).Add(bounds).AddBytes(mesh.verts.data(), mesh.verts.size() * sizeof(float));
+            hash.AddBytes(mesh.inds.data(), mesh.inds.size() * sizeof(unsigned int));
+            footprints.push_back({ hash.Value(), bounds });
+            break;
+        }
+        case Kind::GLYPHS: {
+            // One footprint per glyph, so a caret blink or a changed character only damages
+            // its own cell.
+            const GlyphRun& run = mGlyphRuns[entry.index];
+            const std::size_t glyphFloats = 18 * 9;
+            for (std::size_t g = 0; g < run.glyphs.size(); g++) {
+                const float* verts = run.verts.data() + g * glyphFloats;
+                Rect glyph = VertexBounds(verts, 18, 9).Intersect(clip);
+                if (glyph.Empty()) continue;
+                bounds = bounds.Union(glyph);
+                Hasher hash;
+                hash.Add(entry.kind).Add(glyph).Add(run.font.get()).Add(run.glyphs[g]).Add(run.colour);
+                hash.AddBytes(verts, glyphFloats * sizeof(float));
+                footprints.push_back({ hash.Value(), glyph });
+            }
+            break;
+        }
+        case Kind::SPRITE: {
+            const Sprite& sprite = mSprites[entry.index];
+            bounds = Rect::Covering(sprite.position, sprite.size).Intersect(clip);
+            if (bounds.Empty()) break;
+            Hasher hash;
+            hash.Add(entry.kind).Add(bounds).Add(sprite.texture.get()).Add(sprite.texture->ContentVersion());
+            hash.Add(sprite.position).Add(sprite.size).Add(sprite.z).Add(sprite.rotate).Add(sprite.colour);
+            footprints.push_back({ hash.Value(), bounds });
+            break;
+        }
+        case Kind::LAYER: {
+            // Keyed on the recording it shows, not on what that draws: an unchanged layer
+            // damages nothing however much it contains.
+            const Layer& layer = mLayers[entry.index];
+            bounds = layer.view.Intersect(clip);
+            if (bounds.Empty()) break;
+            Hasher hash;
+            hash.Add(entry.kind).Add(bounds).Add(layer.area).Add(layer.view).Add(layer.scroll);
+            hash.Add(layer.surface.get()).Add(layer.version);
+            footprints.push_back({ hash.Value(), bounds });
+            break;
+        }
+        case Kind::PUSH_SCISSOR: {
+            const Scissor& scissor = mScissors[entry.index];
+            Rect box = scissor.enabled ? Rect{ scissor.x, targetHeight - scissor.y - scissor.height, scissor.width, scissor.height } : target;
+            clips.push_back(box.Intersect(target));
+            break;
+        }
+        case Kind::POP_SCISSOR:
+            if (!clips.empty()) clips.pop_back();
+            break;
+        case Kind::COMMAND: {
+            const Function& function = mFunctions[entry.index];
+            if (!function.bounded) {
+                bounds = clip;
+                footprints.push_back({ Hasher().Add(sOpaque.fetch_add(1, std::memory_order_relaxed)).Value(), bounds });
+                break;
+            }
+            bounds = function.bounds.Intersect(clip);
+            if (bounds.Empty()) break;
+            footprints.push_back({ Hasher().Add(entry.kind).Add(bounds).Add(function.bounds).Add(function.key).Value(), bounds });
+            break;
+        }
+        case Kind::DRAWN:
+            break;
+        }
+    }
+}
+
+
+bool DrawList::DeferredBounds(std::vector<Rect>& bounds) const {
+    if (mBounds.size() != mCommands.size()) return false;
+    for (std::size_t i = 0; i < mCommands.size(); i++) {
+        if (mCommands[i].kind == Kind::COMMAND) {
+            bounds.push_back(mBounds[i]);
+        }
+    }
+    return true;
+}
+
+
+void DrawList::SubmitUnreached(const std::vector<Rect>& clips) const {
+    if (mFunctions.empty() || mBounds.size() != mCommands.size()) return;
+    Recording immediate(nullptr);
+    bool wasClipped = tClipActive;
+    GLint previousClip[4] = { tClip[0], tClip[1], tClip[2], tClip[3] };
+    GLint scissor[4];
+    glGetIntegerv(GL_SCISSOR_BOX, scissor);
+    GLboolean scissorEnabled = glIsEnabled(GL_SCISSOR_TEST);
+    // Nested scissors are limited to the empty clip too, so nothing reaches the target.
+    tClipActive = true;
+    std::fill(tClip, tClip + 4, 0);
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(0, 0, 0, 0);
+
+    for (std::size_t i = 0; i < mCommands.size(); i++) {
+        if (mCommands[i].kind != Kind::COMMAND) continue;
+        bool reached = std::any_of(clips.begin(), clips.end(), [&](const Rect& clip) { return mBounds[i].Intersects(clip); });
+        if (!reached) {
+            mFunctions[mCommands[i].index].command();
+        }
+    }
+
+    glScissor(scissor[0], scissor[1], scissor[2], scissor[3]);
+    if (!scissorEnabled) {
+        glDisable(GL_SCISSOR_TEST);
+    }
+    tClipActive = wasClipped;
+    std::copy(previousClip, previousClip + 4, tClip);
+}
+
+
+void DrawList::Submit() const {
+    if (tCurrent && tCurrent != this) {
+        tCurrent->Append(*this);
+        return;
+    }
+    SubmitClipped(nullptr);
+}
+
+
+void DrawList::Submit(const Rect& clip) const {
+    SubmitClipped(&clip);
+}
+
+
+void DrawList::SubmitClipped(const Rect* clip) const {
+    Recording immediate(nullptr);  // Everything below draws rather than records.
+    bool wasClipped = tClipActive;
+    GLint previousClip[4] = { tClip[0], tClip[1], tClip[2], tClip[3] };
+    if (clip) {
+        int width = 0;
+        int height = 0;
+        GetTargetSize(width, height);
+        tClipActive = true;
+        tClip[0] = clip->x;
+        tClip[1] = height - clip->y - clip->height;
+        tClip[2] = clip->width;
+        tClip[3] = clip->height;
+    }
+    const bool cull = clip && mBounds.size() == mCommands.size();
+
+    for (std::size_t i = 0; i < mCommands.size(); i++) {
+        const Entry& entry = mCommands[i];
+        if (cull && entry.kind != Kind::PUSH_SCISSOR && entry.kind != Kind::POP_SCISSOR && entry.kind != Kind::DRAWN && !mBounds[i].Intersects(*clip)) {
+            continue;
+        }
+        switch (entry.kind) {
+        case Kind::MESH:
+            Primitive::SubmitMesh(mMeshes[entry.index]);
+            break;
+        case Kind::GLYPHS: {
+            const GlyphRun& run = mGlyphRuns[entry.index];
+            run.font->SubmitGlyphs(run);
+            break;
+        }
+        case Kind::SPRITE: {
+            const Sprite& sprite = mSprites[entry.index];
+            sprite.texture->DrawSprite(sprite.position, sprite.size, sprite.z, sprite.rotate, sprite.colour);
+            break;
+        }
+        case Kind::LAYER: {
+            const Layer& layer = mLayers[entry.index];
+            layer.surface->Composite(layer);
+            break;
+        }
+        case Kind::PUSH_SCISSOR: {
+            const Scissor& scissor = mScissors[entry.index];
+            if (scissor.enabled) {
+                PushScissor(scissor.x, scissor.y, scissor.width, scissor.height);
+            } else {
+                PushScissor();
+            }
+            break;
+        }
+        case Kind::POP_SCISSOR:
+            PopScissor();
+            break;
+        case Kind::COMMAND:
+            mFunctions[entry.index].command();
+            break;
+        case Kind::DRAWN:
+            mDrawn[entry.index]->SetDrawn();
+            break;
+        }
+    }
+    tClipActive = wasClipped;
+    std::copy(previousClip, previousClip + 4, tClip);
+}
+
+
+void DrawList::Submit(const std::vector<const DrawList*>& lists) {
+    for (const DrawList* list : lists) {
+        list->Submit();
+    }
+}
+
+
+void DrawList::SubmitToLayer(const Rect& area) const {
+    int width = 0;
+    int height = 0;
+    GetTargetSize(width, height);
+    SubmitWithOrigin(area.x, height - area.y - area.height, false);
+}
+
+
+void DrawList::SubmitOffset(int x, int y) const {
+    SubmitWithOrigin(tOriginX - x, tOriginY - y, true);
+}
+
+
+void DrawList::SubmitWithOrigin(int originX, int originY, bool clipped) const {
+    bool wasClipped = tClipActive;
+    int previousX = tOriginX;
+    int previousY = tOriginY;
+    tClipActive = clipped && wasClipped;
+    tOriginX = originX;
+    tOriginY = originY;
+    SubmitClipped(nullptr);
+    tClipActive = wasClipped;
+    tOriginX = previousX;
+    tOriginY = previousY;
+}
@@ -78,7 +78,7 @@ void DropdownButton::SetActiveOption(int n) {
 }
 
 void DropdownButton::DrawDropdown() {
-    glDisable(GL_SCISSOR_TEST);
+    DrawList::PushScissor();  // The dropdown may extend outside the workspace.
 
     int stateOverall = -1;
     
@@ -116,5 +116,5 @@ void DropdownButton::DrawDropdown() {
     }
     mDropdownToggled = false;
 
-    glEnable(GL_SCISSOR_TEST);
+    DrawList::PopScissor();
 }
\ No newline at end of file
@@ -1,30 +1,32 @@
 // Modified from: https://github.com/VictorGordan/opengl-tutorials
 
 #include "ui_library/EBO.h"
+#include "ui_library/RenderThread.h"
 
-// Constructor that generates a Elements Buffer Object and links it to indices
+// Constructor. The buffer name is generated on first use so no GL work happens at construction
 EBO::EBO()
 {
-    glGenBuffers(1, &ID);
 }
 
 // Upload data to the element buffer
 void EBO::Data(const std::vector<GLuint>& indices)
 {
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ID);
+    Bind();
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
 }
 
 // Update part of the buffer data
 void EBO::SubData(const std::vector<GLuint>& indices)
 {
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ID);
+    Bind();
     glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, indices.size() * sizeof(GLuint), indices.data());
 }
 
 // Binds the EBO
 void EBO::Bind()
 {
+	if (ID == 0)
+		glGenBuffers(1, &ID);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ID);
 }
 
@@ -32,4 +34,13 @@ void EBO::Bind()
 void EBO::Unbind()
 {
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-}
\ No newline at end of file
+}
+
+// Deletes the EBO, on the render thread if one owns the context
+EBO::~EBO()
+{
+	if (ID != 0) {
+		GLuint id = ID;
+		RenderThread::RunOnGLThread([id] { glDeleteBuffers(1, &id); });
+	}
+}
@@ -0,0 +1,126 @@
+// Copyright (c) 2025 Thomas Groom
+
+
+#include "ui_library/FramePacer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+
+// Sleeps are only trusted to within this much; the remainder of a wait is spun.
+static constexpr double kSpinTail = 0.002;
+// Weight of the newest sample in the moving averages.
+static constexpr double kAverageWeight = 0.1;
+
+
+void FramePacer::SetVsync(Vsync mode) {
+    mVsync = mode;
+    if (glfwGetCurrentContext() != nullptr) {
+        Apply();
+    } else {
+        mApplyPending = true;  // The context is current on the render thread.
+    }
+}
+
+
+void FramePacer::Apply() {
+    mApplyPending = false;
+    mAdaptiveActive = false;
+    int interval = 0;
+    if (mVsync == Vsync::On) {
+        interval = 1;
+    } else if (mVsync == Vsync::Adaptive) {
+        mAdaptiveActive = glfwExtensionSupported("WGL_EXT_swap_control_tear") || glfwExtensionSupported("GLX_EXT_swap_control_tear");
+        interval = mAdaptiveActive ? -1 : 1;
+    }
+    glfwSwapInterval(interval);
+}
+
+
+void FramePacer::SetTargetFps(double fps) {
+    mTargetFps = std::max(0.0, fps);
+    mNextFrameStart = 0.0;
+}
+
+
+void FramePacer::SleepUntil(double time) {
+    double remaining = time - glfwGetTime();
+    if (remaining > kSpinTail) {
+        std::this_thread::sleep_for(std::chrono::duration<double>(remaining - kSpinTail));
+    }
+    while (glfwGetTime() < time) {
+        std::this_thread::yield();
+    }
+}
+
+
+void FramePacer::BeginFrame() {
+    double now = glfwGetTime();
+    if (mTargetFps > 0.0) {
+        double period = 1.0 / mTargetFps;
+        if (now < mNextFrameStart) {
+            SleepUntil(mNextFrameStart);
+            now = glfwGetTime();
+        }
+        // Schedule from the slot rather than from now so small overshoots do not accumulate,
+        // but do not try to catch up after a long frame or an idle wait.
+        mNextFrameStart = (now - mNextFrameStart > period) ? now + period : mNextFrameStart + period;
+    }
+    mFrameStart = now;
+}
+
+
+void FramePacer::MarkInput(double time) {
+    std::lock_guard<std::mutex> lock(mStatsMutex);
+    if (mPendingInput < 0.0 || time < mPendingInput) {
+        mPendingInput = time;
+    }
+}
+
+
+void FramePacer::Present(GLFWwindow* window) {
+    Present(window, mFrameStart);
+}
+
+
+void FramePacer::Present(GLFWwindow* window, double frameStart) {
+    if (mApplyPending) {
+        Apply();
+    }
+    double presentStart = glfwGetTime();
+    glfwSwapBuffers(window);
+    if (mLowLatency) {
+        glFinish();
+    }
+    double now = glfwGetTime();
+
+    std::lock_guard<std::mutex> lock(mStatsMutex);
+    mStats.cpuTime = presentStart - frameStart;
+    mStats.presentTime = now - presentStart;
+    if (mLastPresent >= 0.0) {
+        mStats.frameTime = now - mLastPresent;
+        mStats.averageFrameTime = mStats.frameCount > 1 ? mStats.averageFrameTime + (mStats.frameTime - mStats.averageFrameTime) * kAverageWeight : mStats.frameTime;
+        mStats.maxFrameTime = std::max(mStats.maxFrameTime, mStats.frameTime);
+    }
+    if (mPendingInput >= 0.0) {
+        mStats.inputToPresent = now - mPendingInput;
+        mStats.averageInputToPresent = mStats.averageInputToPresent > 0.0 ? mStats.averageInputToPresent + (mStats.inputToPresent - mStats.averageInputToPresent) * kAverageWeight : mStats.inputToPresent;
+        mPendingInput = -1.0;
+    }
+    mStats.frameCount++;
+    mLastPresent = now;
+}
+
+
+FramePacer::Stats FramePacer::GetStats() const {
+    std::lock_guard<std::mutex> lock(mStatsMutex);
+    return mStats;
+}
+
+
+void FramePacer::ResetStats() {
+    std::lock_guard<std::mutex> lock(mStatsMutex);
+    mStats = Stats();
+    mLastPresent = -1.0;
+}
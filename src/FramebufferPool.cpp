@@ -0,0 +1,61 @@
+// Copyright (c) 2025 Thomas Groom
+
+
+#include "ui_library/FramebufferPool.h"
+#include <iostream>
+
+
+FramebufferPool::Target FramebufferPool::Acquire(int width, int height) {
+    const int bucketWidth = BucketSize(width);
+    const int bucketHeight = BucketSize(height);
+    for (std::size_t i = mFree.size(); i-- > 0;) {
+        if (mFree[i].width == bucketWidth && mFree[i].height == bucketHeight) {
+            Target target = mFree[i];
+            mFree.erase(mFree.begin() + i);
+            return target;
+        }
+    }
+
+    Target target;
+    target.width = bucketWidth;
+    target.height = bucketHeight;
+    GLint previousTexture = 0;
+    GLint previousFBO = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &previousTexture);
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFBO);
+
+    glGenTextures(1, &target.texture);
+    glBindTexture(GL_TEXTURE_2D, target.texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, bucketWidth, bucketHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glGenFramebuffers(1, &target.fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.texture, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Layer framebuffer " << bucketWidth << "x" << bucketHeight << " is incomplete" << std::endl;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFBO);
+    glBindTexture(GL_TEXTURE_2D, previousTexture);
+    return target;
+}
+
+
+void FramebufferPool::Release(const Target& target) {
+    if (!target.Valid()) return;
+    mFree.push_back(target);
+    if (mFree.size() > kMaxFree) {
+        Delete(mFree.front());
+        mFree.erase(mFree.begin());
+    }
+}
+
+
+void FramebufferPool::Delete(const Target& target) {
+    glDeleteFramebuffers(1, &target.fbo);
+    glDeleteTextures(1, &target.texture);
+}
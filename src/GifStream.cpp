@@ -0,0 +1,71 @@
+// Copyright (c) 2025 Thomas Groom
+
+// A private, GIF-only copy of the stb_image decoder. Its frame loader is internal to the
+// implementation, so it is compiled statically into this translation unit instead of being
+// reached through the public API in stb_image.cpp.
+#define STB_IMAGE_STATIC
+#define STBI_ONLY_GIF
+#define STBI_NO_STDIO
+#define STB_IMAGE_IMPLEMENTATION
+#include "ui_library/stb_image.h"
+
+#include "ui_library/GifStream.h"
+
+#include <cstring>
+
+
+struct GifStream::State {
+    stbi__context context;
+    stbi__gif gif;
+    std::vector<unsigned char> previous;     // Composited frame n - 1.
+    std::vector<unsigned char> twoBack;      // Composited frame n - 2, used by "restore to previous" disposal.
+};
+
+
+GifStream::GifStream(const unsigned char* data, int size)
+    : mData(data, data + size), mState(std::make_unique<State>()) {
+    Rewind();
+}
+
+
+GifStream::~GifStream() {
+    STBI_FREE(mState->gif.out);
+    STBI_FREE(mState->gif.history);
+    STBI_FREE(mState->gif.background);
+}
+
+
+void GifStream::Rewind() {
+    STBI_FREE(mState->gif.out);
+    STBI_FREE(mState->gif.history);
+    STBI_FREE(mState->gif.background);
+    std::memset(&mState->gif, 0, sizeof(mState->gif));
+    mState->previous.clear();
+    mState->twoBack.clear();
+
+    stbi__start_mem(&mState->context, mData.data(), static_cast<int>(mData.size()));
+    mValid = !mData.empty() && stbi__gif_test(&mState->context);
+}
+
+
+bool GifStream::Next(const unsigned char*& rgba, int& width, int& height, int& delayMs) {
+    if (!mValid) return false;
+
+    State& s = *mState;
+    int comp = 0;
+    stbi_uc* twoBack = s.twoBack.empty() ? nullptr : s.twoBack.data();
+    stbi_uc* frame = stbi__gif_load_next(&s.context, &s.gif, &comp, 4, twoBack);
+    if (frame == nullptr || frame == reinterpret_cast<stbi_uc*>(&s.context)) {
+        return false;  // Error, or the end of stream marker.
+    }
+
+    size_t bytes = static_cast<size_t>(s.gif.w) * s.gif.h * 4;
+    s.twoBack.swap(s.previous);
+    s.previous.assign(frame, frame + bytes);
+
+    rgba = s.previous.data();
+    width = s.gif.w;
+    height = s.gif.h;
+    delayMs = s.gif.delay;
+    return true;
+}
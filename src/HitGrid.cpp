@@ -0,0 +1,80 @@
+// Copyright (c) 2025 Thomas Groom
+
+
+#include "ui_library/HitGrid.h"
+#include "ui_library/WidgetStore.h"
+
+#include <algorithm>
+
+
+int HitGrid::CellX(int x) const {
+    return std::clamp(x / mCellSize, 0, mCols - 1);
+}
+
+
+int HitGrid::CellY(int y) const {
+    return std::clamp(y / mCellSize, 0, mRows - 1);
+}
+
+
+HitGrid::CellRange HitGrid::CellsFor(const WidgetStore& store, std::uint32_t row) const {
+    int margin = Margin(row);
+    int left = store.mLeft[row] - margin;
+    int top = store.mTop[row] - margin;
+    return { CellX(left), CellY(top), CellX(std::max(store.mRight[row] + margin, left)), CellY(std::max(store.mBottom[row] + margin, top)) };
+}
+
+
+void HitGrid::Build(const WidgetStore& store, int width, int height, std::uint32_t flags, const std::vector<int>* margins) {
+    if (margins) {
+        mMargins = *margins;
+    } else {
+        mMargins.clear();
+    }
+    flags |= WidgetStore::ALIVE;
+    mCols = std::max(1, (width + mCellSize - 1) / mCellSize);
+    mRows = std::max(1, (height + mCellSize - 1) / mCellSize);
+    const std::size_t cellCount = static_cast<std::size_t>(mCols) * mRows;
+
+    // Pass 1: count the handlers overlapping each cell.
+    mCellStart.assign(cellCount + 1, 0);
+    const std::uint32_t rows = static_cast<std::uint32_t>(store.Size());
+    for (std::uint32_t row = 0; row < rows; row++) {
+        if ((store.mFlags[row] & flags) != flags) continue;
+        CellRange r = CellsFor(store, row);
+        for (int cy = r.y0; cy <= r.y1; cy++) {
+            for (int cx = r.x0; cx <= r.x1; cx++) {
+                mCellStart[cy * mCols + cx + 1]++;
+            }
+        }
+    }
+    for (std::size_t c = 0; c < cellCount; c++) {
+        mCellStart[c + 1] += mCellStart[c];
+    }
+
+    // Pass 2: fill, keeping draw order within each cell.
+    mEntries.resize(mCellStart[cellCount]);
+    mCursor.assign(mCellStart.begin(), mCellStart.end() - 1);
+    for (std::uint32_t row = 0; row < rows; row++) {
+        if ((store.mFlags[row] & flags) != flags) continue;
+        CellRange r = CellsFor(store, row);
+        for (int cy = r.y0; cy <= r.y1; cy++) {
+            for (int cx = r.x0; cx <= r.x1; cx++) {
+                mEntries[mCursor[cy * mCols + cx]++] = row;
+            }
+        }
+    }
+}
+
+
+void HitGrid::Query(const WidgetStore& store, int x, int y, std::vector<std::uint32_t>& out) const {
+    if (mCols == 0) return;
+    int cell = CellY(y) * mCols + CellX(x);
+    for (std::uint32_t i = mCellStart[cell]; i < mCellStart[cell + 1]; i++) {
+        std::uint32_t row = mEntries[i];
+        int margin = Margin(row);
+        if (x > store.mLeft[row] - margin && x < store.mRight[row] + margin && y > store.mTop[row] - margin && y < store.mBottom[row] + margin) {
+            out.push_back(row);
+        }
+    }
+}
@@ -0,0 +1,103 @@
+// Copyright (c) 2025 Thomas Groom
+
+
+#include "ui_library/InputEvents.h"
+
+#include <GLFW/glfw3.h>
+
+
+bool InputEvent::IsKeyDown(int glfwKey) const {
+    return type == KEY && key == glfwKey && (action == GLFW_PRESS || action == GLFW_REPEAT);
+}
+
+
+InputQueue::InputQueue(std::size_t initialCapacity) {
+    std::size_t capacity = 1;
+    while (capacity < initialCapacity) capacity <<= 1;
+    mBuffer.resize(capacity);
+}
+
+
+void InputQueue::Push(const InputEvent& event) {
+    if (mCount == mBuffer.size()) {
+        Grow();
+    }
+    mBuffer[(mHead + mCount) & (mBuffer.size() - 1)] = event;
+    mCount++;
+}
+
+
+void InputQueue::Clear() {
+    mHead = 0;
+    mCount = 0;
+}
+
+
+// Doubles the capacity, unwrapping the events so the oldest is at index 0.
+void InputQueue::Grow() {
+    std::vector<InputEvent> grown(mBuffer.size() * 2);
+    for (std::size_t i = 0; i < mCount; i++) {
+        grown[i] = (*this)[i];
+    }
+    mBuffer.swap(grown);
+    mHead = 0;
+}
+
+
+void MouseHistory::Add(double time, double x, double y) {
+    glm::dvec2 position(x, y);
+    if (mHasPrevious) {
+        mFrameDelta += position - (*this)[mCount - 1].position;
+    }
+    mHasPrevious = true;
+    mFrameSamples++;
+
+    if (mCount == kCapacity) {
+        mHead = (mHead + 1) % kCapacity;
+        mCount--;
+    }
+    mSamples[(mHead + mCount) % kCapacity] = { time, position };
+    mCount++;
+}
+
+
+void MouseHistory::EndFrame() {
+    mFrameDelta = glm::dvec2(0.0);
+    mFrameSamples = 0;
+}
+
+
+void MouseHistory::Reset() {
+    mHead = 0;
+    mCount = 0;
+    mHasPrevious = false;
+}
+
+
+glm::dvec2 MouseHistory::Velocity(double now, double window) const {
+    if (mCount < 2 || now - (*this)[mCount - 1].time > window) {
+        return glm::dvec2(0.0);
+    }
+    // Oldest sample inside the window, measured from the sample before it so the first
+    // movement in the window is counted.
+    std::size_t first = mCount - 1;
+    while (first > 0 && now - (*this)[first - 1].time <= window) {
+        first--;
+    }
+    if (first > 0) first--;
+    const Sample& a = (*this)[first];
+    const Sample& b = (*this)[mCount - 1];
+    double dt = b.time - a.time;
+    return dt > 0.0 ? (b.position - a.position) / dt : glm::dvec2(0.0);
+}
+
+
+void AppendCodepoint(std::wstring& text, char32_t codepoint) {
+    if (sizeof(wchar_t) == 2 && codepoint > 0xFFFF) {
+        codepoint -= 0x10000;
+        text.push_back(static_cast<wchar_t>(0xD800 + (codepoint >> 10)));
+        text.push_back(static_cast<wchar_t>(0xDC00 + (codepoint & 0x3FF)));
+    } else {
+        text.push_back(static_cast<wchar_t>(codepoint));
+    }
+}
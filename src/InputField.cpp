@@ -14,7 +14,7 @@ InputField::InputField(UI* _ui, std::shared_ptr<Text> tr, std::string label, Inp
     SetPos(mContainer.x, mContainer.y, mContainer.width, mContainer.height, mZ);
     rectPrim.SetColour(mDefaultColour);
 
-    mCheckboxIconTrue = std::make_shared<Texture2D>(GL_RGBA, GL_RGBA, std::filesystem::path(std::string(UI_LIBRARY_RESOURCES_DIR) + "/icons/checkmark.png"), glm::vec2(20));
+    mCheckboxVectorIconTrue = std::make_shared<VectorIcon>(std::filesystem::path(std::string(UI_LIBRARY_RESOURCES_DIR) + "/icons/checkmark.svg"));
 
     dropDownBtn = new DropdownButton(mUI, mTextRenderer, L"", Text::LEFT_MIDDLE, {0, 0, 140, 20}, 5, mZ + 0.003f, mTextMarginX, 0, BUTTON_COLOUR, FIELD_HOVER_COLOUR, BUTTON_DISABLED_COLOUR, FIELD_DISABLED_HOVER_COLOUR);
     dropDownBtn->SetReflectSelectedOption(true);
@@ -108,6 +108,7 @@ void InputField::MouseCallback(int _mouseState) {
             mTextField->selStart = 0;
             mTextField->selEnd = static_cast<int>(mTextField->content.length());
             mTextField->caretPos = mTextField->selEnd;
+            mTextField->resetCaretBlink();
         }
 
         if ((mType == DOUBLE || mType == INT) && !mTextField->isActive) {
@@ -174,8 +175,8 @@ void InputField::ReadVar() {
 
 
 void InputField::Draw(int x, int y, int width, int height, std::optional<float> z) {
-    isDrawn = true;
     SetPos(x, y, width, height, z.value_or(mZ));
+    SetDrawn();
     rectPrim.Rect(mInputContainer.x, mInputContainer.y, mInputContainer.width, mInputContainer.height, r, mZ);
 
     if (mIsOptional && mState != DISABLED) {
@@ -229,6 +230,7 @@ void InputField::Draw(int x, int y, int width, int height, std::optional<float>
     if ((mType == DOUBLE || mType == INT) && !mTextField->isActive) {
         if (mUI->G_LEFT_MOUSE_STATE == GLFW_RELEASE) {
             mouseDrag = false;
+            mDragRemainder = 0.0;
         }
         if (mouseDrag) {
             mUI->G_SET_CURSOR = CURSOR_HRESIZE;
@@ -332,17 +334,30 @@ void InputField::SetPos(int x, int y, int width, int height, std::optional<float
 
 void InputField::HandleMouseDragForNumericInput() {
     if (mUI->G_LEFT_MOUSE_DRAG) {
-        double delta = mUI->G_MOUSE_DRAG_DELTA.x; // TODO: Function to calculate horizontal mouse drag
+        if (mRawScrub) {
+            // Hide and free the cursor so scrubbing is not stopped by the screen edge.
+            mUI->G_SET_CURSOR_MODE = GLFW_CURSOR_DISABLED;
+            mUI->G_RAW_MOUSE_MOTION = true;
+        }
+        // Every motion sample since the last frame, so the result does not depend on frame rate.
+        double delta = mUI->G_MOUSE_HISTORY.FrameDelta().x;
         if (mType == DOUBLE) {
             if (std::get<double>(mMax) < 1000000000.0 && std::get<double>(mMin) > -1000000000.0) {
                 double modifier = std::clamp(std::get<double>(mMax) - std::get<double>(mMin), 0.001, 10.0) / static_cast<double>(mInputContainer.width);
                 mDoubleValue = static_cast<double>(mDoubleValue + delta * modifier);
             } else {
-                mDoubleValue = static_cast<double>(mDoubleValue + (static_cast<int>(delta) / 10.0));
+                // Whole steps of 0.1 per pixel; the remainder carries over so slow drags still move.
+                mDragRemainder += delta;
+                double steps = std::trunc(mDragRemainder);
+                mDragRemainder -= steps;
+                mDoubleValue = static_cast<double>(mDoubleValue + steps / 10.0);
             }
         } else if (mType == INT) {
             double range = std::clamp(std::get<int>(mMax) - std::get<int>(mMin), -100, 100);
-            mIntValue = static_cast<int>(mIntValue + static_cast<int>((delta * range) / static_cast<double>(mInputContainer.width)));
+            mDragRemainder += (delta * range) / static_cast<double>(mInputContainer.width);
+            double steps = std::trunc(mDragRemainder);
+            mDragRemainder -= steps;
+            mIntValue = static_cast<int>(mIntValue + static_cast<int>(steps));
         }
         if (mType == DOUBLE || mType == INT) {
             WriteVar();
@@ -352,7 +367,7 @@ void InputField::HandleMouseDragForNumericInput() {
 
 
 void InputField::DrawEditableText() {
-    int caretCursor = (mTextField->caretVisibilityCounter > mTextField->caretBlinkRate || !mTextField->isActive) ? -1 : mTextField->caretPos;
+    int caretCursor = (!mTextField->caretVisible || !mTextField->isActive) ? -1 : mTextField->caretPos;
     int textMargin = (mType == TEXT || mType == PATH) ? mTextMarginX + 2 : 0;
     mTextRenderer->RenderText(mTextField->content + L" ", {mInputContainer.x + textMargin, mInputContainer.y, mInputContainer.width - (textMargin * 2), mInputContainer.height}, mZ + 0.002f, (mType == TEXT || mType == PATH) ? Text::LEFT_MIDDLE : Text::CENTER_MIDDLE, mTextColour, false, true, mTextField->selStart, mTextField->selEnd, caretCursor);
 }
@@ -380,14 +395,23 @@ void InputField::DrawCheckbox() {
         rectPrim.Draw();
     }
 
+    glm::vec2 iconPos(mInputContainer.x - margin, mInputContainer.y);
+    glm::vec2 iconSize(mInputContainer.height, mInputContainer.height);
+    glm::vec3 iconColour((mState == ENABLED) ? 1.0f : 0.6f);
     if (mBoolValue) {
         if (mCheckboxIconTrue) {
-            mCheckboxIconTrue->DrawSprite(glm::vec2(mInputContainer.x - margin, mInputContainer.y), glm::vec2(mInputContainer.height, mInputContainer.height), mZ + 0.001f, 0.0f, glm::vec3((mState == ENABLED) ? 1.0f : 0.6f));
+            mCheckboxIconTrue->DrawSprite(iconPos, iconSize, mZ + 0.001f, 0.0f, iconColour);
+        }
+        else if (mCheckboxVectorIconTrue) {
+            mCheckboxVectorIconTrue->DrawSprite(iconPos, iconSize, mZ + 0.001f, iconColour);
         }
     }
     else {
         if (mCheckboxIconFalse) {
-            mCheckboxIconFalse->DrawSprite(glm::vec2(mInputContainer.x - margin, mInputContainer.y), glm::vec2(mInputContainer.height, mInputContainer.height), mZ + 0.001f, 0.0f, glm::vec3((mState == ENABLED) ? 1.0f : 0.6f));
+            mCheckboxIconFalse->DrawSprite(iconPos, iconSize, mZ + 0.001f, 0.0f, iconColour);
+        }
+        else if (mCheckboxVectorIconFalse) {
+            mCheckboxVectorIconFalse->DrawSprite(iconPos, iconSize, mZ + 0.001f, iconColour);
         }
     }
 }
@@ -0,0 +1,225 @@
+// Copyright (c) 2025 Thomas Groom
+
+
+#include "ui_library/JobSystem.h"
+#include <algorithm>
+#include <exception>
+#include <iostream>
+
+
+static std::atomic<JobSystem*> sCurrent{ nullptr };
+static thread_local const JobSystem* tSystem = nullptr;
+static thread_local int tWorkerIndex = -1;
+
+
+bool JobSystem::Handle::Done() const {
+    return !mTask || mTask->done.load(std::memory_order_acquire);
+}
+
+
+JobSystem::JobSystem(unsigned workerCount) {
+    if (workerCount == 0) {
+        unsigned hardware = std::thread::hardware_concurrency();
+        workerCount = hardware > 1 ? hardware - 1 : 1;
+    }
+    for (unsigned i = 0; i < workerCount; i++) {
+        mQueues.push_back(std::make_unique<Queue>());
+    }
+    for (unsigned i = 0; i < workerCount; i++) {
+        mWorkers.emplace_back(&JobSystem::WorkerMain, this, static_cast<int>(i));
+    }
+    JobSystem* expected = nullptr;
+    sCurrent.compare_exchange_strong(expected, this);
+}
+
+
+JobSystem::~JobSystem() {
+    JobSystem* expected = this;
+    sCurrent.compare_exchange_strong(expected, nullptr);
+    {
+        std::lock_guard<std::mutex> lock(mSleepMutex);
+        mStopping = true;
+    }
+    mWake.notify_all();
+    for (std::thread& worker : mWorkers) {
+        worker.join();
+    }
+}
+
+
+JobSystem* JobSystem::Current() {
+    return sCurrent.load(std::memory_order_acquire);
+}
+
+
+JobSystem::Handle JobSystem::Schedule(Job job, const std::vector<Handle>& dependencies) {
+    auto task = std::make_shared<Task>();
+    task->job = std::move(job);
+    task->pending.store(static_cast<int>(dependencies.size()) + 1, std::memory_order_relaxed);
+
+    int satisfied = 1;  // The extra count held while dependencies are registered.
+    for (const Handle& dependency : dependencies) {
+        Task* parent = dependency.mTask.get();
+        if (!parent) {
+            satisfied++;
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(parent->mutex);
+        if (parent->done.load(std::memory_order_acquire)) {
+            satisfied++;
+        } else {
+            parent->dependents.push_back(task);
+        }
+    }
+    if (task->pending.fetch_sub(satisfied, std::memory_order_acq_rel) == satisfied) {
+        Enqueue(task);
+    }
+    return Handle(task);
+}
+
+
+JobSystem::Handle JobSystem::ScheduleForFrame(Job job, const std::vector<Handle>& dependencies) {
+    Handle handle = Schedule(std::move(job), dependencies);
+    std::lock_guard<std::mutex> lock(mFrameMutex);
+    mFrameJobs.push_back(handle);
+    return handle;
+}
+
+
+void JobSystem::Wait(const Handle& handle) {
+    int index = CallerIndex();
+    while (!handle.Done()) {
+        if (!RunOne(index)) {
+            std::this_thread::yield();  // Whatever is left is running on other threads.
+        }
+    }
+}
+
+
+void JobSystem::SyncFrame() {
+    std::vector<Handle> jobs;
+    {
+        std::lock_guard<std::mutex> lock(mFrameMutex);
+        jobs.swap(mFrameJobs);
+    }
+    for (const Handle& handle : jobs) {
+        Wait(handle);
+    }
+}
+
+
+void JobSystem::ParallelFor(std::size_t count, std::size_t grain, const std::function<void(std::size_t, std::size_t)>& body) {
+    grain = std::max<std::size_t>(grain, 1);
+    if (count <= grain || mWorkers.empty()) {
+        if (count > 0) body(0, count);
+        return;
+    }
+
+    // The caller takes the first chunk itself; `body` outlives the jobs since we wait below.
+    std::vector<Handle> chunks;
+    chunks.reserve(count / grain);
+    for (std::size_t begin = grain; begin < count; begin += grain) {
+        std::size_t end = std::min(begin + grain, count);
+        chunks.push_back(Schedule([&body, begin, end] { body(begin, end); }));
+    }
+    body(0, grain);
+    for (const Handle& chunk : chunks) {
+        Wait(chunk);
+    }
+}
+
+
+void JobSystem::Enqueue(std::shared_ptr<Task> task) {
+    int index = CallerIndex();
+    Queue& queue = index >= 0 ? *mQueues[index] : mShared;
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    mQueued.fetch_add(1, std::memory_order_release);
+    {
+        // Taking the lock orders this against a worker that has just found nothing to do.
+        std::lock_guard<std::mutex> lock(mSleepMutex);
+    }
+    mWake.notify_one();
+}
+
+
+std::shared_ptr<JobSystem::Task> JobSystem::Take(int workerIndex) {
+    if (mQueued.load(std::memory_order_acquire) == 0) return nullptr;
+
+    auto popBack = [](Queue& queue) -> std::shared_ptr<Task> {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) return nullptr;
+        std::shared_ptr<Task> task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+        return task;
+    };
+    auto popFront = [](Queue& queue) -> std::shared_ptr<Task> {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) return nullptr;
+        std::shared_ptr<Task> task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        return task;
+    };
+
+    // Own work newest first, then the shared queue, then steal the oldest from the others.
+    std::shared_ptr<Task> task;
+    if (workerIndex >= 0) task = popBack(*mQueues[workerIndex]);
+    if (!task) task = popFront(mShared);
+    const int count = static_cast<int>(mQueues.size());
+    for (int i = 1; !task && i <= count; i++) {
+        int victim = (std::max(workerIndex, 0) + i) % count;
+        task = popFront(*mQueues[victim]);
+    }
+    if (task) mQueued.fetch_sub(1, std::memory_order_acq_rel);
+    return task;
+}
+
+
+bool JobSystem::RunOne(int workerIndex) {
+    std::shared_ptr<Task> task = Take(workerIndex);
+    if (!task) return false;
+    try {
+        task->job();
+    } catch (const std::exception& e) {
+        std::cerr << "Job threw an exception: " << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "Job threw an unknown exception" << std::endl;
+    }
+    task->job = nullptr;  // Release captures now rather than when the last handle goes.
+    Complete(task);
+    return true;
+}
+
+
+void JobSystem::Complete(const std::shared_ptr<Task>& task) {
+    std::vector<std::shared_ptr<Task>> dependents;
+    {
+        std::lock_guard<std::mutex> lock(task->mutex);
+        task->done.store(true, std::memory_order_release);
+        dependents.swap(task->dependents);
+    }
+    for (std::shared_ptr<Task>& dependent : dependents) {
+        if (dependent->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            Enqueue(std::move(dependent));
+        }
+    }
+}
+
+
+void JobSystem::WorkerMain(int index) {
+    tSystem = this;
+    tWorkerIndex = index;
+    while (true) {
+        if (RunOne(index)) continue;
+        std::unique_lock<std::mutex> lock(mSleepMutex);
+        mWake.wait(lock, [this] { return mStopping || mQueued.load(std::memory_order_acquire) > 0; });
+        if (mStopping && mQueued.load(std::memory_order_acquire) == 0) break;
+    }
+}
+
+
+int JobSystem::CallerIndex() const {
+    return tSystem == this ? tWorkerIndex : -1;
+}
@@ -0,0 +1,255 @@
+// Copyright (c) 2025 Thomas Groom
+
+
+#include "ui_library/LayerCache.h"
+#include "ui_library/PickBuffer.h"
+#include "ui_library/RenderThread.h"
+#include "ui_library/Shader.h"
+#include "ui_library/VAO.h"
+#include "ui_library/VBO.h"
+#include <glm/gtc/matrix_transform.hpp>
+
+
+// The sprite shader draws the composited quad; its vertices carry the texture coordinates.
+struct LayerGL {
+    Shader shader;
+    VAO vao;
+    VBO vbo;
+};
+
+
+// Created on the first composite and never destroyed: like FramebufferPool it outlives the GL
+// context, whose objects go with it.
+static LayerGL& GetLayerGL() {
+    static LayerGL* gl = [] {
+        LayerGL* created = new LayerGL();
+        created->shader.Set((std::string(UI_LIBRARY_RESOURCES_DIR) + "/shaders/Sprite.vert").c_str(), (std::string(UI_LIBRARY_RESOURCES_DIR) + "/shaders/Sprite.frag").c_str());
+        created->vbo.Data(std::vector<GLfloat>(6 * 4, 0.0f));
+        created->vao.Bind();
+        created->vao.LinkAttrib(created->vbo, 0, 4, GL_FLOAT, 4 * sizeof(float), (void*)0);
+        created->vao.Unbind();
+        created->shader.Bind().SetInteger("image", 0);
+        created->shader.SetMatrix4("model", glm::mat4(1.0f));
+        created->shader.SetVector3f("spriteColor", glm::vec3(1.0f));
+        created->shader.Unbind();
+        return created;
+    }();
+    return *gl;
+}
+
+
+LayerSurface::~LayerSurface() {
+    FramebufferPool::Target target = mTarget;
+    RenderThread::RunOnGLThread([target] { FramebufferPool::getInstance().Release(target); });
+}
+
+
+void LayerSurface::Composite(const DrawList::Layer& layer) {
+    const DrawList& content = *layer.content;
+    const DrawList::Rect& area = layer.area;
+    const DrawList::Rect& view = layer.view;
+    if (area.Empty() || view.Empty()) return;
+    LayerGL& gl = GetLayerGL();
+    const bool resized = !mTarget.Valid() || mTarget.width != FramebufferPool::BucketSize(area.width) || mTarget.height != FramebufferPool::BucketSize(area.height);
+    if (resized || layer.version != mVersion) {
+        Render(content, area);
+        mVersion = layer.version;
+    }
+
+    int width = 0;
+    int height = 0;
+    DrawList::GetTargetSize(width, height);
+    const float x0 = static_cast<float>(view.x);
+    const float y0 = static_cast<float>(view.y);
+    const float x1 = x0 + view.width;
+    const float y1 = y0 + view.height;
+    // The area sits at the bottom-left of the target, the right way up in GL terms, so window
+    // row r of the recording is target row (area bottom - r).
+    const float areaBottom = static_cast<float>(area.y + area.height);
+    const float u0 = static_cast<float>(view.x - area.x) / mTarget.width;
+    const float u1 = static_cast<float>(view.x + view.width - area.x) / mTarget.width;
+    const float vTop = (areaBottom - (view.y + layer.scroll)) / mTarget.height;
+    const float vBottom = (areaBottom - (view.y + view.height + layer.scroll)) / mTarget.height;
+    gl.vbo.Data({
+        x0, y0, u0, vTop,
+        x1, y1, u1, vBottom,
+        x0, y1, u0, vBottom,
+
+        x0, y0, u0, vTop,
+        x1, y0, u1, vTop,
+        x1, y1, u1, vBottom
+    });
+
+    gl.shader.Bind();
+    gl.shader.SetMatrix4("projection", glm::ortho(0.0f, static_cast<float>(width), static_cast<float>(height), 0.0f, -1.0f, 1.0f));
+    GLint blend[4];
+    glGetIntegerv(GL_BLEND_SRC_RGB, &blend[0]);
+    glGetIntegerv(GL_BLEND_DST_RGB, &blend[1]);
+    glGetIntegerv(GL_BLEND_SRC_ALPHA, &blend[2]);
+    glGetIntegerv(GL_BLEND_DST_ALPHA, &blend[3]);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);   // The target holds premultiplied colour.
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, mTarget.texture);
+    gl.vao.Bind();
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    gl.vao.Unbind();
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBlendFuncSeparate(blend[0], blend[1], blend[2], blend[3]);
+    gl.shader.Unbind();
+
+    // The pick pass needs the real shapes: replay them into it, with colour writes off, over
+    // the cursor's square, moved up by the scroll.
+    PickBuffer& picker = PickBuffer::getInstance();
+    DrawList::Rect region = picker.IsActive() ? picker.Region().Intersect(view) : DrawList::Rect();
+    if (!region.Empty()) {
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        glViewport(viewport[0], viewport[1] + layer.scroll, viewport[2], viewport[3]);
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        DrawList::PushScissor(region.x, height - region.y - region.height, region.width, region.height);
+        content.SubmitOffset(0, layer.scroll);
+        DrawList::PopScissor();
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    }
+}
+
+
+void LayerSurface::Render(const DrawList& content, const DrawList::Rect& area) {
+    FramebufferPool& pool = FramebufferPool::getInstance();
+    if (!mTarget.Valid() || mTarget.width != FramebufferPool::BucketSize(area.width) || mTarget.height != FramebufferPool::BucketSize(area.height)) {
+        pool.Release(mTarget);
+        mTarget = pool.Acquire(area.width, area.height);
+    }
+
+    int width = 0;
+    int height = 0;
+    DrawList::GetTargetSize(width, height);
+    GLint previousFBO = 0;
+    GLint viewport[4];
+    GLint scissor[4];
+    GLfloat clearColour[4];
+    GLint blend[4];
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFBO);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glGetIntegerv(GL_SCISSOR_BOX, scissor);
+    GLboolean scissorEnabled = glIsEnabled(GL_SCISSOR_TEST);
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColour);
+    glGetIntegerv(GL_BLEND_SRC_RGB, &blend[0]);
+    glGetIntegerv(GL_BLEND_DST_RGB, &blend[1]);
+    glGetIntegerv(GL_BLEND_SRC_ALPHA, &blend[2]);
+    glGetIntegerv(GL_BLEND_DST_ALPHA, &blend[3]);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, mTarget.fbo);
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(0, 0, area.width, area.height);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    // The window's projection, shifted so the area lands at the target's origin.
+    glViewport(-area.x, -(height - area.y - area.height), width, height);
+    // Alpha accumulates as coverage, leaving premultiplied colour to composite.
+    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    PickBuffer& picker = PickBuffer::getInstance();
+    picker.SetSuspended(true);
+    content.SubmitToLayer(area);
+    picker.SetSuspended(false);
+
+    glBlendFuncSeparate(blend[0], blend[1], blend[2], blend[3]);
+    glClearColor(clearColour[0], clearColour[1], clearColour[2], clearColour[3]);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    glScissor(scissor[0], scissor[1], scissor[2], scissor[3]);
+    if (!scissorEnabled) {
+        glDisable(GL_SCISSOR_TEST);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFBO);
+}
+
+
+LayerCache::LayerCache() : mSurface(std::make_shared<LayerSurface>()) {}
+
+
+std::vector<std::uint8_t> LayerCache::HandlerStates() const {
+    std::vector<std::uint8_t> states;
+    states.reserve(mHandlers.size());
+    for (MouseHandler::Handle handle : mHandlers) {
+        const MouseHandler* handler = MouseHandler::Find(handle);
+        if (!handler) {
+            states.push_back(0xFF);  // Destroyed: whatever it drew is out of date.
+            continue;
+        }
+        std::uint8_t state = (handler->IsHovered() ? 1 : 0) | (handler->IsNear() ? 2 : 0);
+        states.push_back(static_cast<std::uint8_t>(state | ((handler->Interactions() & 0x3F) << 2)));
+    }
+    return states;
+}
+
+
+void LayerCache::Draw(const DrawList::Rect& area, std::uint64_t version, const std::function<void()>& draw) {
+    Draw(area, area, 0, version, draw);
+}
+
+
+void LayerCache::Draw(const DrawList::Rect& area, const DrawList::Rect& view, int scroll, std::uint64_t version, const std::function<void()>& draw) {
+    if (IsStale(area, version)) {
+        Record(area, version, draw);
+    }
+    Present(view, scroll);
+}
+
+
+bool LayerCache::HasRecording(const DrawList::Rect& area) const {
+    return mContent && area.x == mArea.x && area.y == mArea.y && area.width == mArea.width && area.height == mArea.height;
+}
+
+
+bool LayerCache::IsStale(const DrawList::Rect& area, std::uint64_t version) const {
+    return mDirty || !HasRecording(area) || version != mVersion || IsCapturing() || HandlerStates() != mHandlerStates;
+}
+
+
+bool LayerCache::IsCapturing() const {
+    for (MouseHandler::Handle handle : mHandlers) {
+        const MouseHandler* handler = MouseHandler::Find(handle);
+        if (handler && (handler->IsHeld() || handler->HasFocus())) return true;
+    }
+    return false;
+}
+
+
+void LayerCache::Record(const DrawList::Rect& area, std::uint64_t version, const std::function<void()>& draw) {
+    // A new list rather than clearing the old one, which a render thread may be drawing.
+    mContent = std::make_shared<DrawList>();
+    {
+        DrawList::Recording recording(mContent.get());
+        draw();
+    }
+    mHandlers.clear();
+    mHandlerY.clear();
+    for (MouseHandler* handler : mContent->TakeDrawn()) {
+        mHandlers.push_back(handler->GetHandle());
+        mHandlerY.push_back(handler->mContainer.y);
+    }
+    mHandlerStates = HandlerStates();
+    mArea = area;
+    mVersion = version;
+    mRecording++;
+    mDirty = false;
+}
+
+
+void LayerCache::Present(const DrawList::Rect& view, int scroll) {
+    if (!mContent) return;
+    for (std::size_t i = 0; i < mHandlers.size(); i++) {
+        if (MouseHandler* handler = MouseHandler::Find(mHandlers[i])) {
+            handler->mContainer.y = mHandlerY[i] - scroll;
+            handler->SetDrawn();
+        }
+    }
+
+    DrawList::Layer layer = { mSurface, mContent, mRecording, mArea, view, scroll };
+    if (DrawList* list = DrawList::Current()) {
+        list->AddLayer(std::move(layer));
+    } else {
+        mSurface->Composite(layer);
+    }
+}
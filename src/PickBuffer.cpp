@@ -0,0 +1,186 @@
+// Copyright (c) 2025 Thomas Groom
+
+
+#include "ui_library/PickBuffer.h"
+#include <algorithm>
+#include <iostream>
+#include <glm/gtc/type_ptr.hpp>
+
+
+void PickBuffer::EnsureTarget(int width, int height) {
+    if (mFBO == 0) {
+        mShader.Set((std::string(UI_LIBRARY_RESOURCES_DIR) + "/shaders/Pick.vert").c_str(), (std::string(UI_LIBRARY_RESOURCES_DIR) + "/shaders/Pick.frag").c_str());
+        mShader.Bind();
+        mIdLocation = glGetUniformLocation(mShader.ID, "id");
+        mMVPLocation = glGetUniformLocation(mShader.ID, "uMVPMatrix");
+        mShader.Unbind();
+
+        glGenFramebuffers(1, &mFBO);
+        glGenTextures(1, &mTexture);
+        for (Readback& readback : mReadbacks) {
+            glGenBuffers(1, &readback.pbo);
+        }
+    }
+
+    if (width == mWidth && height == mHeight) return;
+    mWidth = width;
+    mHeight = height;
+
+    glBindTexture(GL_TEXTURE_2D, mTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, width, height, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    GLint previous = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+    glBindFramebuffer(GL_FRAMEBUFFER, mFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mTexture, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Pick buffer framebuffer is incomplete; GPU picking disabled" << std::endl;
+        mEnabled = false;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, previous);
+}
+
+
+void PickBuffer::BeginFrame(int cursorX, int cursorY, int width, int height) {
+    mActive = false;
+    if (!mEnabled || width <= 0 || height <= 0) return;
+    EnsureTarget(width, height);
+    if (!mEnabled) return;
+
+    // Square around the cursor, flipped to GL's bottom-left origin and clipped to the target.
+    int glX = cursorX;
+    int glY = height - 1 - cursorY;
+    int x0 = std::clamp(glX - mRadius, 0, width);
+    int y0 = std::clamp(glY - mRadius, 0, height);
+    int x1 = std::clamp(glX + mRadius + 1, 0, width);
+    int y1 = std::clamp(glY + mRadius + 1, 0, height);
+    if (x1 <= x0 || y1 <= y0) return;  // Cursor outside the window.
+
+    mRegionX = x0;
+    mRegionY = y0;
+    mRegionW = x1 - x0;
+    mRegionH = y1 - y0;
+    mCenterX = glX - x0;
+    mCenterY = glY - y0;
+
+    GLint previous = 0;
+    GLint scissor[4];
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+    glGetIntegerv(GL_SCISSOR_BOX, scissor);
+    glBindFramebuffer(GL_FRAMEBUFFER, mFBO);
+    glScissor(mRegionX, mRegionY, mRegionW, mRegionH);
+    const GLuint zero[4] = { 0, 0, 0, 0 };
+    glClearBufferuiv(GL_COLOR, 0, zero);
+    glScissor(scissor[0], scissor[1], scissor[2], scissor[3]);
+    glBindFramebuffer(GL_FRAMEBUFFER, previous);
+
+    mActive = true;
+}
+
+
+void PickBuffer::BeginPick(std::uint32_t id, const glm::mat4& mvp) {
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &mSavedFBO);
+    glGetIntegerv(GL_CURRENT_PROGRAM, &mSavedProgram);
+    glGetIntegerv(GL_SCISSOR_BOX, mSavedScissor);
+    glGetBooleanv(GL_COLOR_WRITEMASK, mSavedColourMask);
+
+    // Keep the caller's clipping, further limited to the region around the cursor.
+    int x0 = std::max(mSavedScissor[0], mRegionX);
+    int y0 = std::max(mSavedScissor[1], mRegionY);
+    int x1 = std::min(mSavedScissor[0] + mSavedScissor[2], mRegionX + mRegionW);
+    int y1 = std::min(mSavedScissor[1] + mSavedScissor[3], mRegionY + mRegionH);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, mFBO);
+    glScissor(x0, y0, std::max(0, x1 - x0), std::max(0, y1 - y0));
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);  // The caller may be drawing for picking only.
+    mShader.Bind();
+    glUniform1ui(mIdLocation, id);
+    glUniformMatrix4fv(mMVPLocation, 1, GL_FALSE, glm::value_ptr(mvp));
+}
+
+
+void PickBuffer::EndPick() {
+    glUseProgram(mSavedProgram);
+    glScissor(mSavedScissor[0], mSavedScissor[1], mSavedScissor[2], mSavedScissor[3]);
+    glColorMask(mSavedColourMask[0], mSavedColourMask[1], mSavedColourMask[2], mSavedColourMask[3]);
+    glBindFramebuffer(GL_FRAMEBUFFER, mSavedFBO);
+}
+
+
+void PickBuffer::EndFrame() {
+    if (!mActive) return;
+    mActive = false;
+
+    Readback& readback = mReadbacks[mWriteIndex];
+    if (readback.fence) {
+        // Still in flight from two frames ago; its result is stale now anyway.
+        glDeleteSync(readback.fence);
+        readback.fence = nullptr;
+    }
+
+    GLint previous = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, mFBO);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+    glBufferData(GL_PIXEL_PACK_BUFFER, mRegionW * mRegionH * sizeof(std::uint32_t), nullptr, GL_STREAM_READ);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    // With a pack buffer bound this only queues the copy; the data pointer is an offset.
+    glReadPixels(mRegionX, mRegionY, mRegionW, mRegionH, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, previous);
+
+    readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    readback.width = mRegionW;
+    readback.height = mRegionH;
+    readback.centerX = mCenterX;
+    readback.centerY = mCenterY;
+    mWriteIndex ^= 1;
+}
+
+
+void PickBuffer::Poll() {
+    if (mFBO == 0) return;
+    // Oldest first: the buffer about to be written next was written first.
+    for (int i = 0; i < 2; i++) {
+        Readback& readback = mReadbacks[(mWriteIndex + i) & 1];
+        if (!readback.fence) continue;
+        GLenum status = glClientWaitSync(readback.fence, 0, 0);  // Never waits.
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) continue;
+        glDeleteSync(readback.fence);
+        readback.fence = nullptr;
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+        const void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, readback.width * readback.height * sizeof(std::uint32_t), GL_MAP_READ_BIT);
+        if (data) {
+            mPickedId = Resolve(static_cast<const std::uint32_t*>(data), readback);
+            mHasResult = true;
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+}
+
+
+// The ID under the cursor, or failing that the nearest ID within the region.
+std::uint32_t PickBuffer::Resolve(const std::uint32_t* pixels, const Readback& readback) const {
+    std::uint32_t best = 0;
+    int bestDistance = 0;
+    for (int y = 0; y < readback.height; y++) {
+        for (int x = 0; x < readback.width; x++) {
+            std::uint32_t id = pixels[y * readback.width + x];
+            if (id == 0) continue;
+            int dx = x - readback.centerX;
+            int dy = y - readback.centerY;
+            int distance = dx * dx + dy * dy;
+            if (best == 0 || distance < bestDistance) {
+                best = id;
+                bestDistance = distance;
+            }
+        }
+    }
+    return best;
+}
@@ -0,0 +1,176 @@
+// Copyright (c) 2025 Thomas Groom
+
+
+#include "ui_library/RenderThread.h"
+#include "ui_library/FramePacer.h"
+#include "ui_library/PickBuffer.h"
+#include "ui_library/BackBuffer.h"
+
+#include <atomic>
+#include <iostream>
+
+
+static std::atomic<RenderThread*> sActive{ nullptr };
+static thread_local bool tOwnsContext = false;
+
+
+RenderThread::RenderThread(FramePacer& pacer) : mPacer(pacer) {
+    for (int i = 0; i < kPacketCount; i++) {
+        mFree.push_back(i);
+    }
+}
+
+
+RenderThread::~RenderThread() {
+    Stop();
+}
+
+
+void RenderThread::Start(GLFWwindow* window) {
+    if (IsRunning()) return;
+    mWindow = window;
+    mStopping = false;
+    sActive.store(this, std::memory_order_release);
+    glfwMakeContextCurrent(nullptr);  // A context can only be current on one thread.
+    mThread = std::thread(&RenderThread::Main, this);
+}
+
+
+void RenderThread::Stop() {
+    if (!IsRunning()) return;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mCondVar.notify_all();
+    mThread.join();
+
+    glfwMakeContextCurrent(mWindow);
+    std::vector<std::function<void()>> work;
+    {
+        std::lock_guard<std::mutex> lock(mWorkMutex);
+        work.swap(mPendingWork);
+    }
+    for (std::function<void()>& item : work) {
+        item();
+    }
+    sActive.store(nullptr, std::memory_order_release);
+}
+
+
+RenderThread::FramePacket& RenderThread::BeginPacket() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCondVar.wait(lock, [this] { return !mFree.empty(); });
+    mRecording = mFree.front();
+    mFree.pop_front();
+    return mPackets[mRecording];
+}
+
+
+void RenderThread::SubmitPacket() {
+    if (mRecording < 0) {
+        std::cerr << "RenderThread::SubmitPacket without a matching BeginPacket" << std::endl;
+        return;
+    }
+    FramePacket& packet = mPackets[mRecording];
+    {
+        std::lock_guard<std::mutex> lock(mWorkMutex);
+        packet.glWork.swap(mPendingWork);
+    }
+    // Some deferred commands touch the widgets, and some objects drawn are not kept alive by
+    // the packet, so the UI waits for those to have been drawn.
+    bool waitForDraw = packet.drawList.MustWait();
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    mQueued.push_back(mRecording);
+    mRecording = -1;
+    std::uint64_t frame = ++mSubmitted;
+    mCondVar.notify_all();
+    if (waitForDraw) {
+        mCondVar.wait(lock, [this, frame] { return mDrawn >= frame; });
+    }
+}
+
+
+void RenderThread::Flush() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCondVar.wait(lock, [this] { return mPresented >= mSubmitted; });
+}
+
+
+bool RenderThread::IsRenderThread() {
+    return tOwnsContext;
+}
+
+
+void RenderThread::RunOnGLThread(std::function<void()> work) {
+    RenderThread* active = sActive.load(std::memory_order_acquire);
+    if (!active || tOwnsContext) {
+        work();
+        return;
+    }
+    std::lock_guard<std::mutex> lock(active->mWorkMutex);
+    active->mPendingWork.push_back(std::move(work));
+}
+
+
+void RenderThread::Main() {
+    tOwnsContext = true;
+    glfwMakeContextCurrent(mWindow);
+    mPacer.Apply();  // The swap interval belongs to the context's current thread.
+    mViewportWidth = 0;
+    mViewportHeight = 0;
+
+    while (true) {
+        int index;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondVar.wait(lock, [this] { return mStopping || !mQueued.empty(); });
+            if (mQueued.empty()) break;
+            index = mQueued.front();
+            mQueued.pop_front();
+        }
+        FramePacket& packet = mPackets[index];
+
+        if (packet.width != mViewportWidth || packet.height != mViewportHeight) {
+            glViewport(0, 0, packet.width, packet.height);
+            mViewportWidth = packet.width;
+            mViewportHeight = packet.height;
+        }
+        DrawList::SetTargetSize(packet.width, packet.height);
+        glScissor(0, 0, packet.width, packet.height);
+
+        PickBuffer& picker = PickBuffer::getInstance();
+        picker.Poll();
+        picker.BeginFrame(packet.cursorX, packet.cursorY, packet.width, packet.height);
+        if (packet.partial) {
+            BackBuffer::getInstance().Draw(packet.drawList, std::move(packet.damage), packet.width, packet.height);
+        } else {
+            packet.drawList.Submit();
+        }
+        picker.EndFrame();
+        for (std::function<void()>& work : packet.glWork) {
+            work();
+        }
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mDrawn++;
+        }
+        mCondVar.notify_all();
+
+        mPacer.Present(mWindow, packet.frameStart);
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            packet.drawList.Clear();
+            packet.glWork.clear();
+            packet.damage.clear();
+            mFree.push_back(index);
+            mPresented++;
+        }
+        mCondVar.notify_all();
+    }
+
+    glfwMakeContextCurrent(nullptr);
+    tOwnsContext = false;
+}
@@ -0,0 +1,118 @@
+// Copyright (c) 2025 Thomas Groom
+
+
+#include "ui_library/Resources.h"
+
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+
+#include "ui_library/Config.h"
+
+
+static std::mutex sOverrideMutex;
+static std::filesystem::path sOverrideDirectory;
+
+
+void Resources::SetOverrideDirectory(const std::filesystem::path& directory) {
+    std::lock_guard<std::mutex> lock(sOverrideMutex);
+    sOverrideDirectory = directory;
+}
+
+
+static std::filesystem::path OverrideDirectory() {
+    std::lock_guard<std::mutex> lock(sOverrideMutex);
+    return sOverrideDirectory;
+}
+
+
+// Maps a path inside UI_LIBRARY_RESOURCES_DIR, or a relative path naming a resource that
+// exists (embedded, in the override directory or in UI_LIBRARY_RESOURCES_DIR), to a resource
+// name. Returns an empty string for any other path, which is then read as given.
+std::string Resources::Name(const std::filesystem::path& path) {
+    static const std::filesystem::path sResourcesDir = std::filesystem::path(UI_LIBRARY_RESOURCES_DIR).lexically_normal();
+    if (path.is_relative()) {
+        std::string name = path.lexically_normal().generic_string();
+        if (name.empty() || name.rfind("..", 0) == 0) {
+            return {};
+        }
+        std::error_code error;
+        std::filesystem::path overrideDirectory = OverrideDirectory();
+        if (FindEmbedded(name) ||
+            (!overrideDirectory.empty() && std::filesystem::is_regular_file(overrideDirectory / name, error)) ||
+            std::filesystem::is_regular_file(sResourcesDir / name, error)) {
+            return name;
+        }
+        return {};
+    }
+
+    std::filesystem::path relative = path.lexically_normal().lexically_relative(sResourcesDir);
+    if (relative.empty() || *relative.begin() == "..") {
+        return {};
+    }
+    return relative.generic_string();
+}
+
+
+const EmbeddedResource* Resources::FindEmbedded(const std::string& name) {
+    // Built on first use; the table is immutable, so concurrent lookups afterwards are safe.
+    static const std::unordered_map<std::string, const EmbeddedResource*> sIndex = []() {
+        std::unordered_map<std::string, const EmbeddedResource*> index;
+        for (size_t i = 0; i < gEmbeddedResourceCount; ++i) {
+            index.emplace(gEmbeddedResources[i].name, &gEmbeddedResources[i]);
+        }
+        return index;
+    }();
+
+    auto found = sIndex.find(name);
+    return found != sIndex.end() ? found->second : nullptr;
+}
+
+
+Resource Resources::ReadFile(const std::filesystem::path& file) {
+    Resource resource;
+    std::ifstream in(file, std::ios::binary | std::ios::ate);
+    if (!in) {
+        return resource;
+    }
+
+    std::streamsize size = in.tellg();
+    in.seekg(0, std::ios::beg);
+    // Keep a terminating zero like the embedded data, so text can be used as a C string.
+    resource.mStorage.resize(static_cast<size_t>(size) + 1, 0);
+    if (!in.read(reinterpret_cast<char*>(resource.mStorage.data()), size)) {
+        return Resource();
+    }
+    resource.mData = resource.mStorage.data();
+    resource.mSize = static_cast<size_t>(size);
+    return resource;
+}
+
+
+Resource Resources::Load(const std::filesystem::path& path) {
+    std::string name = Name(path);
+    if (name.empty()) {
+        return ReadFile(path);
+    }
+
+    std::filesystem::path overrideDirectory = OverrideDirectory();
+    if (!overrideDirectory.empty()) {
+        Resource resource = ReadFile(overrideDirectory / name);
+        if (resource) return resource;
+    }
+
+    if (const EmbeddedResource* embedded = FindEmbedded(name)) {
+        Resource resource;
+        resource.mData = embedded->data;
+        resource.mSize = embedded->size;
+        return resource;
+    }
+
+    return ReadFile(std::filesystem::path(UI_LIBRARY_RESOURCES_DIR) / name);
+}
+
+
+bool Resources::IsEmbedded(const std::filesystem::path& path) {
+    std::string name = Name(path);
+    return !name.empty() && FindEmbedded(name) != nullptr;
+}
@@ -0,0 +1,31 @@
+// Copyright (c) 2025 Thomas Groom
+
+
+#include "ui_library/ScrollView.h"
+#include <algorithm>
+
+
+void ScrollView::Draw(Boundary viewport, int contentHeight, const std::function<void(int offset)>& draw, Colour col, std::uint64_t version) {
+    mScrollbar.Draw(viewport, contentHeight, col);
+    const int scroll = mScrollbar.scrollOffset;
+    const int bandHeight = viewport.height + 2 * mMargin;
+
+    if (contentHeight != mContentHeight) {
+        mContentHeight = contentHeight;
+        mLayer.Invalidate();
+    }
+    if (mRenderOffset < 0 || scroll < mRenderOffset || scroll + viewport.height > mRenderOffset + bandHeight) {
+        // Re-centre the band on the viewport so there is room to scroll either way.
+        mRenderOffset = std::max(scroll - mMargin, 0);
+        mLayer.Invalidate();
+    }
+
+    // The band is laid out from the viewport's top edge down; the view shows the part of it
+    // that the scroll has reached.
+    DrawList::Rect area = { viewport.x, viewport.y, viewport.width, bandHeight };
+    DrawList::Rect view = { viewport.x, viewport.y, viewport.width, viewport.height };
+    const int renderOffset = mRenderOffset;
+    DrawList::PushScissor(viewport.x, mUI->G_HEIGHT - (viewport.y + viewport.height), viewport.width, viewport.height);
+    mLayer.Draw(area, view, scroll - renderOffset, version, [&draw, renderOffset] { draw(renderOffset); });
+    DrawList::PopScissor();
+}
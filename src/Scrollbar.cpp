@@ -6,19 +6,18 @@
 
 Scrollbar::Scrollbar(UI* _ui) : mUI(_ui) {
     layer = 1;  // Layer 1 is used for scroll bars
+    SetMouseEvents(MouseEvent::SCROLL);
 
 	mScrollBoxButton = new Button(mUI, UIText, L"", Text::CENTER_MIDDLE, {0, 0, 6, 100}, 6 / 2, 0.0f, 0, 0, 1);
 }
 
-void Scrollbar::MouseCallback(int _mouseState) {
-    if (mUI->G_SCROLL_TRIGGER) {
-        normalizedScrollOffset += -(mUI->G_SCROLL_Y * 50.0f) / mMaxScrollHeight;
-    }
+void Scrollbar::OnMouseEvent(const MouseEvent& /*event*/) {
+    normalizedScrollOffset += -(mUI->G_SCROLL_Y * 50.0f) / mMaxScrollHeight;
 }
 
 void Scrollbar::Draw(Boundary scrollContainer, int fullHeight, Colour col) {
-    isDrawn = true;
     mContainer = scrollContainer;
+    SetDrawn();
 
 	// TODO: Drag scroll bar button functionality
 
@@ -2,20 +2,17 @@
 
 
 #include "ui_library/Shader.h"
+#include "ui_library/Resources.h"
+#include "ui_library/StartupTrace.h"
+#include "ui_library/RenderThread.h"
 
-// Reads a text file and outputs a string with everything in the text file
+// Reads a text file (or embedded resource) and outputs a string with everything in it
 std::string get_file_contents(const char* filename)
 {
-	std::ifstream in(filename, std::ios::binary);
-	if (in)
+	Resource resource = Resources::Load(filename);
+	if (resource)
 	{
-		std::string contents;
-		in.seekg(0, std::ios::end);
-		contents.resize(in.tellg());
-		in.seekg(0, std::ios::beg);
-		in.read(&contents[0], contents.size());
-		in.close();
-		return(contents);
+		return resource.String();
 	}
 	throw(errno);
 }
@@ -24,9 +21,23 @@ Shader::Shader(){};
 
 void Shader::Set(const char* vertexFile, const char* fragmentFile)
 {
+	if (ID != 0)
+	{
+		GLuint id = ID;
+		RenderThread::RunOnGLThread([id] { glDeleteProgram(id); });
+		ID = 0;
+	}
+	mVertexFile = vertexFile;
+	mFragmentFile = fragmentFile;
+}
+
+void Shader::CompileFiles()
+{
+	StartupTrace::ScopedPhase phase("shaders");
+
 	// Read vertexFile and fragmentFile and store the strings
-	std::string vertexCode = get_file_contents(vertexFile);
-	std::string fragmentCode = get_file_contents(fragmentFile);
+	std::string vertexCode = get_file_contents(mVertexFile.c_str());
+	std::string fragmentCode = get_file_contents(mFragmentFile.c_str());
 
 	// Convert the shader source strings into character arrays
 	const char* vertexSource = vertexCode.c_str();
@@ -63,12 +74,17 @@ void Shader::Set(const char* vertexFile, const char* fragmentFile)
 
 Shader::~Shader()
 {
-    glDeleteProgram(ID);
+    if (ID != 0) {
+        GLuint id = ID;
+        RenderThread::RunOnGLThread([id] { glDeleteProgram(id); });
+    }
 }
 
 
 Shader &Shader::Bind()
 {
+    if (this->ID == 0 && !mVertexFile.empty())
+        CompileFiles();
     glUseProgram(this->ID);
     return *this;
 }
@@ -0,0 +1,165 @@
+// Copyright (c) 2025 Thomas Groom
+
+
+#include "ui_library/StartupTrace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+
+std::atomic<bool> StartupTrace::sActive{false};
+
+static std::mutex sEventMutex;
+static std::vector<StartupTrace::Event> sEvents;
+static std::chrono::steady_clock::time_point sOrigin = std::chrono::steady_clock::now();
+static double sEndTime = -1.0;
+
+
+// `text` as the contents of a JSON string literal.
+static std::string EscapeJson(const std::string& text) {
+    std::string escaped;
+    escaped.reserve(text.size());
+    for (char c : text) {
+        switch (c) {
+        case '"': escaped += "\\\""; break;
+        case '\\': escaped += "\\\\"; break;
+        case '\n': escaped += "\\n"; break;
+        case '\r': escaped += "\\r"; break;
+        case '\t': escaped += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char code[7];
+                std::snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned char>(c));
+                escaped += code;
+            } else {
+                escaped += c;
+            }
+        }
+    }
+    return escaped;
+}
+
+
+double StartupTrace::Now() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - sOrigin).count();
+}
+
+
+void StartupTrace::Begin() {
+    std::lock_guard<std::mutex> lock(sEventMutex);
+    sEvents.clear();
+    sOrigin = std::chrono::steady_clock::now();
+    sEndTime = -1.0;
+    sActive.store(true);
+}
+
+
+void StartupTrace::End() {
+    std::lock_guard<std::mutex> lock(sEventMutex);
+    if (sActive.exchange(false)) {
+        sEndTime = Now();
+    }
+}
+
+
+double StartupTrace::Elapsed() {
+    std::lock_guard<std::mutex> lock(sEventMutex);
+    return sEndTime >= 0.0 ? sEndTime : Now();
+}
+
+
+void StartupTrace::Record(const char* name, double start, double end) {
+    // Small, stable per-thread numbers read better in trace viewers than hashed thread IDs.
+    static std::unordered_map<std::size_t, unsigned int> sThreadNumbers;
+
+    std::lock_guard<std::mutex> lock(sEventMutex);
+    if (!sActive.load()) return;
+    std::size_t threadHash = std::hash<std::thread::id>()(std::this_thread::get_id());
+    auto inserted = sThreadNumbers.emplace(threadHash, static_cast<unsigned int>(sThreadNumbers.size()));
+    sEvents.push_back({ name, start, end - start, inserted.first->second });
+}
+
+
+std::vector<StartupTrace::Event> StartupTrace::Events() {
+    std::lock_guard<std::mutex> lock(sEventMutex);
+    return sEvents;
+}
+
+
+StartupTrace::ScopedPhase::ScopedPhase(const char* name)
+    : mName(name), mStart(0.0), mActive(StartupTrace::IsActive()) {
+    if (mActive) {
+        mStart = StartupTrace::Now();
+    }
+}
+
+
+StartupTrace::ScopedPhase::~ScopedPhase() {
+    if (mActive) {
+        StartupTrace::Record(mName, mStart, StartupTrace::Now());
+    }
+}
+
+
+void StartupTrace::Print(std::ostream& out) {
+    struct Summary {
+        double first;
+        double total;
+        int count;
+    };
+
+    std::vector<Event> events = Events();
+    std::vector<std::string> order;
+    std::unordered_map<std::string, Summary> summaries;
+    for (const Event& e : events) {
+        auto inserted = summaries.emplace(e.name, Summary{ e.start, 0.0, 0 });
+        if (inserted.second) order.push_back(e.name);
+        inserted.first->second.first = std::min(inserted.first->second.first, e.start);
+        inserted.first->second.total += e.duration;
+        inserted.first->second.count += 1;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](const std::string& a, const std::string& b) {
+        return summaries[a].first < summaries[b].first;
+    });
+
+    std::ios::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(2);
+    out << "Startup trace (" << Elapsed() * 1000.0 << " ms to first frame)" << std::endl;
+    for (const std::string& name : order) {
+        const Summary& s = summaries[name];
+        out << "  " << std::left << std::setw(20) << name << std::right
+            << std::setw(9) << s.total * 1000.0 << " ms"
+            << "  x" << std::setw(4) << std::left << s.count << std::right
+            << "  first at " << s.first * 1000.0 << " ms" << std::endl;
+    }
+    out.flags(flags);
+}
+
+
+bool StartupTrace::WriteChromeTrace(const std::filesystem::path& file) {
+    std::ofstream out(file);
+    if (!out) {
+        std::cerr << "Could not write startup trace: " << file.string() << std::endl;
+        return false;
+    }
+
+    std::vector<Event> events = Events();
+    out << "{\"traceEvents\":[\n";
+    for (size_t i = 0; i < events.size(); ++i) {
+        const Event& e = events[i];
+        out << "{\"name\":\"" << EscapeJson(e.name) << "\",\"cat\":\"startup\",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.thread
+            << ",\"ts\":" << static_cast<long long>(e.start * 1e6)
+            << ",\"dur\":" << static_cast<long long>(e.duration * 1e6) << "}"
+            << (i + 1 < events.size() ? ",\n" : "\n");
+    }
+    out << "],\"displayTimeUnit\":\"ms\"}\n";
+    return static_cast<bool>(out);
+}
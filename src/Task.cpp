@@ -0,0 +1,105 @@
+// Copyright (c) 2025 Thomas Groom
+
+
+#include "ui_library/Task.h"
+
+#ifdef UI_LIBRARY_COROUTINES
+
+#include "ui_library/CommandQueue.h"
+#include "ui_library/JobSystem.h"
+#include "ui_library/Utils.h"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+
+void TaskPromiseBase::ReportException() const {
+    if (!mException) return;
+    try {
+        std::rethrow_exception(mException);
+    } catch (const std::exception& e) {
+        std::cerr << "Task threw an exception: " << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "Task threw an unknown exception" << std::endl;
+    }
+}
+
+
+void TaskScheduler::Spawn(Task<> task) {
+    std::coroutine_handle<TaskPromise<void>> handle = std::exchange(task.mHandle, {});
+    if (!handle) return;
+    handle.promise().mDetached = true;
+    handle.resume();  // Frees itself at its final suspend point, possibly right here.
+}
+
+
+double TaskScheduler::ResumeFrame(double now) {
+    std::vector<std::coroutine_handle<>> ready;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        // Tasks that wait for the next frame while being resumed here wait for the one after.
+        ready.swap(mNextFrame);
+        while (!mTimers.empty() && mTimers.front().time <= now) {
+            std::pop_heap(mTimers.begin(), mTimers.end(), &TaskScheduler::Later);
+            ready.push_back(mTimers.back().handle);
+            mTimers.pop_back();
+        }
+    }
+    for (std::coroutine_handle<> handle : ready) {
+        handle.resume();
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mNextFrame.empty()) {
+        return now;
+    }
+    return mTimers.empty() ? std::numeric_limits<double>::infinity() : mTimers.front().time;
+}
+
+
+void TaskScheduler::WaitFrame(std::coroutine_handle<> handle) {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mNextFrame.push_back(handle);
+    }
+    UI::PostInvalidate();
+}
+
+
+void TaskScheduler::WaitUntil(double time, std::coroutine_handle<> handle) {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mTimers.push_back({ time, handle });
+        std::push_heap(mTimers.begin(), mTimers.end(), &TaskScheduler::Later);
+    }
+    UI::PostInvalidate();  // So a waiting loop picks up the new deadline from ResumeFrame.
+}
+
+
+void TaskScheduler::RunBlocking(std::function<void()> work, std::coroutine_handle<> handle) {
+    std::thread([work = std::move(work), handle] {
+        work();
+        CommandQueue::getInstance().Post([handle] { handle.resume(); });
+    }).detach();
+}
+
+
+void DelayAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    TaskScheduler::getInstance().WaitUntil(glfwGetTime() + milliseconds / 1000.0, handle);
+}
+
+
+bool ThreadPoolAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    JobSystem* jobs = JobSystem::Current();
+    if (!jobs) return false;
+    jobs->Schedule([handle] { handle.resume(); });
+    return true;
+}
+
+
+void UiThreadAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    CommandQueue::getInstance().Post([handle] { handle.resume(); });
+}
+
+#endif  // UI_LIBRARY_COROUTINES
@@ -2,29 +2,110 @@
 
 
 #include "ui_library/Text.h"
+#include "ui_library/Resources.h"
+#include "ui_library/StartupTrace.h"
+#include "ui_library/RenderThread.h"
 
 
+// Makes no GL calls, so a Text can be built before GL is loaded.
 Text::Text(std::string font, unsigned int fontSize) {
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     TextShader.Set((std::string(UI_LIBRARY_RESOURCES_DIR) + "/shaders/Text.vert").c_str(), (std::string(UI_LIBRARY_RESOURCES_DIR) + "/shaders/Text.frag").c_str());
 
     Load(font, fontSize);
 }
 
 
+// Only records the font; glyphs are rasterised the first time text is measured or drawn.
 void Text::Load(std::string font, unsigned int fontSize)
 {
+    std::lock_guard<std::mutex> lock(mLoadMutex);
+    mFontFile = font;
     mFontSize = fontSize;
+    mLoaded = false;
+}
+
+
+// Rasterises on whichever thread first needs the metrics; textures are uploaded by EnsureUploaded.
+void Text::EnsureLoaded()
+{
+    if (mLoaded.load(std::memory_order_acquire)) return;
+    std::lock_guard<std::mutex> lock(mLoadMutex);
+    if (!mLoaded.load(std::memory_order_relaxed)) {
+        LoadGlyphs();
+        mLoaded.store(true, std::memory_order_release);
+    }
+}
+
+
+void Text::EnsureUploaded()
+{
+    EnsureLoaded();
+    std::lock_guard<std::mutex> lock(mLoadMutex);
+    if (!mStaleTextures.empty()) {
+        glDeleteTextures(static_cast<GLsizei>(mStaleTextures.size()), mStaleTextures.data());
+        mStaleTextures.clear();
+    }
+    if (mPendingGlyphs.empty() && mGLReady) return;
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (PendingGlyph& pending : mPendingGlyphs) {
+        unsigned int texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, pending.width, pending.height, 0, GL_RED, GL_UNSIGNED_BYTE,
+                     pending.pixels.empty() ? nullptr : pending.pixels.data());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        Characters[pending.c].TextureID = texture;
+    }
+    mPendingGlyphs.clear();
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    if (!mGLReady) {
+        mGLReady = true;
+        VAO_Text.Bind();
+        VBO_Text.Bind();
+        glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 18 * 9, NULL, GL_DYNAMIC_DRAW);
+        //VAO_Text.LinkAttrib(VBO_Text, 0, 4, GL_FLOAT, 4 * sizeof(float), 0);
+        VAO_Text.LinkAttrib(VBO_Text, 0, 3, GL_FLOAT, 9 * sizeof(float), (void*)0);
+        VAO_Text.LinkAttrib(VBO_Text, 1, 2, GL_FLOAT, 9 * sizeof(float), (void*)(3 * sizeof(float)));
+        VAO_Text.LinkAttrib(VBO_Text, 2, 4, GL_FLOAT, 9 * sizeof(float), (void*)(5 * sizeof(float)));
+        VBO_Text.Unbind();
+        VAO_Text.Unbind();
+    }
+}
+
+
+// Locked, since Load lets the next EnsureLoaded refill the table while other threads lay out
+// or submit text. Returned by value for the same reason.
+Character Text::Glyph(wchar_t c) const
+{
+    std::lock_guard<std::mutex> lock(mLoadMutex);
+    auto it = Characters.find(static_cast<char>(c));
+    return it != Characters.end() ? it->second : Character{ 0, glm::ivec2(0), glm::ivec2(0), 0 };
+}
+
+
+void Text::LoadGlyphs()
+{
+    StartupTrace::ScopedPhase phase("fonts");
+    const std::string& font = mFontFile;
+    for (auto& entry : Characters) {
+        if (entry.second.TextureID != 0) mStaleTextures.push_back(entry.second.TextureID);
+    }
     Characters.clear();
+    mPendingGlyphs.clear();
     FT_Library ft;    
     if (FT_Init_FreeType(&ft))
         std::cout << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
+    // The font data must outlive the face, which is released at the end of this function.
+    Resource fontData = Resources::Load(font);
     FT_Face face;
-    if (FT_New_Face(ft, font.c_str(), 0, &face))
+    if (!fontData || FT_New_Memory_Face(ft, fontData.Data(), static_cast<FT_Long>(fontData.Size()), 0, &face))
         std::cout << "ERROR::FREETYPE: Failed to load font" << std::endl;
     FT_Set_Pixel_Sizes(face, 0, mFontSize);
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); 
 
     for (GLubyte c = 0; c < 128; c++)
     {
@@ -33,56 +114,39 @@ void Text::Load(std::string font, unsigned int fontSize)
             std::cout << (int)c << " ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
             continue;
         }
-        unsigned int texture;
-        glGenTextures(1, &texture);
-        glBindTexture(GL_TEXTURE_2D, texture);
-        glTexImage2D(
-            GL_TEXTURE_2D,
-            0,
-            GL_RED,
-            face->glyph->bitmap.width,
-            face->glyph->bitmap.rows,
-            0,
-            GL_RED,
-            GL_UNSIGNED_BYTE,
-            face->glyph->bitmap.buffer
-            );
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        // Copied row by row, since FreeType may pad rows (pitch) where GL expects them packed.
+        const FT_Bitmap& bitmap = face->glyph->bitmap;
+        PendingGlyph pending;
+        pending.c = static_cast<char>(c);
+        pending.width = static_cast<int>(bitmap.width);
+        pending.height = static_cast<int>(bitmap.rows);
+        pending.pixels.resize(static_cast<std::size_t>(bitmap.width) * bitmap.rows);
+        for (unsigned int row = 0; row < bitmap.rows; row++) {
+            std::copy_n(bitmap.buffer + row * bitmap.pitch, bitmap.width, pending.pixels.data() + row * bitmap.width);
+        }
+        mPendingGlyphs.push_back(std::move(pending));
 
         Character character = {
-            texture,
+            0,  // Uploaded on the GL thread.
             glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
             glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
             static_cast<unsigned int>(face->glyph->advance.x)
         };
         Characters.insert(std::pair<char, Character>(c, character));
     }
-    glBindTexture(GL_TEXTURE_2D, 0);
 
     FT_Done_Face(face);
     FT_Done_FreeType(ft);
-
-    VAO_Text.Bind();
-    VBO_Text.Bind();
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 18 * 9, NULL, GL_DYNAMIC_DRAW);
-    //VAO_Text.LinkAttrib(VBO_Text, 0, 4, GL_FLOAT, 4 * sizeof(float), 0);
-    VAO_Text.LinkAttrib(VBO_Text, 0, 3, GL_FLOAT, 9 * sizeof(float), (void*)0);
-	VAO_Text.LinkAttrib(VBO_Text, 1, 2, GL_FLOAT, 9 * sizeof(float), (void*)(3 * sizeof(float)));
-	VAO_Text.LinkAttrib(VBO_Text, 2, 4, GL_FLOAT, 9 * sizeof(float), (void*)(5 * sizeof(float)));
-    VBO_Text.Unbind();
-    VAO_Text.Unbind();
 }
 
 // TODO: Does not take into account text scale
 glm::ivec2 Text::boundingBox(std::wstring text){
+    EnsureLoaded();
     glm::ivec2 box = {1, 10};
     std::wstring::const_iterator c;
     for (c = text.begin(); c != text.end(); c++) 
     {
-        Character ch = Characters[*c];
+        const Character& ch = Glyph(*c);
         box.x += ch.Advance >> 6;
         //if(ch.Size.y > box.y) box.y = ch.Size.y;
     }
@@ -90,9 +154,10 @@ glm::ivec2 Text::boundingBox(std::wstring text){
 }
 
 int Text::getTextWidth(const std::wstring& text) {
+    EnsureLoaded();
     int textWidth = 0;
     for (std::wstring::const_iterator c = text.begin(); c != text.end(); ++c) {
-        Character ch = Characters[*c];
+        const Character& ch = Glyph(*c);
         textWidth += (ch.Advance >> 6); // Bitshift by 6 to convert from 1/64th pixels
     }
     return textWidth;
@@ -128,7 +193,7 @@ void Text::truncateText(std::wstring& text, int maxWidth) {
         int currentWidth = firstLetterWidth;
 
         for (size_t i = 1; i < text.size(); ++i) {
-            Character ch = Characters[text[i]];
+            const Character& ch = Glyph(text[i]);
             int charWidth = ch.Advance >> 6;
 
             if (currentWidth + charWidth + ellipsisWidth > maxWidth) {
@@ -151,7 +216,7 @@ void Text::truncateText(std::wstring& text, int maxWidth) {
     int currentWidth = 0;
 
     for (size_t i = 0; i < text.size(); ++i) {
-        Character ch = Characters[text[i]];
+        const Character& ch = Glyph(text[i]);
         int charWidth = ch.Advance >> 6;
 
         if (currentWidth + charWidth > maxWidth) {
@@ -166,6 +231,7 @@ void Text::truncateText(std::wstring& text, int maxWidth) {
 }
 
 float Text::getTextHeight(const std::wstring& text, int containerWidth) {
+    EnsureLoaded();
     float lineWidth = 0;
     int lineCount = 1;
 
@@ -176,7 +242,7 @@ float Text::getTextHeight(const std::wstring& text, int containerWidth) {
             lineWidth = 0;
             continue;
         }
-        float charWidth = Characters[c].Advance >> 6;
+        float charWidth = Glyph(c).Advance >> 6;
 
         if (lineWidth + charWidth > containerWidth) {
             lineCount++;
@@ -190,9 +256,10 @@ float Text::getTextHeight(const std::wstring& text, int containerWidth) {
 // TODO: CHECK THAT CHANGING THE FONT SIZE AFFECTS HOW MUCH IS TRUNCATED!!!!
 float Text::RenderText(std::wstring text, Boundary textContainer, float z, Align align, Colour color, bool truncate, bool selectable, int selectionStart, int selectionEnd, int caretPos)
 {
-    if (!lines.empty()) {
-        lines.clear();
-    }
+    EnsureLoaded();
+
+    // Local so that widgets on several threads can share one Text (see DrawList).
+    std::vector<std::wstring> lines;
 
     if (truncate) {
         truncateText(text, textContainer.width);
@@ -217,7 +284,7 @@ float Text::RenderText(std::wstring text, Boundary textContainer, float z, Align
                 continue;
             }
 
-            Character ch = Characters[c];
+            const Character& ch = Glyph(c);
             float charWidth = ch.Advance >> 6; // Advance in pixels
 
             if (lineWidth + charWidth > textContainer.width && !currentLine.empty())
@@ -243,17 +310,13 @@ float Text::RenderText(std::wstring text, Boundary textContainer, float z, Align
 
 
     float textHeight = lines.size() * mFontSize;
-    
-    int wWidth = 0;
-    int wHeight = 0;
-    glfwGetFramebufferSize(G_WINDOW, &wWidth, &wHeight);
-    // Activate the corresponding render state
-    glm::mat4 projection = glm::ortho(0.0f, static_cast<float>(wWidth), static_cast<float>(wHeight), 0.0f, -1.0f, 1.0f);
-    TextShader.Bind();
-    glUniformMatrix4fv(glGetUniformLocation(TextShader.ID, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-    glUniform3f(glGetUniformLocation(TextShader.ID, "textColor"), color.r, color.g, color.b);
-    glActiveTexture(GL_TEXTURE0);
-    VAO_Text.Bind();
+
+    DrawList::GlyphRun run;
+    run.font = weak_from_this().lock();
+    if (!run.font) {
+        run.font = std::shared_ptr<Text>(std::shared_ptr<Text>(), this);   // Not kept alive; see DrawList::MustWait.
+    }
+    run.colour = glm::vec3(color.r, color.g, color.b);
 
     float yOffset = textContainer.y + mFontSize - 1;
     if (align & BOTTOM) {
@@ -289,11 +352,10 @@ float Text::RenderText(std::wstring text, Boundary textContainer, float z, Align
         for (size_t i = 0; i < line.size(); ++i, ++globalCharIndex)
         {
             wchar_t c = line[i];
-            Character ch = Characters[c];
+            const Character& ch = Glyph(c);
 
             float xpos = xOffset + ch.Bearing.x;
             float ypos = yOffset + (ch.Size.y - ch.Bearing.y);
-            float yposEnd = (wHeight - yOffset);
 
             float w = ch.Size.x;
             float h = ch.Size.y;
@@ -344,22 +406,53 @@ float Text::RenderText(std::wstring text, Boundary textContainer, float z, Align
 
             };
 
-            glBindTexture(GL_TEXTURE_2D, ch.TextureID);
-            VBO_Text.Bind();
-            glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-            VBO_Text.Unbind();
-            glDrawArrays(GL_TRIANGLES, 0, 18);
+            run.glyphs.push_back(static_cast<char>(c));
+            run.verts.insert(run.verts.end(), &vertices[0][0], &vertices[0][0] + 18 * 9);
 
             xOffset += wOffset; // Advance cursor for the next glyph
         }
         yOffset += mFontSize; // Move to the next line
     }
 
+    if (DrawList* list = DrawList::Current()) {
+        list->AddGlyphs(std::move(run));
+    } else {
+        SubmitGlyphs(run);
+    }
+
+    return textHeight;
+}
+
+
+void Text::SubmitGlyphs(const DrawList::GlyphRun& run)
+{
+    EnsureUploaded();
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    int wWidth = 0;
+    int wHeight = 0;
+    DrawList::GetTargetSize(wWidth, wHeight);
+    // Activate the corresponding render state
+    glm::mat4 projection = glm::ortho(0.0f, static_cast<float>(wWidth), static_cast<float>(wHeight), 0.0f, -1.0f, 1.0f);
+    TextShader.Bind();
+    glUniformMatrix4fv(glGetUniformLocation(TextShader.ID, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    glUniform3f(glGetUniformLocation(TextShader.ID, "textColor"), run.colour.r, run.colour.g, run.colour.b);
+    glActiveTexture(GL_TEXTURE0);
+    VAO_Text.Bind();
+
+    const std::size_t glyphFloats = 18 * 9;
+    for (std::size_t i = 0; i < run.glyphs.size(); ++i) {
+        glBindTexture(GL_TEXTURE_2D, Glyph(run.glyphs[i]).TextureID);
+        VBO_Text.Bind();
+        glBufferSubData(GL_ARRAY_BUFFER, 0, glyphFloats * sizeof(float), run.verts.data() + i * glyphFloats);
+        VBO_Text.Unbind();
+        glDrawArrays(GL_TRIANGLES, 0, 18);
+    }
+
     VAO_Text.Unbind();
     glBindTexture(GL_TEXTURE_2D, 0);
     TextShader.Unbind();
-
-    return textHeight;
 }
 
 
@@ -4,12 +4,43 @@
 
 #define STB_IMAGE_RESIZE_IMPLEMENTATION
 #include "ui_library/Texture.h"
+#include "ui_library/Resources.h"
+#include "ui_library/StartupTrace.h"
+#include "ui_library/RenderThread.h"
 
+// Decoding starts straight away on the job system; GL objects are created on first draw.
 Texture2D::Texture2D(GLenum internalFormat, GLenum imageFormat, const std::filesystem::path& file, glm::vec2 boundingBox)
     : width(0), height(0), wrapS(GL_REPEAT), wrapT(GL_REPEAT),
       filterMin(GL_LINEAR), filterMax(GL_LINEAR), 
       internalFormat(internalFormat), imageFormat(imageFormat), ID(0) {
 
+    // load shaders
+    spriteShader.Set((std::string(UI_LIBRARY_RESOURCES_DIR) + "/shaders/Sprite.vert").c_str(), (std::string(UI_LIBRARY_RESOURCES_DIR) + "/shaders/Sprite.frag").c_str());//, nullptr, "sprite");
+
+    loadTextureFromFileAsync(file, boundingBox);
+}
+
+
+Texture2D::~Texture2D() {
+    if (JobSystem* jobs = JobSystem::Current()) {
+        jobs->Wait(loadJob);
+    }
+    {
+        // Free any decoded image that was never uploaded.
+        std::lock_guard<std::mutex> lock(queueMutex);
+        while (!textureQueue.empty()) {
+            delete[] std::get<0>(textureQueue.front());
+            textureQueue.pop();
+        }
+    }
+    if (this->ID != 0) {
+        GLuint id = this->ID;
+        RenderThread::RunOnGLThread([id] { glDeleteTextures(1, &id); });
+    }
+}
+
+
+void Texture2D::InitGL() {
     std::vector<GLfloat> vertices = { 
         // pos      // tex
         0.0f, 1.0f, 0.0f, 1.0f,
@@ -25,14 +56,10 @@ Texture2D::Texture2D(GLenum internalFormat, GLenum imageFormat, const std::files
     VAO1.Bind();
     VAO1.LinkAttrib(VBO1, 0, 4, GL_FLOAT, 4 * sizeof(float), (void*)0);
     VAO1.Unbind();
-    // load shaders
-    spriteShader.Set((std::string(UI_LIBRARY_RESOURCES_DIR) + "/shaders/Sprite.vert").c_str(), (std::string(UI_LIBRARY_RESOURCES_DIR) + "/shaders/Sprite.frag").c_str());//, nullptr, "sprite");
     // configure shaders
     spriteShader.Bind().SetInteger("image", 0);
-
-    loadTextureFromFileAsync(file, boundingBox);
-
     spriteShader.Unbind();
+    glReady = true;
 }
 
 
@@ -75,7 +102,8 @@ void Texture2D::Unbind() const
 
 // Helper function to load image
 unsigned char* loadImage(const std::string& filePath, int& originalWidth, int& originalHeight, int& channels) {
-    unsigned char* imageData = stbi_load(filePath.c_str(), &originalWidth, &originalHeight, &channels, 4); // Force 4 channels (RGBA)
+    Resource file = Resources::Load(filePath);
+    unsigned char* imageData = file ? stbi_load_from_memory(file.Data(), static_cast<int>(file.Size()), &originalWidth, &originalHeight, &channels, 4) : nullptr; // Force 4 channels (RGBA)
     if (!imageData) {
         std::cerr << "Could not open or find the image: " << filePath << std::endl;
         return nullptr;
@@ -139,7 +167,12 @@ unsigned char* resizeImage(unsigned char* imageData, int originalWidth, int orig
 // Refactored loadTextureFromFile (Async with callback)
 // Load texture asynchronously and pass the result to the main thread queue
 void Texture2D::loadTextureFromFileAsync(const std::filesystem::path& file, glm::vec2 boundingBox) {
-    std::thread([this, file, boundingBox]() {  // Capture self
+    JobSystem* jobs = JobSystem::Current();
+    if (jobs) {
+        jobs->Wait(loadJob);
+    }
+    auto decode = [this, file, boundingBox]() {  // Capture self, waited for in the destructor
+        StartupTrace::ScopedPhase phase("textures");
         // Load and resize the image as before...
         std::string filePath = file.string();
         int originalWidth, originalHeight, channels;
@@ -164,10 +197,18 @@ void Texture2D::loadTextureFromFileAsync(const std::filesystem::path& file, glm:
             // Debug: log mutex address or status if possible
             std::lock_guard<std::mutex> lock(queueMutex);
             textureQueue.push(std::make_tuple(thumbnailData, constrainedBox));  // Help me debug an ERROR HERE
+            mContentVersion.fetch_add(1, std::memory_order_release);
         }
 
         queueCondVar.notify_one();  // Notify the main thread to process the queue
-    }).join();  // TODO: Figure out a way to make this be .detach(); but that dosn't crash the program
+        UI::PostInvalidate();       // Wake the event loop so the image appears without other input
+    };
+
+    if (jobs) {
+        loadJob = jobs->Schedule(decode);
+    } else {
+        decode();  // No Application (and so no job system) yet.
+    }
 }
 
 
@@ -190,6 +231,7 @@ void Texture2D::processTextureQueue() {
         // Generate the texture on the main thread
         Create(constrainedBox.x, constrainedBox.y, thumbnailData);
         mFitSize = constrainedBox;
+        mContentVersion.fetch_add(1, std::memory_order_release);
 
         // Cleanup
         delete[] thumbnailData;
@@ -201,7 +243,21 @@ void Texture2D::processTextureQueue() {
 
 void Texture2D::DrawSprite(glm::vec2 position, glm::vec2 desiredSize, float z, float rotate, glm::vec3 color)
 {
+    if (DrawList* list = DrawList::Current()) {
+        std::shared_ptr<Texture2D> self = weak_from_this().lock();
+        if (!self) {
+            self = std::shared_ptr<Texture2D>(std::shared_ptr<Texture2D>(), this);   // Not kept alive; see DrawList::MustWait.
+        }
+        list->AddSprite({ self, position, desiredSize, z, rotate, color });
+        return;
+    }
+    if (!glReady) {
+        InitGL();
+    }
     processTextureQueue();
+    if (this->ID == 0) {
+        return;  // Still decoding.
+    }
 
     mDesiredSize = desiredSize;
 
@@ -209,7 +265,7 @@ void Texture2D::DrawSprite(glm::vec2 position, glm::vec2 desiredSize, float z, f
     spriteShader.Bind();
     int wWidth = 0;
     int wHeight = 0;
-    glfwGetFramebufferSize(G_WINDOW, &wWidth, &wHeight);
+    DrawList::GetTargetSize(wWidth, wHeight);
     glm::mat4 projection = glm::ortho(0.0f, static_cast<float>(wWidth), static_cast<float>(wHeight), 0.0f, -1.0f, 1.0f);
     spriteShader.SetMatrix4("projection", projection);
 
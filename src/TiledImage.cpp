@@ -0,0 +1,582 @@
+// Copyright (c) 2025 Thomas Groom
+
+
+#include "ui_library/TiledImage.h"
+#include "ui_library/RenderThread.h"
+
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <ui_library/stb_image.h>
+
+
+TiledImage::TiledImage(UI* _ui, const std::filesystem::path& file, const std::filesystem::path& cacheDir,
+                       int tileSize, int atlasSlotsPerRow)
+    : mUI(_ui), mFile(file), mCacheDir(cacheDir), mTileSize(std::max(tileSize, 16)),
+      mMinSlotsPerRow(std::max(atlasSlotsPerRow, 2)) {
+
+    SetMouseEvents(MouseEvent::SCROLL | MouseEvent::PRESS);
+
+    // GL resources are created on first draw; only the pyramid worker starts here.
+    mShader.Set((std::string(UI_LIBRARY_RESOURCES_DIR) + "/shaders/Atlas.vert").c_str(), (std::string(UI_LIBRARY_RESOURCES_DIR) + "/shaders/Atlas.frag").c_str());
+
+    mWorker = std::thread(&TiledImage::WorkerMain, this);
+}
+
+
+TiledImage::~TiledImage() {
+    {
+        std::lock_guard<std::mutex> lock(mQueueMutex);
+        mStop = true;
+    }
+    mQueueCondVar.notify_all();
+    if (mWorker.joinable()) {
+        mWorker.join();
+    }
+    if (mAtlasID != 0) {
+        GLuint id = mAtlasID;
+        RenderThread::RunOnGLThread([id] { glDeleteTextures(1, &id); });
+    }
+}
+
+
+// ---------------------------------------------------------------------------
+// Worker thread: pyramid construction and tile fetching
+// ---------------------------------------------------------------------------
+void TiledImage::WorkerMain() {
+    if (!LoadManifest() && !BuildPyramid()) {
+        mFailed.store(true, std::memory_order_release);
+        return;
+    }
+    mReady.store(true, std::memory_order_release);
+    UI::PostInvalidate();
+
+    while (true) {
+        TileKey key;
+        {
+            std::unique_lock<std::mutex> lock(mQueueMutex);
+            mQueueCondVar.wait(lock, [this]() { return mStop || !mRequests.empty(); });
+            if (mStop) return;
+            // Most recent requests are at the back and are the most likely to still be visible.
+            key = mRequests.back();
+            mRequests.pop_back();
+        }
+
+        TileData tile;
+        if (!FetchTile(key, tile)) {
+            tile = { key, 0, 0, {} };  // Still reported so the GL thread can clear the request.
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mQueueMutex);
+            mLoaded.push_back(std::move(tile));
+        }
+        UI::PostInvalidate();
+    }
+}
+
+
+// Reuses a pyramid written to the cache directory by a previous run, without decoding the source.
+// The directory is keyed by the file's absolute path, size and modification time, so neither
+// an image edited in place nor another file of the same name and size reuses its tiles.
+bool TiledImage::LoadManifest() {
+    if (mCacheDir.empty()) return false;
+
+    std::error_code ec;
+    auto fileSize = std::filesystem::file_size(mFile, ec);
+    if (ec) return false;
+    auto modified = std::filesystem::last_write_time(mFile, ec);
+    if (ec) return false;
+    std::filesystem::path absolute = std::filesystem::absolute(mFile, ec);
+    if (ec) return false;
+    std::size_t pathHash = std::hash<std::string>()(absolute.lexically_normal().string());
+    mTileDir = mCacheDir / (mFile.stem().string() + "_" + std::to_string(pathHash) + "_" + std::to_string(fileSize) + "_" +
+                            std::to_string(modified.time_since_epoch().count()) + "_" + std::to_string(mTileSize));
+
+    std::ifstream manifest(mTileDir / "pyramid.txt");
+    if (!manifest) return false;
+    int width = 0, height = 0, levels = 0;
+    if (!(manifest >> width >> height >> levels) || width <= 0 || height <= 0 || levels <= 0) {
+        return false;
+    }
+    mImageWidth = width;
+    mImageHeight = height;
+    mLevels = levels;
+    return true;
+}
+
+
+bool TiledImage::BuildPyramid() {
+    int width, height, channels;
+    unsigned char* data = stbi_load(mFile.string().c_str(), &width, &height, &channels, 4);  // Force 4 channels (RGBA)
+    if (!data) {
+        std::cerr << "Could not open or find the image: " << mFile.string() << std::endl;
+        return false;
+    }
+
+    mImageWidth = width;
+    mImageHeight = height;
+    mLevels = 1;
+    while (((std::max(width, height) - 1) >> (mLevels - 1)) >= mTileSize) {
+        mLevels++;
+    }
+
+    if (!mCacheDir.empty()) {
+        std::error_code ec;
+        std::filesystem::create_directories(mTileDir, ec);
+        if (ec) {
+            std::cerr << "Could not create tile cache directory: " << mTileDir.string() << std::endl;
+            mTileDir.clear();
+        }
+    }
+
+    std::vector<unsigned char> level(data, data + static_cast<size_t>(width) * height * 4);
+    stbi_image_free(data);
+
+    int lw = width;
+    int lh = height;
+    for (int l = 0; l < mLevels; l++) {
+        // Cut the current level into tiles.
+        for (int ty = 0; ty * mTileSize < lh; ty++) {
+            for (int tx = 0; tx * mTileSize < lw; tx++) {
+                int tw = std::min(mTileSize, lw - tx * mTileSize);
+                int th = std::min(mTileSize, lh - ty * mTileSize);
+                std::vector<unsigned char> tile(static_cast<size_t>(tw) * th * 4);
+                for (int row = 0; row < th; row++) {
+                    const unsigned char* src = &level[(static_cast<size_t>(ty * mTileSize + row) * lw + tx * mTileSize) * 4];
+                    std::copy(src, src + tw * 4, &tile[static_cast<size_t>(row) * tw * 4]);
+                }
+                StoreTile(l, tx, ty, std::move(tile));
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mQueueMutex);
+            if (mStop) return false;
+        }
+
+        // 2x2 box filter down to the next level.
+        if (l + 1 < mLevels) {
+            int nw = (lw + 1) / 2;
+            int nh = (lh + 1) / 2;
+            std::vector<unsigned char> next(static_cast<size_t>(nw) * nh * 4);
+            for (int y = 0; y < nh; y++) {
+                int y0 = 2 * y;
+                int y1 = std::min(2 * y + 1, lh - 1);
+                for (int x = 0; x < nw; x++) {
+                    int x0 = 2 * x;
+                    int x1 = std::min(2 * x + 1, lw - 1);
+                    for (int c = 0; c < 4; c++) {
+                        int sum = level[(static_cast<size_t>(y0) * lw + x0) * 4 + c] + level[(static_cast<size_t>(y0) * lw + x1) * 4 + c]
+                                + level[(static_cast<size_t>(y1) * lw + x0) * 4 + c] + level[(static_cast<size_t>(y1) * lw + x1) * 4 + c];
+                        next[(static_cast<size_t>(y) * nw + x) * 4 + c] = static_cast<unsigned char>((sum + 2) / 4);
+                    }
+                }
+            }
+            level.swap(next);
+            lw = nw;
+            lh = nh;
+        }
+    }
+
+    // The manifest is written last so an interrupted build is never mistaken for a complete one.
+    if (!mTileDir.empty()) {
+        std::ofstream manifest(mTileDir / "pyramid.txt");
+        manifest << mImageWidth << " " << mImageHeight << " " << mLevels << "\n";
+    }
+    return true;
+}
+
+
+void TiledImage::StoreTile(int level, int tx, int ty, std::vector<unsigned char>&& pixels) {
+    TileKey key = MakeKey(level, tx, ty);
+    if (!mTileDir.empty()) {
+        std::ofstream out(TilePath(key), std::ios::binary);
+        if (out) {
+            out.write(reinterpret_cast<const char*>(pixels.data()), static_cast<std::streamsize>(pixels.size()));
+            return;
+        }
+        std::cerr << "Could not write tile to cache, keeping it in memory" << std::endl;
+    }
+    mMemoryTiles[key] = std::move(pixels);
+}
+
+
+bool TiledImage::FetchTile(TileKey key, TileData& out) {
+    out.key = key;
+    out.width = TileWidth(key);
+    out.height = TileHeight(key);
+    size_t bytes = static_cast<size_t>(out.width) * out.height * 4;
+
+    auto it = mMemoryTiles.find(key);
+    if (it != mMemoryTiles.end()) {
+        out.pixels = it->second;
+        return true;
+    }
+
+    if (mTileDir.empty()) return false;
+    std::ifstream in(TilePath(key), std::ios::binary);
+    if (!in) return false;
+    out.pixels.resize(bytes);
+    in.read(reinterpret_cast<char*>(out.pixels.data()), static_cast<std::streamsize>(bytes));
+    return static_cast<size_t>(in.gcount()) == bytes;
+}
+
+
+std::filesystem::path TiledImage::TilePath(TileKey key) const {
+    return mTileDir / (std::to_string(KeyLevel(key)) + "_" + std::to_string(KeyX(key)) + "_" + std::to_string(KeyY(key)) + ".tile");
+}
+
+
+int TiledImage::TileWidth(TileKey key) const {
+    return std::min(mTileSize, LevelWidth(KeyLevel(key)) - KeyX(key) * mTileSize);
+}
+
+
+int TiledImage::TileHeight(TileKey key) const {
+    return std::min(mTileSize, LevelHeight(KeyLevel(key)) - KeyY(key) * mTileSize);
+}
+
+
+// ---------------------------------------------------------------------------
+// GL thread: atlas residency
+// ---------------------------------------------------------------------------
+// Most tiles the view can show at once. A level is drawn at between half and full size, so a
+// tile spans at least half its size on screen, and a partial one can show at each edge.
+int TiledImage::MaxVisibleTiles(Boundary view) const {
+    int span = std::max(mTileSize / 2, 1);
+    return ((view.width + span - 1) / span + 1) * ((view.height + span - 1) / span + 1);
+}
+
+
+// Creates the atlas, or replaces it with a larger one (dropping every resident tile) when the
+// view has outgrown it.
+void TiledImage::CreateAtlas(Boundary view) {
+    const bool first = mAtlasID == 0;
+    if (first) {
+        GLint maxSize = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+        mMaxSlotsPerRow = maxSize > 0 ? std::max(maxSize / mTileSize, 2) : mMinSlotsPerRow;
+        mSlotCapacity.store(mMaxSlotsPerRow * mMaxSlotsPerRow, std::memory_order_relaxed);
+    }
+    // A third more than the view shows, for the coarser tiles drawn while finer ones stream in.
+    int needed = MaxVisibleTiles(view) * 4 / 3;
+    int slotsPerRow = std::max(mMinSlotsPerRow, static_cast<int>(std::ceil(std::sqrt(static_cast<double>(needed)))));
+    slotsPerRow = std::min(slotsPerRow, mMaxSlotsPerRow);
+    if (!first) {
+        if (slotsPerRow <= mSlotsPerRow) return;
+        glDeleteTextures(1, &mAtlasID);
+        mResident.clear();
+        mLru.clear();
+    }
+    mSlotsPerRow = slotsPerRow;
+    const int atlasSize = mSlotsPerRow * mTileSize;
+
+    glGenTextures(1, &mAtlasID);
+    glBindTexture(GL_TEXTURE_2D, mAtlasID);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, atlasSize, atlasSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    mFreeSlots.clear();
+    for (int slot = mSlotsPerRow * mSlotsPerRow - 1; slot >= 0; slot--) {
+        mFreeSlots.push_back(slot);
+    }
+
+    if (first) {
+        mVAO.Bind();
+        mVAO.LinkAttrib(mVBO, 0, 4, GL_FLOAT, 4 * sizeof(float), (void*)0);
+        mVAO.Unbind();
+    }
+}
+
+
+int TiledImage::AcquireSlot(const std::unordered_set<TileKey>& pinned) {
+    if (!mFreeSlots.empty()) {
+        int slot = mFreeSlots.back();
+        mFreeSlots.pop_back();
+        return slot;
+    }
+
+    // Evict the least recently used tile that is not needed this frame.
+    for (auto it = mLru.rbegin(); it != mLru.rend(); ++it) {
+        if (pinned.count(*it)) continue;
+        auto resident = mResident.find(*it);
+        int slot = resident->second.slot;
+        mLru.erase(resident->second.lruIt);
+        mResident.erase(resident);
+        return slot;
+    }
+    return -1;
+}
+
+
+void TiledImage::UploadReadyTiles() {
+    std::vector<TileData> ready;
+    {
+        std::lock_guard<std::mutex> lock(mQueueMutex);
+        while (!mLoaded.empty() && static_cast<int>(ready.size()) < mUploadsPerFrame) {
+            ready.push_back(std::move(mLoaded.front()));
+            mLoaded.pop_front();
+        }
+    }
+
+    if (ready.empty()) return;
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, mAtlasID);
+    for (TileData& tile : ready) {
+        mInFlight.erase(tile.key);
+        if (tile.width == 0) {
+            mFailedTiles.insert(tile.key);   // Drawn from a coarser level from now on.
+            continue;
+        }
+        if (mResident.count(tile.key)) continue;
+
+        int slot = AcquireSlot(mVisibleSet);
+        if (slot < 0) continue;  // Every slot holds a visible tile; it will be requested again.
+
+        int sx = (slot % mSlotsPerRow) * mTileSize;
+        int sy = (slot / mSlotsPerRow) * mTileSize;
+        glTexSubImage2D(GL_TEXTURE_2D, 0, sx, sy, tile.width, tile.height, GL_RGBA, GL_UNSIGNED_BYTE, tile.pixels.data());
+
+        mLru.push_front(tile.key);
+        mResident[tile.key] = { slot, mLru.begin() };
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // Draw the new tiles, and upload any left over.
+    mResidentGeneration.fetch_add(1, std::memory_order_relaxed);
+    UI::PostInvalidate();
+}
+
+
+// ---------------------------------------------------------------------------
+// View control
+// ---------------------------------------------------------------------------
+void TiledImage::FitToView() {
+    if (!IsReady() || mView.width <= 0 || mView.height <= 0) {
+        mFitPending = true;
+        return;
+    }
+    mZoom = std::min(static_cast<double>(mView.width) / mImageWidth, static_cast<double>(mView.height) / mImageHeight);
+    mOffset = glm::dvec2(mImageWidth * 0.5 - (mView.width * 0.5) / mZoom,
+                         mImageHeight * 0.5 - (mView.height * 0.5) / mZoom);
+    mFitPending = false;
+}
+
+
+void TiledImage::SetZoom(double zoom, glm::dvec2 screenAnchor) {
+    double minZoom = 0.5 * std::min(static_cast<double>(std::max(mView.width, 1)) / std::max(mImageWidth, 1),
+                                    static_cast<double>(std::max(mView.height, 1)) / std::max(mImageHeight, 1));
+    zoom = std::clamp(zoom, std::min(minZoom, 1.0), 64.0);
+
+    glm::dvec2 local = screenAnchor - glm::dvec2(mView.x, mView.y);
+    glm::dvec2 imagePoint = mOffset + local / mZoom;
+    mZoom = zoom;
+    mOffset = imagePoint - local / mZoom;
+}
+
+
+void TiledImage::OnMouseEvent(const MouseEvent& event) {
+    if (event.type == MouseEvent::SCROLL) {
+        SetZoom(mZoom * std::pow(1.2, mUI->G_SCROLL_Y), glm::dvec2(mUI->G_MOUSE_X, mUI->G_MOUSE_Y));
+    }
+    if (event.type == MouseEvent::PRESS && (event.button == GLFW_MOUSE_BUTTON_LEFT || event.button == GLFW_MOUSE_BUTTON_MIDDLE)) {
+        mPanning = true;
+    }
+}
+
+
+// ---------------------------------------------------------------------------
+// Drawing
+// ---------------------------------------------------------------------------
+void TiledImage::AddQuad(std::vector<GLfloat>& verts, float x0, float y0, float x1, float y1,
+                         float u0, float v0, float u1, float v1) {
+    const GLfloat quad[24] = {
+        x0, y1, u0, v1,
+        x1, y0, u1, v0,
+        x0, y0, u0, v0,
+
+        x0, y1, u0, v1,
+        x1, y1, u1, v1,
+        x1, y0, u1, v0
+    };
+    verts.insert(verts.end(), quad, quad + 24);
+}
+
+
+std::uint64_t TiledImage::ViewKey(Boundary container, float z) const {
+    DrawList::Hasher key;
+    key.Add(this).Add(container.x).Add(container.y).Add(container.width).Add(container.height).Add(z);
+    key.Add(IsReady()).Add(mOffset).Add(mZoom).Add(mResidentGeneration.load(std::memory_order_relaxed));
+    return key.Value();
+}
+
+
+// Works out the view here, on the thread that lays out and handles input. Only the tile
+// residency, uploads and the draw itself are deferred to the GL thread.
+void TiledImage::Draw(Boundary container, float z) {
+    mContainer = container;
+    mZ = z;
+    SetDrawn();
+    mView = container;
+
+    if (!IsReady() || mView.width <= 0 || mView.height <= 0) return;
+    if (mFitPending) FitToView();
+
+    // Panning.
+    if (mPanning) {
+        if (mUI->G_LEFT_MOUSE_DRAG || mUI->G_MIDDLE_MOUSE_DRAG) {
+            mOffset -= glm::dvec2(mUI->G_MOUSE_DRAG_DELTA.x, mUI->G_MOUSE_DRAG_DELTA.y) / mZoom;
+        }
+        if (mUI->G_LEFT_MOUSE_STATE == GLFW_RELEASE || mUI->G_MIDDLE_MOUSE_STATE == GLFW_RELEASE) {
+            mPanning = false;
+        }
+    }
+
+    // Keep at least half a view of the image on screen.
+    glm::dvec2 viewSize = glm::dvec2(mView.width, mView.height) / mZoom;
+    mOffset.x = std::clamp(mOffset.x, -viewSize.x * 0.5, mImageWidth - viewSize.x * 0.5);
+    mOffset.y = std::clamp(mOffset.y, -viewSize.y * 0.5, mImageHeight - viewSize.y * 0.5);
+
+    TileView view;
+    view.view = mView;
+    view.z = z;
+    view.offset = mOffset;
+    view.zoom = mZoom;
+    view.x0 = std::max(mOffset.x, 0.0);
+    view.y0 = std::max(mOffset.y, 0.0);
+    view.x1 = std::min(mOffset.x + viewSize.x, static_cast<double>(mImageWidth));
+    view.y1 = std::min(mOffset.y + viewSize.y, static_cast<double>(mImageHeight));
+    if (view.x1 <= view.x0 || view.y1 <= view.y0) return;
+
+    // Pick the pyramid level whose resolution is closest to (but not below) the screen
+    // resolution, or a coarser one if the atlas (at its size limit) cannot hold its tiles.
+    int level = static_cast<int>(std::floor(std::log2(1.0 / mZoom)));
+    level = std::clamp(level, 0, mLevels - 1);
+    const int capacity = mSlotCapacity.load(std::memory_order_relaxed);
+    while (capacity > 0 && level + 1 < mLevels) {
+        double span = mTileSize * static_cast<double>(1 << level);
+        double tiles = (std::ceil(view.x1 / span) - std::floor(view.x0 / span)) * (std::ceil(view.y1 / span) - std::floor(view.y0 / span));
+        if (tiles <= capacity) break;
+        level++;
+    }
+    view.level = level;
+
+    double tileSpan = mTileSize * static_cast<double>(1 << level);
+    int tx0 = static_cast<int>(view.x0 / tileSpan);
+    int ty0 = static_cast<int>(view.y0 / tileSpan);
+    int tx1 = static_cast<int>(std::ceil(view.x1 / tileSpan)) - 1;
+    int ty1 = static_cast<int>(std::ceil(view.y1 / tileSpan)) - 1;
+    for (int ty = ty0; ty <= ty1; ty++) {
+        for (int tx = tx0; tx <= tx1; tx++) {
+            view.visible.push_back(MakeKey(level, tx, ty));
+        }
+    }
+
+    DrawList::Rect bounds = { container.x, container.y, container.width, container.height };
+    DrawList::Defer([this, view] { DrawTiles(view); }, bounds, ViewKey(container, z));
+}
+
+
+void TiledImage::DrawTiles(const TileView& view) {
+    if (mAtlasID == 0 || MaxVisibleTiles(view.view) > mSlotsPerRow * mSlotsPerRow) CreateAtlas(view.view);
+
+    mVisibleSet.clear();
+    mVisibleSet.insert(view.visible.begin(), view.visible.end());
+
+    // Replace outstanding requests with the tiles that are missing now.
+    {
+        std::lock_guard<std::mutex> lock(mQueueMutex);
+        for (TileKey key : mRequests) mInFlight.erase(key);
+        mRequests.clear();
+        // Pushed back to front so the worker (which pops from the back) starts near the view's top-left.
+        for (auto it = view.visible.rbegin(); it != view.visible.rend(); ++it) {
+            if (mResident.count(*it) || mInFlight.count(*it) || mFailedTiles.count(*it)) continue;
+            mRequests.push_back(*it);
+            mInFlight.insert(*it);
+        }
+    }
+    mQueueCondVar.notify_one();
+
+    UploadReadyTiles();
+
+    // Build one quad per visible tile, falling back to a coarser resident ancestor while it streams in.
+    const int level = view.level;
+    const double tileSpan = mTileSize * static_cast<double>(1 << level);
+    const float atlasSize = static_cast<float>(mSlotsPerRow * mTileSize);
+    mVerts.clear();
+    for (TileKey key : view.visible) {
+        int tx = KeyX(key);
+        int ty = KeyY(key);
+
+        TileKey source = key;
+        int sourceLevel = level;
+        while (!mResident.count(source) && sourceLevel + 1 < mLevels) {
+            sourceLevel++;
+            int shift = sourceLevel - level;
+            source = MakeKey(sourceLevel, tx >> shift, ty >> shift);
+        }
+        auto resident = mResident.find(source);
+        if (resident == mResident.end()) continue;
+
+        mLru.splice(mLru.begin(), mLru, resident->second.lruIt);
+
+        // Tile rectangle in level 0 pixels, clipped to the visible region.
+        double rx0 = std::max(tx * tileSpan, view.x0);
+        double ry0 = std::max(ty * tileSpan, view.y0);
+        double rx1 = std::min((tx + 1) * tileSpan, view.x1);
+        double ry1 = std::min((ty + 1) * tileSpan, view.y1);
+        if (rx1 <= rx0 || ry1 <= ry0) continue;
+
+        // Same rectangle in the source tile's local pixels, inset by half a texel to avoid bleeding.
+        double sourceScale = static_cast<double>(1 << sourceLevel);
+        double ox = KeyX(source) * mTileSize;
+        double oy = KeyY(source) * mTileSize;
+        double sw = TileWidth(source);
+        double sh = TileHeight(source);
+        double lx0 = std::clamp(rx0 / sourceScale - ox, 0.5, sw - 0.5);
+        double ly0 = std::clamp(ry0 / sourceScale - oy, 0.5, sh - 0.5);
+        double lx1 = std::clamp(rx1 / sourceScale - ox, 0.5, sw - 0.5);
+        double ly1 = std::clamp(ry1 / sourceScale - oy, 0.5, sh - 0.5);
+
+        int slot = resident->second.slot;
+        float sx = static_cast<float>((slot % mSlotsPerRow) * mTileSize);
+        float sy = static_cast<float>((slot / mSlotsPerRow) * mTileSize);
+
+        AddQuad(mVerts,
+                static_cast<float>(view.view.x + (rx0 - view.offset.x) * view.zoom), static_cast<float>(view.view.y + (ry0 - view.offset.y) * view.zoom),
+                static_cast<float>(view.view.x + (rx1 - view.offset.x) * view.zoom), static_cast<float>(view.view.y + (ry1 - view.offset.y) * view.zoom),
+                (sx + static_cast<float>(lx0)) / atlasSize, (sy + static_cast<float>(ly0)) / atlasSize,
+                (sx + static_cast<float>(lx1)) / atlasSize, (sy + static_cast<float>(ly1)) / atlasSize);
+    }
+
+    if (mVerts.empty()) return;
+
+    int wWidth = 0;
+    int wHeight = 0;
+    DrawList::GetTargetSize(wWidth, wHeight);
+    glm::mat4 projection = glm::ortho(0.0f, static_cast<float>(wWidth), static_cast<float>(wHeight), 0.0f, -1.0f, 1.0f);
+    mShader.Bind();
+    mShader.SetInteger("image", 0);
+    mShader.SetMatrix4("projection", projection);
+    mShader.SetFloat("z", view.z);
+    mShader.SetVector4f("tint", 1.0f, 1.0f, 1.0f, 1.0f);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, mAtlasID);
+    mVAO.Bind();
+    mVBO.Data(mVerts);
+    glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(mVerts.size() / 4));
+    mVAO.Unbind();
+    mVBO.Unbind();
+    glBindTexture(GL_TEXTURE_2D, 0);
+    mShader.Unbind();
+}
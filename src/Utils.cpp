@@ -2,10 +2,32 @@
 
 
 #include "ui_library/Utils.h"
+#include "ui_library/PickBuffer.h"
+
+#include <atomic>
 
 GLFWwindow* G_WINDOW;   // TODO: Avoid global definition
 
-std::vector<MouseHandler*> MouseHandler::instances;
+SlotMap<MouseHandler*> MouseHandler::instances;
+WidgetStore MouseHandler::drawnStore;
+WidgetStore MouseHandler::previousStore;
+bool MouseHandler::sLayoutChanged = true;
+std::uint32_t MouseHandler::sFrame = 0;
+
+static std::atomic<bool> sInvalidatePosted{false};
+
+
+void UI::PostInvalidate() {
+    // Only the first post per frame needs to wake the loop.
+    if (!sInvalidatePosted.exchange(true)) {
+        glfwPostEmptyEvent();
+    }
+}
+
+
+bool UI::ConsumePostedInvalidate() {
+    return sInvalidatePosted.exchange(false);
+}
 
 
 // Helper functions to convert between std::wstring and UTF-8 std::string.
@@ -31,10 +53,23 @@ std::string WStringToString(const std::wstring& wstr) {
 }
 
 
+// No GL work happens here: the shader is shared and the buffers are created on first draw.
 Primitive::Primitive() {
-	// Generates Shader object using shaders defualt.vert and default.frag
-	shaderProgram.Set((std::string(UI_LIBRARY_RESOURCES_DIR) + "/shaders/Default.vert").c_str(), (std::string(UI_LIBRARY_RESOURCES_DIR) + "/shaders/Default.frag").c_str());
-	uMVPMatrixID = glGetUniformLocation(shaderProgram.ID, "uMVPMatrix");
+    SetMouseEvents(0);  // Only hit-tested for its bounds; owners react to the events.
+}
+
+
+// Every primitive uses the same program, released together with the last primitive that drew.
+std::shared_ptr<Shader> Primitive::AcquireShader() {
+	static std::weak_ptr<Shader> sShader;
+	std::shared_ptr<Shader> shader = sShader.lock();
+	if (!shader) {
+		// Generates Shader object using shaders defualt.vert and default.frag
+		shader = std::make_shared<Shader>();
+		shader->Set((std::string(UI_LIBRARY_RESOURCES_DIR) + "/shaders/Default.vert").c_str(), (std::string(UI_LIBRARY_RESOURCES_DIR) + "/shaders/Default.frag").c_str());
+		sShader = shader;
+	}
+	return shader;
 }
 
 // Rounded rectangle primitive
@@ -94,8 +129,15 @@ Primitive& Primitive::SetAlpha(float a){
 
 Primitive& Primitive::Draw() {
     if (isValid) {
-        isDrawn = true;
-        shaderProgram.Bind();
+        SetDrawn();
+        if (DrawList* list = DrawList::Current()) {
+            list->AddMesh({ target.verts, target.inds, IsPixelPick() ? PickId() : 0 });
+            return *this;
+        }
+        if (!shaderProgram) {
+            shaderProgram = AcquireShader();
+        }
+        shaderProgram->Bind();
         VAO1.Bind();
         VBO1.Data(target.verts);
         EBO1.Data(target.inds);
@@ -107,14 +149,25 @@ Primitive& Primitive::Draw() {
         // Update MVP matrix
         UpdateMVPMatrix();
         //glUniformMatrix4fv(uMVPMatrixID, 1, GL_FALSE, mMVPMatrix);
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram.ID, "uMVPMatrix"), 1, GL_FALSE, glm::value_ptr(mMVPMatrix));
+        if (uMVPMatrixID < 0) {
+            uMVPMatrixID = glGetUniformLocation(shaderProgram->ID, "uMVPMatrix");
+        }
+        glUniformMatrix4fv(uMVPMatrixID, 1, GL_FALSE, glm::value_ptr(mMVPMatrix));
 
         // Debug: Draw call
         GLsizei indexCount = static_cast<GLsizei>(target.inds.size());
         glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
 
+        // Same geometry again into the pick buffer, so rounded corners pick exactly.
+        PickBuffer& picker = PickBuffer::getInstance();
+        if (IsPixelPick() && picker.IsActive()) {
+            picker.BeginPick(PickId(), mMVPMatrix);
+            glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+            picker.EndPick();
+        }
+
         // Unbind buffers
-	    shaderProgram.Unbind();
+	    shaderProgram->Unbind();
         EBO1.Unbind();
         VBO1.Unbind();
         VAO1.Unbind();
@@ -124,6 +177,50 @@ Primitive& Primitive::Draw() {
 }
 
 
+void Primitive::SubmitMesh(const DrawList::Mesh& mesh) {
+    // One set of buffers for every recorded primitive, created on the first submission.
+    struct Batch {
+        VAO vao;
+        VBO vbo;
+        EBO ebo;
+        std::shared_ptr<Shader> shader = AcquireShader();
+        GLint mvpLocation = -1;
+    };
+    static Batch batch;
+
+    int wWidth = 0;
+    int wHeight = 0;
+    DrawList::GetTargetSize(wWidth, wHeight);
+    glm::mat4 mvp = glm::ortho(0.0f, static_cast<float>(wWidth), static_cast<float>(wHeight), 0.0f, -1.0f, 1.0f);
+
+    batch.shader->Bind();
+    if (batch.mvpLocation < 0) {
+        batch.mvpLocation = glGetUniformLocation(batch.shader->ID, "uMVPMatrix");
+    }
+    batch.vao.Bind();
+    batch.vbo.Data(mesh.verts);
+    batch.ebo.Data(mesh.inds);
+    batch.vao.LinkAttrib(batch.vbo, 0, 3, GL_FLOAT, 7 * sizeof(float), (void*)0);
+    batch.vao.LinkAttrib(batch.vbo, 1, 4, GL_FLOAT, 7 * sizeof(float), (void*)(3 * sizeof(float)));
+    glUniformMatrix4fv(batch.mvpLocation, 1, GL_FALSE, glm::value_ptr(mvp));
+
+    GLsizei indexCount = static_cast<GLsizei>(mesh.inds.size());
+    glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+
+    PickBuffer& picker = PickBuffer::getInstance();
+    if (mesh.pickId != 0 && picker.IsActive()) {
+        picker.BeginPick(mesh.pickId, mvp);
+        glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+        picker.EndPick();
+    }
+
+    batch.shader->Unbind();
+    batch.ebo.Unbind();
+    batch.vbo.Unbind();
+    batch.vao.Unbind();
+}
+
+
 // Circle or Arc primitive
 void Primitive::Arc(int x, int y, int r, float begin, float end, float step) {
 	for (float theta = begin; theta < end + (step * 0.5f); theta += step) {
@@ -164,7 +261,7 @@ void Primitive::CalcInds() {
 void Primitive::UpdateMVPMatrix() {
     int wWidth = 0;
     int wHeight = 0;
-    glfwGetFramebufferSize(G_WINDOW, &wWidth, &wHeight);
+    DrawList::GetTargetSize(wWidth, wHeight);
     float scaleWidth = 2.0f / static_cast<float>(wWidth);
     float scaleHeight = -2.0f / static_cast<float>(wHeight);
 
@@ -204,41 +301,180 @@ void addVertex(std::vector<GLfloat>& vertices,
 
 
 void MouseInputSingleton::grantMouseInput(UI* _ui) {
-    const auto& elements = MouseHandler::getInstances();
-    if (elements.empty()) return;
-
-    // Map each layer to the MouseHandler with the highest mZ in that layer.
-    std::unordered_map<int, MouseHandler*> highestInLayer;
-    for (auto* elem : elements) {
-        if (!elem->isDrawn) continue;
-        if (!isMouseInBounds(_ui, &elem->mContainer)) continue;
-
-        int currentLayer = elem->layer;
-        auto it = highestInLayer.find(currentLayer);
-        if (it == highestInLayer.end() || elem->mZ > it->second->mZ) {
-            highestInLayer[currentLayer] = elem;
+    const WidgetStore& store = MouseHandler::drawnStore;
+    const PickBuffer& picker = PickBuffer::getInstance();
+    std::uint32_t picked = picker.IsEnabled() && picker.HasResult() ? picker.PickedId() : 0;
+
+    // Nothing moved, nothing was pressed and the same widgets were drawn in the same places,
+    // so the hovered handlers are the same and there is nothing to deliver.
+    if (unchanged(_ui) && picked == lastPicked) {
+        resetMouseInput();
+        return;
+    }
+    bool moved = _ui->G_MOUSE_X != lastMouseX || _ui->G_MOUSE_Y != lastMouseY;
+    lastMouseX = _ui->G_MOUSE_X;
+    lastMouseY = _ui->G_MOUSE_Y;
+    lastPicked = picked;
+    int mouseX = static_cast<int>(_ui->G_MOUSE_X);
+    int mouseY = static_cast<int>(_ui->G_MOUSE_Y);
+
+    // Only the handlers drawn last frame are indexed, and only those in the cell under the
+    // cursor are tested. Everything up to the callbacks reads the store's columns. The grids
+    // are kept while every row matches the frame before's, so a frame where only the cursor
+    // moved costs just the queries.
+    hits.clear();
+    nearHits.clear();
+    if (store.Size() > 0) {
+        if (MouseHandler::sLayoutChanged || store.Size() != gridRows || _ui->G_WIDTH != gridWidth || _ui->G_HEIGHT != gridHeight) {
+            grid.Build(store, _ui->G_WIDTH, _ui->G_HEIGHT);
+            // Handlers that track nearness are indexed again with their bounds grown by the margin.
+            nearMargins.assign(store.Size(), 0);
+            for (std::uint32_t row = 0; row < store.Size(); row++) {
+                if (store.mFlags[row] & WidgetStore::NEAR) nearMargins[row] = store.mOwner[row]->GetNearMargin();
+            }
+            nearGrid.Build(store, _ui->G_WIDTH, _ui->G_HEIGHT, WidgetStore::NEAR, &nearMargins);
+            gridRows = store.Size();
+            gridWidth = _ui->G_WIDTH;
+            gridHeight = _ui->G_HEIGHT;
         }
+        grid.Query(store, mouseX, mouseY, hits);
+        nearGrid.Query(store, mouseX, mouseY, nearHits);
     }
 
-    selectedCallbacks.clear();
-    // For each layer, add the highest z element.
-    for (const auto& pair : highestInLayer) {
-        selectedCallbacks.push_back(pair.second);
+    // Pixel-pick handlers only count where the pick buffer saw them (one frame old).
+    if (picker.IsEnabled() && picker.HasResult()) {
+        hits.erase(std::remove_if(hits.begin(), hits.end(), [&](std::uint32_t row) {
+            return (store.mFlags[row] & WidgetStore::PIXEL_PICK) && store.mStateId[row] + 1 != picked;
+        }), hits.end());
     }
 
-    // Invoke callbacks for each selected element.
-    for (auto* handler : selectedCallbacks) {
-        if (handler)
+    // For each layer, keep the row with the highest z (earliest drawn on ties).
+    selectedRows.clear();
+    for (std::uint32_t row : hits) {
+        auto it = std::find_if(selectedRows.begin(), selectedRows.end(),
+            [&](std::uint32_t selected) { return store.mLayer[selected] == store.mLayer[row]; });
+        if (it == selectedRows.end()) {
+            selectedRows.push_back(row);
+        } else if (store.mZ[row] > store.mZ[*it]) {
+            *it = row;
+        }
+    }
+    std::sort(selectedRows.begin(), selectedRows.end(),
+        [&](std::uint32_t a, std::uint32_t b) { return store.mLayer[a] < store.mLayer[b]; });
+
+    nextHovered.clear();
+    for (std::uint32_t row : selectedRows) {
+        nextHovered.push_back(store.mOwner[row]->GetHandle());
+    }
+
+    // Near state for the handlers that track it: the cursor within their bounds grown by the margin.
+    nextNearby.clear();
+    for (std::uint32_t row : nearHits) {
+        nextNearby.push_back(store.mOwner[row]->GetHandle());
+    }
+
+    // Update the state flags before any event is delivered, so handlers see a consistent picture.
+    auto contains = [](const std::vector<MouseHandler::Handle>& handles, MouseHandler::Handle handle) {
+        return std::find(handles.begin(), handles.end(), handle) != handles.end();
+    };
+    for (auto handle : hovered) {
+        if (MouseHandler* handler = MouseHandler::Find(handle)) handler->mHovered = false;
+    }
+    for (auto handle : nearby) {
+        if (MouseHandler* handler = MouseHandler::Find(handle)) handler->mNear = false;
+    }
+    hoverEveryFrame = false;
+    for (auto handle : nextHovered) {
+        MouseHandler* handler = MouseHandler::Find(handle);
+        handler->mHovered = true;
+        hoverEveryFrame |= (handler->mMouseEvents & MouseEvent::HOVER) != 0;
+    }
+    for (auto handle : nextNearby) {
+        MouseHandler::Find(handle)->mNear = true;
+    }
+
+    // Leaves before enters. Handlers may destroy others from a callback, so each delivery
+    // looks its handler up again.
+    for (auto handle : hovered) {
+        if (!contains(nextHovered, handle)) dispatch(handle, MouseEvent::LEAVE);
+    }
+    for (auto handle : nearby) {
+        if (!contains(nextNearby, handle)) dispatch(handle, MouseEvent::NEAR_LEAVE);
+    }
+    for (auto handle : nextNearby) {
+        if (!contains(nearby, handle)) dispatch(handle, MouseEvent::NEAR_ENTER);
+    }
+    for (auto handle : nextHovered) {
+        if (!contains(hovered, handle)) dispatch(handle, MouseEvent::ENTER);
+    }
+
+    const std::pair<int, int> buttons[] = {
+        { GLFW_MOUSE_BUTTON_LEFT, _ui->G_LEFT_MOUSE_STATE },
+        { GLFW_MOUSE_BUTTON_MIDDLE, _ui->G_MIDDLE_MOUSE_STATE },
+        { GLFW_MOUSE_BUTTON_RIGHT, _ui->G_RIGHT_MOUSE_STATE },
+    };
+    for (const auto& [button, state] : buttons) {
+        if (state != GLFW_RELEASE) continue;
+        for (auto handle : held) {
+            if (MouseHandler* handler = MouseHandler::Find(handle)) handler->mHeld = false;
+        }
+        held.clear();
+    }
+    for (auto handle : nextHovered) {
+        if (moved) dispatch(handle, MouseEvent::MOVE);
+        for (const auto& [button, state] : buttons) {
+            if (state == GLFW_PRESS) {
+                if (MouseHandler* handler = MouseHandler::Find(handle); handler && !handler->mHeld) {
+                    handler->mHeld = true;
+                    held.push_back(handle);
+                }
+                dispatch(handle, MouseEvent::PRESS, button);
+            }
+            if (state == GLFW_RELEASE) dispatch(handle, MouseEvent::RELEASE, button);
+        }
+        if (_ui->G_SCROLL_TRIGGER) dispatch(handle, MouseEvent::SCROLL);
+        MouseHandler* handler = MouseHandler::Find(handle);
+        if (handler && (handler->mMouseEvents & MouseEvent::HOVER))
             handler->MouseCallback(_ui->G_LEFT_MOUSE_STATE);
     }
+
+    std::swap(hovered, nextHovered);
+    std::swap(nearby, nextNearby);
     resetMouseInput();
 }
 
-void MouseInputSingleton::resetMouseInput() {
-    for (auto* elem : MouseHandler::getInstances()) {
-        elem->isDrawn = false;
+
+void MouseInputSingleton::dispatch(MouseHandler::Handle handle, MouseEvent::Type type, int button) {
+    MouseHandler* handler = MouseHandler::Find(handle);
+    if (!handler) return;
+    if (type == MouseEvent::PRESS || type == MouseEvent::RELEASE || type == MouseEvent::SCROLL) {
+        handler->mInteractions++;
     }
-    selectedCallbacks.clear();
+    if (!(handler->mMouseEvents & type)) return;
+    MouseEvent event{ type, button };
+    handler->OnMouseEvent(event);
+}
+
+
+bool MouseInputSingleton::unchanged(UI* _ui) const {
+    if (hoverEveryFrame) return false;
+    if (_ui->G_MOUSE_X != lastMouseX || _ui->G_MOUSE_Y != lastMouseY) return false;
+    if (_ui->G_LEFT_MOUSE_STATE != -1 || _ui->G_MIDDLE_MOUSE_STATE != -1 || _ui->G_RIGHT_MOUSE_STATE != -1 || _ui->G_SCROLL_TRIGGER) return false;
+    // A hovered handler destroyed since, whose slot a new handler now reuses, leaves the layout
+    // unchanged but must still be replaced.
+    for (auto handle : hovered) {
+        if (!MouseHandler::Find(handle)) return false;
+    }
+    return !MouseHandler::sLayoutChanged && MouseHandler::drawnStore.Size() == MouseHandler::previousStore.Size();
+}
+
+void MouseInputSingleton::resetMouseInput() {
+    // Advancing the frame un-draws every handler at once. The rows are kept for the next
+    // grant to compare against.
+    MouseHandler::sFrame++;
+    std::swap(MouseHandler::previousStore, MouseHandler::drawnStore);
+    MouseHandler::drawnStore.Clear();
+    MouseHandler::sLayoutChanged = false;
 }
 
 
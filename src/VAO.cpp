@@ -3,16 +3,17 @@
 */
 
 #include "ui_library/VAO.h"
+#include "ui_library/RenderThread.h"
 
-// Constructor that generates a VAO ID
+// Constructor. The VAO ID is generated on first use so no GL work happens at construction
 VAO::VAO()
 {
-	glGenVertexArrays(1, &ID);
 }
 
 // Links a VBO to the VAO using a certain layout
 void VAO::LinkAttrib(VBO& VBO, GLuint layout, GLuint numComponents, GLenum type, GLsizeiptr stride, void* offset)
 {
+	Bind();
 	VBO.Bind();
 	glVertexAttribPointer(layout, numComponents, type, GL_FALSE, stride, offset);
 	glEnableVertexAttribArray(layout);
@@ -20,8 +21,10 @@ void VAO::LinkAttrib(VBO& VBO, GLuint layout, GLuint numComponents, GLenum type,
 }
 
 // Binds the VAO
-void VAO::Bind() const
+void VAO::Bind()
 {
+	if (ID == 0)
+		glGenVertexArrays(1, &ID);
 	glBindVertexArray(ID);
 }
 
@@ -30,3 +33,12 @@ void VAO::Unbind() const
 {
 	glBindVertexArray(0);
 }
+
+// Deletes the VAO, on the render thread if one owns the context
+VAO::~VAO()
+{
+	if (ID != 0) {
+		GLuint id = ID;
+		RenderThread::RunOnGLThread([id] { glDeleteVertexArrays(1, &id); });
+	}
+}
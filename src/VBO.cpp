@@ -3,30 +3,32 @@
 */
 
 #include "ui_library/VBO.h"
+#include "ui_library/RenderThread.h"
 
-// Constructor that generates a Vertex Buffer Object and links it to vertices
+// Constructor. The buffer name is generated on first use so no GL work happens at construction
 VBO::VBO()
 {
-	glGenBuffers(1, &ID);  // Creates the name (populates ID)
 }
 
 // Update existing buffer to avoid having to create a new one
 void VBO::SubData(const std::vector<GLfloat>& vertices)
 {
-    glBindBuffer(GL_ARRAY_BUFFER, ID);
+    Bind();
     glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(GLfloat), vertices.data());
 }
 
 // Make the buffer larger to accomodate new verticies
 void VBO::Data(const std::vector<GLfloat>& vertices)
 {
-    glBindBuffer(GL_ARRAY_BUFFER, ID);
+    Bind();
     glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STATIC_DRAW);
 }
 
 // Binds the VBO
 void VBO::Bind()
 {
+	if (ID == 0)
+		glGenBuffers(1, &ID);  // Creates the name (populates ID)
 	glBindBuffer(GL_ARRAY_BUFFER, ID);
 }
 
@@ -35,3 +37,12 @@ void VBO::Unbind()
 {
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
+
+// Deletes the VBO, on the render thread if one owns the context
+VBO::~VBO()
+{
+	if (ID != 0) {
+		GLuint id = ID;
+		RenderThread::RunOnGLThread([id] { glDeleteBuffers(1, &id); });
+	}
+}
@@ -0,0 +1,764 @@
+// Copyright (c) 2025 Thomas Groom
+
+
+#include "ui_library/VectorIcon.h"
+#include "ui_library/Resources.h"
+#include "ui_library/StartupTrace.h"
+#include "ui_library/RenderThread.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <glm/gtc/matrix_transform.hpp>
+
+
+// ---------------------------------------------------------------------------
+// SVG subset parsing
+// ---------------------------------------------------------------------------
+
+// Returns the value of attribute `name` inside the tag text, or an empty string.
+static std::string FindAttribute(const std::string& tag, const std::string& name) {
+    size_t pos = 0;
+    while ((pos = tag.find(name, pos)) != std::string::npos) {
+        bool startsWord = pos == 0 || std::isspace(static_cast<unsigned char>(tag[pos - 1]));
+        size_t eq = tag.find_first_not_of(" \t\r\n", pos + name.size());
+        if (startsWord && eq != std::string::npos && tag[eq] == '=') {
+            size_t quote = tag.find_first_of("\"'", eq);
+            if (quote == std::string::npos) return {};
+            size_t end = tag.find(tag[quote], quote + 1);
+            if (end == std::string::npos) return {};
+            return tag.substr(quote + 1, end - quote - 1);
+        }
+        pos += name.size();
+    }
+    return {};
+}
+
+
+static bool ParseColour(const std::string& value, glm::vec4& colour) {
+    if (value.empty() || value == "currentColor") return true;   // Keep the default (white, tinted at draw time).
+    if (value == "none") {
+        colour.a = 0.0f;
+        return true;
+    }
+    if (value[0] != '#' || (value.size() != 7 && value.size() != 4)) return false;
+
+    unsigned int rgb = static_cast<unsigned int>(std::strtoul(value.c_str() + 1, nullptr, 16));
+    if (value.size() == 4) {  // #rgb
+        colour = glm::vec4(((rgb >> 8) & 0xF) / 15.0f, ((rgb >> 4) & 0xF) / 15.0f, (rgb & 0xF) / 15.0f, 1.0f);
+    } else {
+        colour = glm::vec4(((rgb >> 16) & 0xFF) / 255.0f, ((rgb >> 8) & 0xFF) / 255.0f, (rgb & 0xFF) / 255.0f, 1.0f);
+    }
+    return true;
+}
+
+
+// Path data tokenizer. Numbers may be packed without separators ("1.1.89" is 1.1 and .89,
+// ".9-2" is .9 and -2), which strtof handles by stopping at the first invalid character.
+class PathDataReader {
+public:
+    explicit PathDataReader(const std::string& d) : mStr(d.c_str()) {}
+
+    void SkipSeparators() {
+        while (*mStr && (std::isspace(static_cast<unsigned char>(*mStr)) || *mStr == ',')) ++mStr;
+    }
+    bool AtEnd() { SkipSeparators(); return *mStr == '\0'; }
+    bool AtNumber() {
+        SkipSeparators();
+        return *mStr == '-' || *mStr == '+' || *mStr == '.' || std::isdigit(static_cast<unsigned char>(*mStr));
+    }
+    char Command() { SkipSeparators(); return *mStr ? *mStr++ : '\0'; }
+    bool Number(float& value) {
+        if (!AtNumber()) return false;
+        char* end = nullptr;
+        value = std::strtof(mStr, &end);
+        if (end == mStr) return false;
+        mStr = end;
+        return true;
+    }
+    bool Point(glm::vec2& p) { return Number(p.x) && Number(p.y); }
+
+private:
+    const char* mStr;
+};
+
+
+static bool ParsePathData(const std::string& d, VectorOutline::Path& path) {
+    using Op = VectorOutline::Op;
+    PathDataReader reader(d);
+    glm::vec2 current(0.0f), start(0.0f), lastControl(0.0f);
+    char command = '\0';
+    char previous = '\0';
+
+    while (!reader.AtEnd()) {
+        // A command letter may be omitted when it repeats; a repeated move is a line.
+        if (!reader.AtNumber()) {
+            command = reader.Command();
+        } else if (command == 'M') {
+            command = 'L';
+        } else if (command == 'm') {
+            command = 'l';
+        } else if (command == '\0' || command == 'Z' || command == 'z') {
+            return false;
+        }
+
+        bool relative = std::islower(static_cast<unsigned char>(command)) != 0;
+        glm::vec2 base = relative ? current : glm::vec2(0.0f);
+        glm::vec2 p1, p2, p3;
+        char upper = static_cast<char>(std::toupper(static_cast<unsigned char>(command)));
+
+        switch (upper) {
+        case 'M':
+            if (!reader.Point(p1)) return false;
+            current = start = base + p1;
+            path.ops.push_back(Op::Move);
+            path.points.push_back(current);
+            break;
+        case 'L':
+            if (!reader.Point(p1)) return false;
+            current = base + p1;
+            path.ops.push_back(Op::Line);
+            path.points.push_back(current);
+            break;
+        case 'H':
+            if (!reader.Number(p1.x)) return false;
+            current.x = relative ? current.x + p1.x : p1.x;
+            path.ops.push_back(Op::Line);
+            path.points.push_back(current);
+            break;
+        case 'V':
+            if (!reader.Number(p1.y)) return false;
+            current.y = relative ? current.y + p1.y : p1.y;
+            path.ops.push_back(Op::Line);
+            path.points.push_back(current);
+            break;
+        case 'C':
+        case 'S':
+            if (upper == 'C') {
+                if (!reader.Point(p1)) return false;
+                p1 += base;
+            } else {
+                // Reflection of the previous cubic's second control point.
+                bool chained = previous == 'C' || previous == 'S';
+                p1 = chained ? 2.0f * current - lastControl : current;
+            }
+            if (!reader.Point(p2) || !reader.Point(p3)) return false;
+            p2 += base;
+            p3 += base;
+            path.ops.push_back(Op::Cubic);
+            path.points.insert(path.points.end(), { p1, p2, p3 });
+            lastControl = p2;
+            current = p3;
+            break;
+        case 'Q':
+        case 'T':
+            if (upper == 'Q') {
+                if (!reader.Point(p1)) return false;
+                p1 += base;
+            } else {
+                bool chained = previous == 'Q' || previous == 'T';
+                p1 = chained ? 2.0f * current - lastControl : current;
+            }
+            if (!reader.Point(p2)) return false;
+            p2 += base;
+            path.ops.push_back(Op::Quad);
+            path.points.insert(path.points.end(), { p1, p2 });
+            lastControl = p1;
+            current = p2;
+            break;
+        case 'Z':
+            path.ops.push_back(Op::Close);
+            current = start;
+            break;
+        default:
+            std::cerr << "Unsupported SVG path command: " << command << std::endl;
+            return false;
+        }
+        previous = upper;
+    }
+    return true;
+}
+
+
+bool VectorOutline::ParseSvg(const std::string& svg, VectorOutline& out) {
+    out = VectorOutline();
+
+    size_t svgTag = svg.find("<svg");
+    if (svgTag == std::string::npos) return false;
+    std::string tag = svg.substr(svgTag, svg.find('>', svgTag) - svgTag);
+
+    std::string viewBox = FindAttribute(tag, "viewBox");
+    if (!viewBox.empty()) {
+        PathDataReader reader(viewBox);
+        glm::vec4& vb = out.viewBox;
+        if (!reader.Number(vb.x) || !reader.Number(vb.y) || !reader.Number(vb.z) || !reader.Number(vb.w)) return false;
+    } else {
+        std::string width = FindAttribute(tag, "width");
+        std::string height = FindAttribute(tag, "height");
+        if (width.empty() || height.empty()) return false;
+        out.viewBox = glm::vec4(0.0f, 0.0f, std::strtof(width.c_str(), nullptr), std::strtof(height.c_str(), nullptr));
+    }
+    if (out.viewBox.z <= 0.0f || out.viewBox.w <= 0.0f) return false;
+
+    size_t pos = svgTag;
+    while ((pos = svg.find("<path", pos)) != std::string::npos) {
+        size_t end = svg.find('>', pos);
+        if (end == std::string::npos) return false;
+        tag = svg.substr(pos, end - pos);
+        pos = end;
+
+        Path path;
+        if (!ParsePathData(FindAttribute(tag, "d"), path)) return false;
+        if (!ParseColour(FindAttribute(tag, "fill"), path.fill)) return false;
+        path.evenOdd = FindAttribute(tag, "fill-rule") == "evenodd";
+        if (!path.ops.empty() && path.fill.a > 0.0f) {
+            out.paths.push_back(std::move(path));
+        }
+    }
+    return !out.paths.empty();
+}
+
+
+// ---------------------------------------------------------------------------
+// Rasterisation
+// ---------------------------------------------------------------------------
+
+// Vertical samples per pixel row. Horizontal coverage is computed exactly per sample row.
+static constexpr int kSubSamples = 5;
+// Maximum distance in pixels between a curve and its flattened polyline.
+static constexpr float kFlatnessTolerance = 0.2f;
+
+struct Edge {
+    glm::vec2 a;
+    glm::vec2 b;
+    int winding;   // +1 for downward edges, -1 for upward ones.
+};
+
+
+static void AddEdge(std::vector<Edge>& edges, glm::vec2 a, glm::vec2 b) {
+    if (a.y == b.y) return;   // Horizontal edges never cross a scanline.
+    if (a.y < b.y) edges.push_back({ a, b, 1 });
+    else edges.push_back({ b, a, -1 });
+}
+
+
+static void FlattenPath(const VectorOutline::Path& path, glm::vec2 scale, glm::vec2 offset, std::vector<Edge>& edges) {
+    using Op = VectorOutline::Op;
+    auto map = [&](glm::vec2 p) { return (p + offset) * scale; };
+
+    glm::vec2 current(0.0f), start(0.0f);
+    bool open = false;
+    size_t pi = 0;
+
+    for (Op op : path.ops) {
+        switch (op) {
+        case Op::Move:
+            if (open) AddEdge(edges, current, start);   // Fills implicitly close every subpath.
+            current = start = map(path.points[pi++]);
+            open = true;
+            break;
+        case Op::Line: {
+            glm::vec2 p = map(path.points[pi++]);
+            AddEdge(edges, current, p);
+            current = p;
+            break;
+        }
+        case Op::Quad: {
+            glm::vec2 c = map(path.points[pi]);
+            glm::vec2 p = map(path.points[pi + 1]);
+            pi += 2;
+            float dd = glm::length(current - 2.0f * c + p);
+            int n = std::clamp(static_cast<int>(std::ceil(std::sqrt(dd / (8.0f * kFlatnessTolerance)))), 1, 100);
+            glm::vec2 prev = current;
+            for (int i = 1; i <= n; ++i) {
+                float t = static_cast<float>(i) / n, u = 1.0f - t;
+                glm::vec2 q = u * u * current + 2.0f * u * t * c + t * t * p;
+                AddEdge(edges, prev, q);
+                prev = q;
+            }
+            current = p;
+            break;
+        }
+        case Op::Cubic: {
+            glm::vec2 c1 = map(path.points[pi]);
+            glm::vec2 c2 = map(path.points[pi + 1]);
+            glm::vec2 p = map(path.points[pi + 2]);
+            pi += 3;
+            float dd = std::max(glm::length(current - 2.0f * c1 + c2), glm::length(c1 - 2.0f * c2 + p));
+            int n = std::clamp(static_cast<int>(std::ceil(std::sqrt(3.0f * dd / (4.0f * kFlatnessTolerance)))), 1, 100);
+            glm::vec2 prev = current;
+            for (int i = 1; i <= n; ++i) {
+                float t = static_cast<float>(i) / n, u = 1.0f - t;
+                glm::vec2 q = u * u * u * current + 3.0f * u * u * t * c1 + 3.0f * u * t * t * c2 + t * t * t * p;
+                AddEdge(edges, prev, q);
+                prev = q;
+            }
+            current = p;
+            break;
+        }
+        case Op::Close:
+            AddEdge(edges, current, start);
+            current = start;
+            open = false;
+            break;
+        }
+    }
+    if (open) AddEdge(edges, current, start);
+}
+
+
+// Adds `weight` times the covered fraction of each pixel in [xa, xb) to row.
+static void AddSpan(float* row, int width, float xa, float xb, float weight) {
+    xa = std::max(xa, 0.0f);
+    xb = std::min(xb, static_cast<float>(width));
+    if (xb <= xa) return;
+
+    int ia = static_cast<int>(xa);
+    int ib = static_cast<int>(xb);
+    if (ia == ib) {
+        row[ia] += (xb - xa) * weight;
+        return;
+    }
+    row[ia] += (ia + 1 - xa) * weight;
+    for (int i = ia + 1; i < ib; ++i) row[i] += weight;
+    if (ib < width) row[ib] += (xb - ib) * weight;
+}
+
+
+std::vector<unsigned char> VectorOutline::Rasterise(int width, int height) const {
+    std::vector<glm::vec4> image(static_cast<size_t>(width) * height, glm::vec4(0.0f));
+    std::vector<float> coverage(static_cast<size_t>(width) * height);
+    std::vector<Edge> edges;
+    std::vector<std::pair<float, int>> crossings;
+
+    glm::vec2 scale(width / viewBox.z, height / viewBox.w);
+    glm::vec2 offset(-viewBox.x, -viewBox.y);
+
+    for (const Path& path : paths) {
+        edges.clear();
+        FlattenPath(path, scale, offset, edges);
+        std::fill(coverage.begin(), coverage.end(), 0.0f);
+
+        for (int y = 0; y < height; ++y) {
+            float* row = &coverage[static_cast<size_t>(y) * width];
+            for (int s = 0; s < kSubSamples; ++s) {
+                float sy = y + (s + 0.5f) / kSubSamples;
+
+                crossings.clear();
+                for (const Edge& e : edges) {
+                    if (sy < e.a.y || sy >= e.b.y) continue;
+                    float x = e.a.x + (sy - e.a.y) * (e.b.x - e.a.x) / (e.b.y - e.a.y);
+                    crossings.emplace_back(x, e.winding);
+                }
+                std::sort(crossings.begin(), crossings.end());
+
+                int winding = 0;
+                for (size_t i = 0; i + 1 < crossings.size(); ++i) {
+                    winding += crossings[i].second;
+                    bool inside = path.evenOdd ? (winding & 1) != 0 : winding != 0;
+                    if (inside) {
+                        AddSpan(row, width, crossings[i].first, crossings[i + 1].first, 1.0f / kSubSamples);
+                    }
+                }
+            }
+        }
+
+        // Composite this path over the previous ones (straight alpha).
+        for (size_t i = 0; i < image.size(); ++i) {
+            float srcA = std::min(coverage[i], 1.0f) * path.fill.a;
+            if (srcA <= 0.0f) continue;
+            glm::vec4& dst = image[i];
+            float outA = srcA + dst.a * (1.0f - srcA);
+            glm::vec3 rgb = (glm::vec3(path.fill) * srcA + glm::vec3(dst) * dst.a * (1.0f - srcA)) / outA;
+            dst = glm::vec4(rgb, outA);
+        }
+    }
+
+    std::vector<unsigned char> pixels(image.size() * 4);
+    for (size_t i = 0; i < image.size(); ++i) {
+        for (int c = 0; c < 4; ++c) {
+            pixels[i * 4 + c] = static_cast<unsigned char>(std::lround(std::clamp(image[i][c], 0.0f, 1.0f) * 255.0f));
+        }
+    }
+    return pixels;
+}
+
+
+// ---------------------------------------------------------------------------
+// Icon atlas: worker rasterisation, shelf packing and drawing
+// ---------------------------------------------------------------------------
+
+// Shared by every live VectorIcon and destroyed with the last one, so the GL texture is
+// released while the context still exists.
+class IconAtlas
+{
+public:
+    IconAtlas();
+    ~IconAtlas();
+
+    static std::shared_ptr<IconAtlas> Acquire();
+
+    std::uint32_t Register(std::shared_ptr<const VectorOutline> outline);
+    void Unregister(std::uint32_t iconID);
+    void Draw(std::uint32_t iconID, glm::ivec2 pixelSize, glm::vec2 position, float z, glm::vec4 tint);
+    // Changes whenever what a draw shows may have, i.e. when icons are uploaded or dropped.
+    std::uint64_t Generation() const { return mGeneration.load(std::memory_order_relaxed); }
+
+private:
+    using Key = std::uint64_t;   // Icon ID (32 bits), width and height (16 bits each).
+
+    struct Entry {
+        int x, y, width, height;
+    };
+
+    struct Job {
+        Key key;
+        std::shared_ptr<const VectorOutline> outline;
+    };
+
+    struct Result {
+        Key key;
+        std::vector<unsigned char> pixels;
+    };
+
+    struct Shelf {
+        int y, height, x;
+    };
+
+    static Key MakeKey(std::uint32_t iconID, glm::ivec2 size) {
+        return (static_cast<Key>(iconID) << 32) | (static_cast<Key>(size.x) << 16) | static_cast<Key>(size.y);
+    }
+    static std::uint32_t KeyIcon(Key key) { return static_cast<std::uint32_t>(key >> 32); }
+    static glm::ivec2 KeySize(Key key) { return glm::ivec2((key >> 16) & 0xFFFF, key & 0xFFFF); }
+
+    void InitGL();
+    void WorkerMain();
+    void UploadResults();
+    bool Pack(int width, int height, Entry& entry);
+    void Clear();
+
+    static constexpr int kAtlasSize = 1024;
+    static constexpr int kPadding = 1;
+
+    std::unordered_map<std::uint32_t, std::shared_ptr<const VectorOutline>> mOutlines;
+    std::uint32_t mNextID = 1;
+
+    std::thread mWorker;
+    std::mutex mQueueMutex;
+    std::condition_variable mQueueCondVar;
+    std::deque<Job> mJobs;
+    std::deque<Result> mResults;
+    bool mStop = false;
+
+    GLuint mTextureID = 0;
+    std::unordered_map<Key, Entry> mEntries;
+    std::unordered_set<Key> mInFlight;
+    std::vector<Shelf> mShelves;
+    int mNextShelfY = 0;
+    std::atomic<std::uint64_t> mGeneration{ 0 };
+
+    Shader mShader;
+    VAO mVAO;
+    VBO mVBO;
+};
+
+
+std::shared_ptr<IconAtlas> IconAtlas::Acquire() {
+    static std::weak_ptr<IconAtlas> sAtlas;
+    std::shared_ptr<IconAtlas> atlas = sAtlas.lock();
+    if (!atlas) {
+        atlas = std::make_shared<IconAtlas>();
+        sAtlas = atlas;
+    }
+    return atlas;
+}
+
+
+// The texture and the worker thread are created on the first draw, not when icons are constructed.
+IconAtlas::IconAtlas() {
+    mShader.Set((std::string(UI_LIBRARY_RESOURCES_DIR) + "/shaders/Atlas.vert").c_str(), (std::string(UI_LIBRARY_RESOURCES_DIR) + "/shaders/Atlas.frag").c_str());
+}
+
+
+void IconAtlas::InitGL() {
+    mVAO.Bind();
+    mVAO.LinkAttrib(mVBO, 0, 4, GL_FLOAT, 4 * sizeof(float), (void*)0);
+    mVAO.Unbind();
+
+    glGenTextures(1, &mTextureID);
+    glBindTexture(GL_TEXTURE_2D, mTextureID);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, kAtlasSize, kAtlasSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    // Quads are pixel aligned at their raster size, so linear filtering only blends when a
+    // fallback size is drawn stretched while the exact size is still being rasterised.
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    mWorker = std::thread(&IconAtlas::WorkerMain, this);
+}
+
+
+IconAtlas::~IconAtlas() {
+    {
+        std::lock_guard<std::mutex> lock(mQueueMutex);
+        mStop = true;
+    }
+    mQueueCondVar.notify_all();
+    if (mWorker.joinable()) {
+        mWorker.join();
+    }
+    if (mTextureID != 0) {
+        GLuint id = mTextureID;
+        RenderThread::RunOnGLThread([id] { glDeleteTextures(1, &id); });
+    }
+}
+
+
+// UI thread. IDs are never reused, so draws still queued for an unregistered icon are harmless.
+std::uint32_t IconAtlas::Register(std::shared_ptr<const VectorOutline> outline) {
+    std::uint32_t iconID = mNextID++;
+    std::lock_guard<std::mutex> lock(mQueueMutex);
+    mOutlines[iconID] = std::move(outline);
+    return iconID;
+}
+
+
+// The icon's atlas space is reclaimed the next time the atlas is cleared.
+void IconAtlas::Unregister(std::uint32_t iconID) {
+    std::lock_guard<std::mutex> lock(mQueueMutex);
+    mOutlines.erase(iconID);
+}
+
+
+void IconAtlas::WorkerMain() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mQueueMutex);
+            mQueueCondVar.wait(lock, [this]() { return mStop || !mJobs.empty(); });
+            if (mStop) return;
+            job = std::move(mJobs.front());
+            mJobs.pop_front();
+        }
+
+        glm::ivec2 size = KeySize(job.key);
+        Result result{ job.key, {} };
+        {
+            StartupTrace::ScopedPhase phase("icons");
+            result.pixels = job.outline->Rasterise(size.x, size.y);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mQueueMutex);
+            mResults.push_back(std::move(result));
+        }
+        UI::PostInvalidate();
+    }
+}
+
+
+// Drops every packed icon. They are rasterised again on their next draw.
+void IconAtlas::Clear() {
+    mEntries.clear();
+    mShelves.clear();
+    mNextShelfY = 0;
+}
+
+
+bool IconAtlas::Pack(int width, int height, Entry& entry) {
+    int paddedW = width + kPadding;
+    int paddedH = height + kPadding;
+    if (paddedW > kAtlasSize || paddedH > kAtlasSize) return false;
+
+    // Best-fitting existing shelf, allowing some wasted height to limit shelf count.
+    Shelf* best = nullptr;
+    for (Shelf& shelf : mShelves) {
+        if (shelf.height >= paddedH && shelf.height <= paddedH + paddedH / 2 && shelf.x + paddedW <= kAtlasSize) {
+            if (!best || shelf.height < best->height) best = &shelf;
+        }
+    }
+    if (!best) {
+        if (mNextShelfY + paddedH > kAtlasSize) return false;
+        mShelves.push_back({ mNextShelfY, paddedH, 0 });
+        mNextShelfY += paddedH;
+        best = &mShelves.back();
+    }
+
+    entry = { best->x, best->y, width, height };
+    best->x += paddedW;
+    return true;
+}
+
+
+void IconAtlas::UploadResults() {
+    std::deque<Result> results;
+    {
+        std::lock_guard<std::mutex> lock(mQueueMutex);
+        results.swap(mResults);
+    }
+
+    for (Result& result : results) {
+        mInFlight.erase(result.key);
+        {
+            std::lock_guard<std::mutex> lock(mQueueMutex);
+            if (mOutlines.find(KeyIcon(result.key)) == mOutlines.end()) continue;   // Icon destroyed meanwhile.
+        }
+
+        glm::ivec2 size = KeySize(result.key);
+        Entry entry;
+        if (!Pack(size.x, size.y, entry)) {
+            // Full: start over. Icons that are still on screen get re-requested as they draw.
+            Clear();
+            if (!Pack(size.x, size.y, entry)) {
+                std::cerr << "Icon of " << size.x << "x" << size.y << " does not fit in the icon atlas" << std::endl;
+                continue;
+            }
+        }
+
+        glBindTexture(GL_TEXTURE_2D, mTextureID);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, entry.x, entry.y, entry.width, entry.height, GL_RGBA, GL_UNSIGNED_BYTE, result.pixels.data());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        mEntries[result.key] = entry;
+    }
+
+    // Icons drawn before the upload showed a stretched size or nothing; draw them again.
+    if (!results.empty()) {
+        mGeneration.fetch_add(1, std::memory_order_relaxed);
+        UI::PostInvalidate();
+    }
+}
+
+
+void IconAtlas::Draw(std::uint32_t iconID, glm::ivec2 pixelSize, glm::vec2 position, float z, glm::vec4 tint) {
+    if (mTextureID == 0) {
+        InitGL();
+    }
+    UploadResults();
+
+    Key key = MakeKey(iconID, pixelSize);
+    auto found = mEntries.find(key);
+    if (found == mEntries.end()) {
+        bool queued = false;
+        if (!mInFlight.count(key)) {
+            std::lock_guard<std::mutex> lock(mQueueMutex);
+            auto outline = mOutlines.find(iconID);
+            if (outline != mOutlines.end()) {
+                mJobs.push_back({ key, outline->second });
+                mInFlight.insert(key);
+                queued = true;
+            }
+        }
+        if (queued) {
+            mQueueCondVar.notify_one();
+        }
+
+        // Until the exact size arrives, stretch the largest size of this icon already packed.
+        for (auto it = mEntries.begin(); it != mEntries.end(); ++it) {
+            if (KeyIcon(it->first) != iconID) continue;
+            if (found == mEntries.end() || it->second.width * it->second.height > found->second.width * found->second.height) {
+                found = it;
+            }
+        }
+        if (found == mEntries.end()) return;
+    }
+
+    const Entry& e = found->second;
+    float x0 = position.x, y0 = position.y;
+    float x1 = x0 + pixelSize.x, y1 = y0 + pixelSize.y;
+    float u0 = static_cast<float>(e.x) / kAtlasSize, v0 = static_cast<float>(e.y) / kAtlasSize;
+    float u1 = static_cast<float>(e.x + e.width) / kAtlasSize, v1 = static_cast<float>(e.y + e.height) / kAtlasSize;
+    std::vector<GLfloat> vertices = {
+        x0, y1, u0, v1,
+        x1, y0, u1, v0,
+        x0, y0, u0, v0,
+
+        x0, y1, u0, v1,
+        x1, y1, u1, v1,
+        x1, y0, u1, v0
+    };
+    mVBO.Data(vertices);
+
+    int wWidth = 0;
+    int wHeight = 0;
+    DrawList::GetTargetSize(wWidth, wHeight);
+    glm::mat4 projection = glm::ortho(0.0f, static_cast<float>(wWidth), static_cast<float>(wHeight), 0.0f, -1.0f, 1.0f);
+
+    mShader.Bind();
+    mShader.SetInteger("image", 0);
+    mShader.SetMatrix4("projection", projection);
+    mShader.SetFloat("z", z);
+    mShader.SetVector4f("tint", tint);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, mTextureID);
+    mVAO.Bind();
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    mVAO.Unbind();
+    glBindTexture(GL_TEXTURE_2D, 0);
+    mShader.Unbind();
+}
+
+
+// ---------------------------------------------------------------------------
+// VectorIcon
+// ---------------------------------------------------------------------------
+VectorIcon::VectorIcon(const std::filesystem::path& svgFile) : mAtlas(IconAtlas::Acquire()), mIconID(0) {
+    Resource svg = Resources::Load(svgFile);
+    auto outline = std::make_shared<VectorOutline>();
+    if (!svg || !VectorOutline::ParseSvg(svg.String(), *outline)) {
+        std::cerr << "Could not open or parse the SVG icon: " << svgFile.string() << std::endl;
+        return;
+    }
+    mOutline = outline;
+    mIconID = mAtlas->Register(mOutline);
+    mValid = true;
+}
+
+
+VectorIcon::~VectorIcon() {
+    if (mValid) {
+        mAtlas->Unregister(mIconID);
+    }
+}
+
+
+void VectorIcon::DrawSprite(glm::vec2 position, glm::vec2 desiredSize, float z, glm::vec3 color) {
+    if (!mValid || desiredSize.x < 1.0f || desiredSize.y < 1.0f) return;
+
+    // Fit the viewBox inside the desired size and snap to whole pixels so the raster is 1:1.
+    const glm::vec4& vb = mOutline->viewBox;
+    float scale = std::min(desiredSize.x / vb.z, desiredSize.y / vb.w);
+    glm::ivec2 pixelSize(std::max(1, static_cast<int>(std::lround(vb.z * scale))),
+                         std::max(1, static_cast<int>(std::lround(vb.w * scale))));
+    pixelSize = glm::min(pixelSize, glm::ivec2(0xFFFF));
+    mFitSize = glm::vec2(pixelSize);
+
+    glm::vec2 topLeft = glm::floor(position + (desiredSize - mFitSize) / 2.0f + 0.5f);
+    glm::vec4 tint(color, 1.0f);
+
+    if (DrawList::Current()) {
+        // Rasterising into the atlas needs GL, so the atlas draw waits for submission. It keeps
+        // the atlas alive and does not touch this icon, so the icon may go before it runs.
+        std::shared_ptr<IconAtlas> atlas = mAtlas;
+        std::uint32_t iconID = mIconID;
+        DrawList::Hasher key;
+        key.Add(atlas.get()).Add(iconID).Add(pixelSize).Add(topLeft).Add(z).Add(tint).Add(atlas->Generation());
+        DrawList::DeferGL([atlas, iconID, pixelSize, topLeft, z, tint] { atlas->Draw(iconID, pixelSize, topLeft, z, tint); },
+                          DrawList::Rect::Covering(position, desiredSize), key.Value());
+        return;
+    }
+    mAtlas->Draw(mIconID, pixelSize, topLeft, z, tint);
+}
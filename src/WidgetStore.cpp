@@ -0,0 +1,94 @@
+// Copyright (c) 2025 Thomas Groom
+
+
+#include "ui_library/WidgetStore.h"
+#include "ui_library/Utils.h"
+
+
+std::uint32_t WidgetStore::Add(MouseHandler* owner, const Boundary& bounds, float z, int layer, std::uint32_t stateId, std::uint8_t flags) {
+    std::uint32_t row = static_cast<std::uint32_t>(mOwner.size());
+    mLeft.push_back(bounds.x);
+    mTop.push_back(bounds.y);
+    mRight.push_back(bounds.x + bounds.width);
+    mBottom.push_back(bounds.y + bounds.height);
+    mZ.push_back(z);
+    mLayer.push_back(layer);
+    mFlags.push_back(static_cast<std::uint8_t>(flags | ALIVE));
+    mStateId.push_back(stateId);
+    mOwner.push_back(owner);
+    return row;
+}
+
+
+void WidgetStore::Update(std::uint32_t row, const Boundary& bounds, float z, int layer) {
+    mLeft[row] = bounds.x;
+    mTop[row] = bounds.y;
+    mRight[row] = bounds.x + bounds.width;
+    mBottom[row] = bounds.y + bounds.height;
+    mZ[row] = z;
+    mLayer[row] = layer;
+}
+
+
+void WidgetStore::Kill(std::uint32_t row) {
+    mFlags[row] &= static_cast<std::uint8_t>(~ALIVE);
+    mOwner[row] = nullptr;
+}
+
+
+void WidgetStore::Clear() {
+    mLeft.clear();
+    mTop.clear();
+    mRight.clear();
+    mBottom.clear();
+    mZ.clear();
+    mLayer.clear();
+    mFlags.clear();
+    mStateId.clear();
+    mOwner.clear();
+}
+
+
+void WidgetStore::Reserve(std::size_t count) {
+    mLeft.reserve(count);
+    mTop.reserve(count);
+    mRight.reserve(count);
+    mBottom.reserve(count);
+    mZ.reserve(count);
+    mLayer.reserve(count);
+    mFlags.reserve(count);
+    mStateId.reserve(count);
+    mOwner.reserve(count);
+}
+
+
+bool WidgetStore::SameRow(std::uint32_t row, const WidgetStore& other) const {
+    return row < other.Size() && mStateId[row] == other.mStateId[row] && mFlags[row] == other.mFlags[row]
+        && mLeft[row] == other.mLeft[row] && mTop[row] == other.mTop[row] && mRight[row] == other.mRight[row]
+        && mBottom[row] == other.mBottom[row] && mZ[row] == other.mZ[row] && mLayer[row] == other.mLayer[row];
+}
+
+
+void WidgetStore::HitTest(int px, int py, std::vector<std::uint32_t>& out) const {
+    const std::size_t count = Size();
+    std::size_t base = out.size();
+    out.resize(base + count);
+    std::uint32_t* dst = out.data() + base;
+
+    const std::int32_t* left = mLeft.data();
+    const std::int32_t* top = mTop.data();
+    const std::int32_t* right = mRight.data();
+    const std::int32_t* bottom = mBottom.data();
+    const std::uint8_t* flags = mFlags.data();
+
+    // Write every row index and advance only past the hits (stream compaction).
+    std::size_t hits = 0;
+    for (std::size_t i = 0; i < count; i++) {
+        std::uint32_t inside = static_cast<std::uint32_t>(px > left[i]) & static_cast<std::uint32_t>(px < right[i])
+                             & static_cast<std::uint32_t>(py > top[i]) & static_cast<std::uint32_t>(py < bottom[i])
+                             & static_cast<std::uint32_t>(flags[i] & ALIVE);
+        dst[hits] = static_cast<std::uint32_t>(i);
+        hits += inside;
+    }
+    out.resize(base + hits);
+}
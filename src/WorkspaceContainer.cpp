@@ -2,6 +2,11 @@
 
 
 #include "ui_library/WorkspaceContainer.h"
+#include "ui_library/JobSystem.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
 
 /*
 	[ ] TODO: Switching between button sprites for different workspaces
@@ -19,6 +24,21 @@
 // ---------------------------------------------------------------------------
 std::unordered_map<int, WorkspaceContainer::WorkspaceRegistration> WorkspaceContainer::sWorkspaceRegistrations;
 std::map<std::string, std::shared_ptr<Button>> WorkspaceContainer::Buttons;
+bool WorkspaceContainer::sParallelRecording = false;
+double WorkspaceContainer::sFrameBudget = 0.0;
+std::uint64_t WorkspaceContainer::sLayoutGeneration = 1;
+std::uint64_t WorkspaceContainer::sTreeGeneration = 1;
+
+std::shared_ptr<Text> WorkspaceContainer::SharedText() {
+    // Held by the containers, so it goes when the last one does.
+    static std::weak_ptr<Text> shared;
+    std::shared_ptr<Text> text = shared.lock();
+    if (!text) {
+        text = std::make_shared<Text>(std::string(UI_LIBRARY_RESOURCES_DIR) + "/fonts/arial.ttf", 12);
+        shared = text;
+    }
+    return text;
+}
 
 // ---------------------------------------------------------------------------
 // Static registration functions
@@ -55,9 +75,13 @@ const std::map<std::string, std::shared_ptr<Button>>& WorkspaceContainer::GetBut
 // ---------------------------------------------------------------------------
 WorkspaceContainer::WorkspaceContainer(UI* _ui, Bounds _b, const ModelMap& models)
     : mUI(_ui), models(models), boundingBox(_b), mWindow(nullptr),
-      isLeaf(true), isResizing(false), splitRatio(0.5), type(true), // default: horizontal split
+      isLeaf(true), type(true), // default: horizontal split
       mContainer(0, 0, 1, 1)
 {
+}
+
+void WorkspaceContainer::CreateSelector() {
+    if (WS_Selector_Button) return;
     // Build a list of buttons for the dropdown from the registered workspace prototypes.
     std::vector<std::shared_ptr<Button>> childButtons;
     for (const auto& entry : sWorkspaceRegistrations) {
@@ -80,7 +104,7 @@ WorkspaceContainer::WorkspaceContainer(UI* _ui, Bounds _b, const ModelMap& model
     }
 
     WS_Selector_Button = new DropdownButton(mUI, UIText, L"", Text::CENTER_MIDDLE, {0, 0, 30, 20}, 5, 0.7f);
-    fileNewIcon = std::make_shared<Texture2D>(GL_RGBA, GL_RGBA, std::filesystem::path(std::string(UI_LIBRARY_RESOURCES_DIR) + "/icons/file_new.png"), glm::vec2(20));
+    fileNewIcon = std::make_shared<VectorIcon>(std::filesystem::path(std::string(UI_LIBRARY_RESOURCES_DIR) + "/icons/file_new.svg"));
     WS_Selector_Button->setIcon(fileNewIcon);
     WS_Selector_Button->SetChildButtons(childButtons);
     WS_Selector_Button->SetChildWidth(140);
@@ -88,8 +112,7 @@ WorkspaceContainer::WorkspaceContainer(UI* _ui, Bounds _b, const ModelMap& model
 
 
 WorkspaceContainer::~WorkspaceContainer() {
-    A.reset();
-    B.reset();
+    mChildren.clear();
     LeafWorkspace.reset();
     delete WS_Selector_Button;
 }
@@ -99,84 +122,557 @@ WorkspaceContainer::~WorkspaceContainer() {
 // Workspace selection and splitting
 // ---------------------------------------------------------------------------
 void WorkspaceContainer::setWorkspace(int workspaceType) {
-    mWorkspaceType = workspaceType;
-    // Look up the workspace registration by type.
-    auto it = sWorkspaceRegistrations.find(workspaceType);
-    if(it != sWorkspaceRegistrations.end()) {
-        // Create the workspace using the registered factory.
-        LeafWorkspace = it->second.factory(mUI, &mContainer, models);
-    } else {
+    if (sWorkspaceRegistrations.find(workspaceType) == sWorkspaceRegistrations.end()) {
         printf("Invalid workspace type.");
         throw std::invalid_argument("Invalid workspace type.");
     }
+    mWorkspaceType = workspaceType;
+    LeafWorkspace.reset();
+    mPendingState.clear();
+    mLayer.Invalidate();
+    UI::PostInvalidate();
+}
+
+void WorkspaceContainer::CreateWorkspace() {
+    // Look up the workspace registration by type.
+    auto it = sWorkspaceRegistrations.find(mWorkspaceType);
+    if (it == sWorkspaceRegistrations.end()) return;
+    // Create the workspace using the registered factory.
+    LeafWorkspace = it->second.factory(mUI, &mContainer, models);
+    if (LeafWorkspace && !mPendingState.empty()) {
+        LeafWorkspace->LoadState(mPendingState);
+    }
+    std::vector<std::uint8_t>().swap(mPendingState);
+    mLayer.Invalidate();
 }
 
 void WorkspaceContainer::split(bool _type, double _split) {
+    split(_type, std::vector<double>{ _split });
+}
+
+void WorkspaceContainer::split(bool _type, const std::vector<double>& fractions) {
     type = _type;
-    splitRatio = _split;
     if (LeafWorkspace) LeafWorkspace.reset(nullptr);
+    mPendingState.clear();
+    delete WS_Selector_Button;
+    WS_Selector_Button = nullptr;
     isLeaf = false;
-    
-    // Calculate new bounds for child containers.
-    Bounds a = boundingBox, b = boundingBox;
-    if (_type == true) { // Horizontal split
-        a.E = boundingBox.W + _split * (boundingBox.E - boundingBox.W);
-        b.W = a.E;
-    } else {             // Vertical split
-        a.S = boundingBox.N + _split * (boundingBox.S - boundingBox.N);
-        b.N = a.S;
+
+    // Split positions are kept relative to the window, so moving an outer split leaves the
+    // inner ones where they are.
+    double start = _type ? boundingBox.W : boundingBox.N;
+    double end = _type ? boundingBox.E : boundingBox.S;
+    mSplits.clear();
+    for (double fraction : fractions) {
+        mSplits.push_back(start + glm::clamp(fraction, 0.0, 1.0) * (end - start));
     }
-    
-    // Create child containers, passing the same model registry.
-    A = std::make_unique<WorkspaceContainer>(mUI, a, models);
-    B = std::make_unique<WorkspaceContainer>(mUI, b, models);
+    std::sort(mSplits.begin(), mSplits.end());
+
+    // Create child containers, passing the same model registry and the same workspace type.
+    mChildren.clear();
+    for (std::size_t i = 0; i <= mSplits.size(); i++) {
+        mChildren.push_back(std::make_unique<WorkspaceContainer>(mUI, boundingBox, models));
+        mChildren.back()->mParent = this;
+        mChildren.back()->mLayerCached = mLayerCached;
+        mChildren.back()->mOccluded = mOccluded;
+    }
+    ApplyBounds();
+    for (auto& child : mChildren) {
+        child->mWorkspaceType = mWorkspaceType;
+    }
+    InvalidateExtentsUp();
+    sLayoutGeneration++;
+    sTreeGeneration++;
+}
+
+void WorkspaceContainer::SetLayerCached(bool cached) {
+    mLayerCached = cached;
+    mLayer.Invalidate();
+    for (auto& child : mChildren) child->SetLayerCached(cached);
+}
 
-    // Optionally, set the same workspace type for the children.
-    A->setWorkspace(mWorkspaceType);
-    B->setWorkspace(mWorkspaceType);
+void WorkspaceContainer::InvalidateLayers() {
+    mLayer.Invalidate();
+    for (auto& child : mChildren) child->InvalidateLayers();
+    UI::PostInvalidate();
+}
+
+void WorkspaceContainer::SetOccluded(bool occluded) {
+    mOccluded = occluded;
+    for (auto& child : mChildren) child->SetOccluded(occluded);
+    UI::PostInvalidate();
+}
+
+// ---------------------------------------------------------------------------
+// Layout snapshots
+// ---------------------------------------------------------------------------
+// Little-endian throughout:
+//   header:  "UIWL", u16 version
+//   leaf:    u8 0, i32 workspace type, u32 state size, state bytes
+//   split:   u8 1, u8 type, u32 split count n, n f64 positions, then n + 1 child nodes
+static const char kLayoutMagic[4] = { 'U', 'I', 'W', 'L' };
+static const std::uint16_t kLayoutVersion = 1;
+static const int kMaxLayoutDepth = 64;
+
+struct WorkspaceContainer::LayoutNode {
+    bool isLeaf = true;
+    bool type = true;
+    std::vector<double> splits;
+    std::vector<LayoutNode> children;
+    int workspaceType = -1;
+    std::vector<std::uint8_t> state;
+};
+
+struct WorkspaceContainer::LayoutReader {
+    const std::uint8_t* pos;
+    const std::uint8_t* end;
+
+    std::size_t Remaining() const { return static_cast<std::size_t>(end - pos); }
+
+    bool ReadU64(std::uint64_t& value, int bytes) {
+        if (Remaining() < static_cast<std::size_t>(bytes)) return false;
+        value = 0;
+        for (int i = 0; i < bytes; i++) {
+            value |= static_cast<std::uint64_t>(pos[i]) << (8 * i);
+        }
+        pos += bytes;
+        return true;
+    }
+};
+
+static void WriteLE(std::vector<std::uint8_t>& out, std::uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        out.push_back(static_cast<std::uint8_t>(value >> (8 * i)));
+    }
+}
+
+std::vector<std::uint8_t> WorkspaceContainer::SaveLayout() const {
+    std::vector<std::uint8_t> out(kLayoutMagic, kLayoutMagic + 4);
+    WriteLE(out, kLayoutVersion, 2);
+    WriteLayout(out);
+    return out;
+}
+
+void WorkspaceContainer::WriteLayout(std::vector<std::uint8_t>& out) const {
+    if (isLeaf) {
+        std::vector<std::uint8_t> state = LeafWorkspace ? LeafWorkspace->SaveState() : mPendingState;
+        WriteLE(out, 0, 1);
+        WriteLE(out, static_cast<std::uint32_t>(mWorkspaceType), 4);
+        WriteLE(out, state.size(), 4);
+        out.insert(out.end(), state.begin(), state.end());
+        return;
+    }
+    WriteLE(out, 1, 1);
+    WriteLE(out, type ? 1 : 0, 1);
+    WriteLE(out, mSplits.size(), 4);
+    for (double split : mSplits) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &split, sizeof(bits));
+        WriteLE(out, bits, 8);
+    }
+    for (const auto& child : mChildren) {
+        child->WriteLayout(out);
+    }
+}
+
+bool WorkspaceContainer::ReadLayout(LayoutReader& reader, LayoutNode& node, int depth) {
+    std::uint64_t kind = 0;
+    if (depth > kMaxLayoutDepth || !reader.ReadU64(kind, 1)) return false;
+    if (kind == 0) {
+        std::uint64_t workspaceType = 0;
+        std::uint64_t size = 0;
+        if (!reader.ReadU64(workspaceType, 4) || !reader.ReadU64(size, 4) || size > reader.Remaining()) return false;
+        node.isLeaf = true;
+        node.workspaceType = static_cast<std::int32_t>(static_cast<std::uint32_t>(workspaceType));
+        node.state.assign(reader.pos, reader.pos + size);
+        reader.pos += size;
+        return true;
+    }
+
+    std::uint64_t splitType = 0;
+    std::uint64_t count = 0;
+    // Each split needs 8 bytes and each child at least 1, which bounds the allocation.
+    if (kind != 1 || !reader.ReadU64(splitType, 1) || !reader.ReadU64(count, 4) ||
+        count == 0 || count * 9 + 1 > reader.Remaining()) {
+        return false;
+    }
+    node.isLeaf = false;
+    node.type = splitType != 0;
+    for (std::uint64_t i = 0; i < count; i++) {
+        std::uint64_t bits = 0;
+        reader.ReadU64(bits, 8);
+        double split;
+        std::memcpy(&split, &bits, sizeof(split));
+        if (!(split >= 0.0 && split <= 1.0) || (!node.splits.empty() && split < node.splits.back())) return false;
+        node.splits.push_back(split);
+    }
+    node.children.resize(count + 1);
+    for (LayoutNode& child : node.children) {
+        if (!ReadLayout(reader, child, depth + 1)) return false;
+    }
+    return true;
+}
+
+bool WorkspaceContainer::LoadLayout(const std::vector<std::uint8_t>& data) {
+    LayoutReader reader = { data.data(), data.data() + data.size() };
+    std::uint64_t version = 0;
+    if (data.size() < 6 || std::memcmp(data.data(), kLayoutMagic, 4) != 0) {
+        std::cerr << "Not a workspace layout" << std::endl;
+        return false;
+    }
+    reader.pos += 4;
+    reader.ReadU64(version, 2);
+    if (version > kLayoutVersion) {
+        std::cerr << "Workspace layout version " << version << " is newer than this build reads" << std::endl;
+        return false;
+    }
+
+    // Parse everything before touching the tree, so a bad snapshot changes nothing.
+    LayoutNode root;
+    if (!ReadLayout(reader, root, 0) || reader.pos != reader.end) {
+        std::cerr << "Workspace layout is malformed" << std::endl;
+        return false;
+    }
+    ApplyLayout(root);
+    InvalidateExtentsDown();
+    InvalidateExtentsUp();
+    sLayoutGeneration++;
+    sTreeGeneration++;
+    UI::PostInvalidate();
+    return true;
+}
+
+void WorkspaceContainer::ApplyLayout(const LayoutNode& node) {
+    mChildren.clear();
+    mSplits.clear();
+    LeafWorkspace.reset();
+    mPendingState.clear();
+    mLayer.Invalidate();
+    isLeaf = node.isLeaf;
+    if (node.isLeaf) {
+        // Not created until visible, as with setWorkspace; the state waits for it.
+        mWorkspaceType = node.workspaceType;
+        mPendingState = node.state;
+        return;
+    }
+
+    delete WS_Selector_Button;
+    WS_Selector_Button = nullptr;
+    type = node.type;
+    double start = type ? boundingBox.W : boundingBox.N;
+    double end = type ? boundingBox.E : boundingBox.S;
+    for (double split : node.splits) {
+        mSplits.push_back(glm::clamp(split, start, end));
+    }
+    for (std::size_t i = 0; i < node.children.size(); i++) {
+        mChildren.push_back(std::make_unique<WorkspaceContainer>(mUI, boundingBox, models));
+        mChildren.back()->mParent = this;
+        mChildren.back()->mLayerCached = mLayerCached;
+        mChildren.back()->mOccluded = mOccluded;
+    }
+    ApplyBounds();
+    for (std::size_t i = 0; i < node.children.size(); i++) {
+        mChildren[i]->ApplyLayout(node.children[i]);
+    }
+}
+
+bool WorkspaceContainer::SaveLayoutFile(const std::filesystem::path& file) const {
+    std::vector<std::uint8_t> data = SaveLayout();
+    std::ofstream out(file, std::ios::binary);
+    if (!out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()))) {
+        std::cerr << "Could not write workspace layout " << file << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool WorkspaceContainer::LoadLayoutFile(const std::filesystem::path& file) {
+    std::ifstream in(file, std::ios::binary);
+    if (!in) {
+        std::cerr << "Could not open workspace layout " << file << std::endl;
+        return false;
+    }
+    std::vector<std::uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    return LoadLayout(data);
 }
 
 // ---------------------------------------------------------------------------
 // Drawing functions
 // ---------------------------------------------------------------------------
-Bounds WorkspaceContainer::recursiveMinMaxSearch(const WorkspaceContainer& node) {
-    if (node.isLeaf) return node.boundingBox;
+const Bounds& WorkspaceContainer::Extents() {
+    if (mExtentsValid) return mExtents;
+    if (isLeaf) {
+        mExtents = boundingBox;
+    } else {
+        mExtents = mChildren.front()->Extents();
+        for (std::size_t i = 1; i < mChildren.size(); i++) {
+            const Bounds& child = mChildren[i]->Extents();
+            mExtents.W = glm::max(mExtents.W, child.W);  // Largest startX
+            mExtents.E = glm::min(mExtents.E, child.E);  // Smallest endX
+            mExtents.N = glm::max(mExtents.N, child.N);  // Largest startY
+            mExtents.S = glm::min(mExtents.S, child.S);  // Smallest endY
+        }
+    }
+    mExtentsValid = true;
+    return mExtents;
+}
 
-    Bounds a = recursiveMinMaxSearch(*node.A);
-    Bounds b = recursiveMinMaxSearch(*node.B);
+void WorkspaceContainer::InvalidateExtentsUp() {
+    for (WorkspaceContainer* node = this; node && node->mExtentsValid; node = node->mParent) {
+        node->mExtentsValid = false;
+    }
+}
 
-    return {
-        glm::max(a.W, b.W),  // Largest startX
-        glm::min(a.E, b.E),  // Smallest endX
-        glm::max(a.N, b.N),  // Largest startY
-        glm::min(a.S, b.S)   // Smallest endY
-    };
+void WorkspaceContainer::InvalidateExtentsDown() {
+    mExtentsValid = false;
+    for (auto& child : mChildren) child->InvalidateExtentsDown();
 }
 
-void WorkspaceContainer::Draw(int x, int y, int xEnd, int yEnd) {
-    mContainer.width = (xEnd - x) - 4;
-    mContainer.height = (yEnd - y) - 4;
-    mContainer.x = x + 2;
-    mContainer.y = y + 2;
-    
-    glScissor(mContainer.x, mUI->G_HEIGHT - (mContainer.y + mContainer.height), mContainer.width, mContainer.height);
+void WorkspaceContainer::ApplyBounds() {
+    for (std::size_t i = 0; i < mChildren.size(); i++) {
+        ApplyChildBounds(i);
+    }
+}
+
+void WorkspaceContainer::ApplyChildBounds(std::size_t index) {
+    Bounds bounds = boundingBox;
+    if (type) {
+        bounds.W = index == 0 ? boundingBox.W : mSplits[index - 1];
+        bounds.E = index == mSplits.size() ? boundingBox.E : mSplits[index];
+    } else {
+        bounds.N = index == 0 ? boundingBox.N : mSplits[index - 1];
+        bounds.S = index == mSplits.size() ? boundingBox.S : mSplits[index];
+    }
+    mChildren[index]->boundingBox = bounds;
+    mChildren[index]->ApplyBounds();
+}
+
+bool WorkspaceContainer::MoveSplit(std::size_t index, double position) {
+    const Bounds& before = mChildren[index]->Extents();
+    const Bounds& after = mChildren[index + 1]->Extents();
+    double minimum = 0.0;
+    double maximum = 1.0;
+    if (type) {
+        double margin = 30.0 / mUI->G_WIDTH;
+        minimum = before.W + margin;
+        maximum = after.E - margin;
+    } else {
+        double margin = 30.0 / ((mUI->G_HEIGHT - 19) - yOffset);
+        minimum = before.N + margin;
+        maximum = after.S - margin;
+    }
+    position = glm::max(glm::min(position, maximum), minimum);
+    if (position == mSplits[index]) return false;
+
+    mSplits[index] = position;
+    // Only the two children either side of the split, and the path above it, change.
+    mChildren[index]->InvalidateExtentsDown();
+    mChildren[index + 1]->InvalidateExtentsDown();
+    InvalidateExtentsUp();
+    ApplyChildBounds(index);
+    ApplyChildBounds(index + 1);
+    sLayoutGeneration++;
+    return true;
+}
+
+void WorkspaceContainer::ClampSplits() {
+    for (std::size_t i = 0; i < mSplits.size(); i++) {
+        MoveSplit(i, mSplits[i]);
+    }
+    for (auto& child : mChildren) child->ClampSplits();
+}
+
+DrawList::Rect WorkspaceContainer::LeafArea(const LeafRegion& leaf) {
+    return { leaf.x + 2, leaf.y + 2, (leaf.xEnd - leaf.x) - 4, (leaf.yEnd - leaf.y) - 4 };
+}
+
+bool WorkspaceContainer::IsLayered() const {
+    if (!LeafWorkspace) return false;
+    WorkspaceComponent::UpdatePolicy policy = LeafWorkspace->GetUpdatePolicy();
+    return mLayerCached || LeafWorkspace->IsLayerCached() ||
+           policy == WorkspaceComponent::UpdatePolicy::FIXED_RATE || policy == WorkspaceComponent::UpdatePolicy::ON_DIRTY;
+}
 
-    if (LeafWorkspace != nullptr)
-        LeafWorkspace->Draw();
+void WorkspaceContainer::Draw(const LeafRegion& leaf) {
+    DrawList::Rect area = LeafArea(leaf);
+    mContainer.width = area.width;
+    mContainer.height = area.height;
+    mContainer.x = area.x;
+    mContainer.y = area.y;
+    
+    DrawList::PushScissor(mContainer.x, mUI->G_HEIGHT - (mContainer.y + mContainer.height), mContainer.width, mContainer.height);
+
+    if (LeafWorkspace != nullptr && !leaf.hidden) {
+        auto drawWorkspace = [this] {
+            double start = glfwGetTime();
+            LeafWorkspace->Draw();
+            double cost = glfwGetTime() - start;
+            mDrawCost = mDrawCost == 0.0 ? cost : mDrawCost * 0.8 + cost * 0.2;
+        };
+        if (leaf.update && LeafWorkspace->GetUpdatePolicy() == WorkspaceComponent::UpdatePolicy::FIXED_RATE) {
+            double hz = LeafWorkspace->GetUpdateRate();
+            mNextUpdate = glfwGetTime() + (hz > 0.0 ? 1.0 / hz : 0.0);
+        }
+        if (IsLayered()) {
+            if (leaf.update) {
+                mLayer.Record(area, LeafWorkspace->LayerVersion(), drawWorkspace);
+            }
+            mLayer.Present();
+        } else if (leaf.update) {
+            drawWorkspace();
+        }
+    }
     
     #if !BRAX_EDITOR_ONLY
+    if (WS_Selector_Button) {
         WS_Selector_Button->SetPos(mContainer.x + 3, mContainer.y + 3);
         WS_Selector_Button->Draw();
+    }
     #endif
 
-    glScissor(0, 0, mUI->G_WIDTH, mUI->G_HEIGHT);
+    DrawList::PopScissor();
 }
 
 void WorkspaceContainer::DrawContainers(WorkspaceContainer& node) {
-    if (&node == nullptr) return;
+    if (!DrawList::Current()) {
+        glScissor(0, 0, mUI->G_WIDTH, mUI->G_HEIGHT);  // A render thread resets it per packet.
+    }
+
+    // Layout (and split dragging) stays on this thread, as does deciding which leaves update.
+    // The pixel layout only changes with the window size, a split or the tree.
+    if (mLayoutRoot != &node || mLayoutWidth != mUI->G_WIDTH || mLayoutHeight != mUI->G_HEIGHT) {
+        if (mLayoutRoot == &node) {
+            node.ClampSplits();  // The 30 pixel limits are a different fraction now.
+        }
+        mLayoutRoot = &node;
+        mLayoutWidth = mUI->G_WIDTH;
+        mLayoutHeight = mUI->G_HEIGHT;
+        mLayoutGeneration = 0;
+        mDragNode = nullptr;
+    }
+    // The cached splitters and leaves point into the tree, so they are rebuilt before they
+    // are used whenever anything changed; a drag moving a split rebuilds them again after.
+    RefreshLayout(node);
+    UpdateSplitDrag();
+    RefreshLayout(node);
+
+    std::vector<LeafRegion> leaves = mLeaves;
+    ScheduleLeaves(leaves);
+
+    JobSystem* jobs = JobSystem::Current();
+    if (!sParallelRecording || !jobs) {
+        for (const LeafRegion& leaf : leaves) {
+            leaf.node->Draw(leaf);
+        }
+        return;
+    }
+
+    // Only the leaves are recorded in parallel.
+    jobs->ParallelFor(leaves.size(), 1, [&leaves](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) {
+            const LeafRegion& leaf = leaves[i];
+            leaf.node->mDrawList.Clear();
+            DrawList::Recording recording(&leaf.node->mDrawList);
+            leaf.node->Draw(leaf);
+        }
+    });
+
+    std::vector<const DrawList*> lists;
+    for (const LeafRegion& leaf : leaves) {
+        lists.push_back(&leaf.node->mDrawList);
+    }
+    DrawList::Submit(lists);
+}
+
+void WorkspaceContainer::ScheduleLeaves(std::vector<LeafRegion>& leaves) {
+    using UpdatePolicy = WorkspaceComponent::UpdatePolicy;
+    const double now = glfwGetTime();
+    double spent = 0.0;                    // Estimated cost of the leaves that must draw.
+    std::vector<LeafRegion*> deferrable;   // Stale leaves that could show their last output.
+
+    for (LeafRegion& leaf : leaves) {
+        WorkspaceContainer& node = *leaf.node;
+        const DrawList::Rect area = LeafArea(leaf);
+        #if !BRAX_EDITOR_ONLY
+        node.CreateSelector();
+        #endif
+        if (!node.LeafWorkspace && !area.Empty() && !node.mOccluded) {
+            node.CreateWorkspace();
+        }
+        WorkspaceComponent* workspace = node.LeafWorkspace.get();
+        if (!workspace) continue;
+        if (workspace->ConsumeLayerDirty()) {
+            node.mLayer.Invalidate();
+        }
+
+        const UpdatePolicy policy = workspace->GetUpdatePolicy();
+        if (policy == UpdatePolicy::WHEN_VISIBLE && (area.Empty() || node.mOccluded)) {
+            leaf.hidden = true;
+            leaf.update = false;
+            continue;
+        }
+        if (!node.IsLayered()) {
+            spent += node.mDrawCost;   // No cached output to show instead.
+            continue;
+        }
+
+        const bool hasRecording = node.mLayer.HasRecording(area);
+        if (policy == UpdatePolicy::FIXED_RATE) {
+            leaf.update = now >= node.mNextUpdate || !hasRecording || node.mLayer.IsCapturing();
+            if (!leaf.update) {
+                mUI->InvalidateAt(node.mNextUpdate);
+            }
+        } else {
+            leaf.update = node.mLayer.IsStale(area, workspace->LayerVersion());
+        }
+        if (!leaf.update) continue;
+        if (!hasRecording) {
+            spent += node.mDrawCost;
+            continue;
+        }
+        deferrable.push_back(&leaf);
+    }
 
-    bool isVert = node.type;
+    if (sFrameBudget <= 0.0 || deferrable.empty()) return;
 
+    // Highest priority first; every frame a leaf waits counts as one more level, so low
+    // priorities still get their turn. The first always draws, so something makes progress.
+    auto rank = [](const LeafRegion* leaf) {
+        return leaf->node->LeafWorkspace->GetUpdatePriority() + leaf->node->mDeferredFrames;
+    };
+    std::stable_sort(deferrable.begin(), deferrable.end(), [&rank](const LeafRegion* a, const LeafRegion* b) { return rank(a) > rank(b); });
+    bool deferred = false;
+    for (std::size_t i = 0; i < deferrable.size(); i++) {
+        WorkspaceContainer& node = *deferrable[i]->node;
+        if (i == 0 || spent + node.mDrawCost <= sFrameBudget) {
+            spent += node.mDrawCost;
+            node.mDeferredFrames = 0;
+        } else {
+            deferrable[i]->update = false;
+            node.mDeferredFrames++;
+            deferred = true;
+        }
+    }
+    if (deferred) {
+        mUI->Invalidate();  // Come back for them next frame.
+    }
+}
+
+void WorkspaceContainer::RefreshLayout(WorkspaceContainer& node) {
+    if (mTreeGeneration != sTreeGeneration) {
+        // Containers may have been destroyed, the one being dragged included.
+        mTreeGeneration = sTreeGeneration;
+        mDragNode = nullptr;
+        mLayoutGeneration = 0;
+    }
+    if (mLayoutGeneration == sLayoutGeneration) return;
+    mLayoutGeneration = sLayoutGeneration;
+    mLeaves.clear();
+    mSplitters.clear();
+    LayoutContainers(node);
+}
+
+void WorkspaceContainer::LayoutContainers(WorkspaceContainer& node) {
     int scaleW = mUI->G_WIDTH;
     int scaleH = (mUI->G_HEIGHT - 19) - yOffset;
     int Ax = (node.boundingBox.W * scaleW);
@@ -185,51 +681,51 @@ void WorkspaceContainer::DrawContainers(WorkspaceContainer& node) {
     int endY = (node.boundingBox.S * scaleH) + yOffset;
 
     if (node.isLeaf) {
-        node.Draw(Ax, Ay, endX, endY);
+        mLeaves.push_back({ &node, Ax, Ay, endX, endY });
         return;
     }
 
-    int splitX = node.splitRatio * scaleW;
-    int splitY = node.splitRatio * scaleH + yOffset;
-
-    int dragMargin = 4;
-    bool isMouseNearSplit = (isVert &&
-                             mUI->G_MOUSE_X >= splitX - dragMargin && mUI->G_MOUSE_X <= splitX + dragMargin &&
-                             mUI->G_MOUSE_Y > Ay + dragMargin && mUI->G_MOUSE_Y < endY - dragMargin)
-                         || (!isVert &&
-                             mUI->G_MOUSE_X > Ax + dragMargin && mUI->G_MOUSE_X < endX - dragMargin &&
-                             mUI->G_MOUSE_Y >= splitY - dragMargin && mUI->G_MOUSE_Y <= splitY + dragMargin);
-
-    if (isMouseNearSplit) {
-        mUI->G_SET_CURSOR = isVert ? CURSOR_HRESIZE : CURSOR_VRESIZE;
-        if (mUI->G_LEFT_MOUSE_STATE == GLFW_PRESS)
-            node.isResizing = true;
+    for (std::size_t i = 0; i < node.mSplits.size(); i++) {
+        if (node.type) {
+            mSplitters.push_back({ &node, i, true, static_cast<int>(node.mSplits[i] * scaleW), Ay, endY });
+        } else {
+            mSplitters.push_back({ &node, i, false, static_cast<int>(node.mSplits[i] * scaleH + yOffset), Ax, endX });
+        }
     }
-    
-    if (mUI->G_LEFT_MOUSE_STATE == GLFW_RELEASE)
-        node.isResizing = false;
-
-    if (node.isResizing) {
-        mUI->G_SET_CURSOR = isVert ? CURSOR_HRESIZE : CURSOR_VRESIZE;
-        node.splitRatio = isVert ? mUI->G_MOUSE_X / scaleW : (mUI->G_MOUSE_Y - yOffset) / scaleH;
+    for (auto& child : node.mChildren) {
+        LayoutContainers(*child);
     }
+}
 
-    if (mUI->G_RESIZE_FLAG || node.isResizing) {
-        Bounds a = recursiveMinMaxSearch(*node.A);
-        Bounds b = recursiveMinMaxSearch(*node.B);
-        if (isVert)
-            node.splitRatio = glm::clamp(node.splitRatio, a.W + 30.0f / scaleW, b.E - 30.0f / scaleW);
-        else
-            node.splitRatio = glm::clamp(node.splitRatio, a.N + 30.0f / scaleH, b.S - 30.0f / scaleH);
+void WorkspaceContainer::UpdateSplitDrag() {
+    if (mUI->G_LEFT_MOUSE_STATE == GLFW_RELEASE) {
+        mDragNode = nullptr;
     }
 
-    node.A->boundingBox = {node.boundingBox.W, isVert ? node.splitRatio : node.boundingBox.E,
-                           node.boundingBox.N, isVert ? node.boundingBox.S : node.splitRatio};
-    node.B->boundingBox = {isVert ? node.splitRatio : node.boundingBox.W, node.boundingBox.E,
-                           isVert ? node.boundingBox.N : node.splitRatio, node.boundingBox.S};
+    if (!mDragNode) {
+        const int dragMargin = 4;
+        for (const Splitter& splitter : mSplitters) {
+            double along = splitter.vertical ? mUI->G_MOUSE_Y : mUI->G_MOUSE_X;
+            double across = splitter.vertical ? mUI->G_MOUSE_X : mUI->G_MOUSE_Y;
+            if (across < splitter.position - dragMargin || across > splitter.position + dragMargin ||
+                along <= splitter.from + dragMargin || along >= splitter.to - dragMargin) {
+                continue;
+            }
+            mUI->G_SET_CURSOR = splitter.vertical ? CURSOR_HRESIZE : CURSOR_VRESIZE;
+            if (mUI->G_LEFT_MOUSE_STATE == GLFW_PRESS) {
+                mDragNode = splitter.node;
+                mDragIndex = splitter.index;
+            }
+            break;
+        }
+    }
 
-    node.DrawContainers(*node.A);
-    node.DrawContainers(*node.B);
+    if (mDragNode) {
+        mUI->G_SET_CURSOR = mDragNode->type ? CURSOR_HRESIZE : CURSOR_VRESIZE;
+        double position = mDragNode->type ? mUI->G_MOUSE_X / mUI->G_WIDTH
+                                          : (mUI->G_MOUSE_Y - yOffset) / ((mUI->G_HEIGHT - 19) - yOffset);
+        mDragNode->MoveSplit(mDragIndex, position);
+    }
 }
 
 